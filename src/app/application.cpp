@@ -1,5 +1,7 @@
 #include "application.h"
 
+#include <set>
+
 void Application::begin() {
     D_PRINT("Starting application...");
 
@@ -8,6 +10,10 @@ void Application::begin() {
     }
 
     _bootstrap = std::make_unique<Bootstrap<Config, PacketType>>(&LittleFS);
+    _config_revision.boot_id = esp_random();
+
+    // Settings are replayed before anything reads them: Wi-Fi, MQTT and axis pins are taken from config below
+    _load_config();
 
     auto &sys_config = _bootstrap->config().sys_config;
     _bootstrap->begin({
@@ -16,15 +22,32 @@ void Application::begin() {
         .wifi_ssid = sys_config.wifi_ssid,
         .wifi_password = sys_config.wifi_password,
         .wifi_connection_timeout = sys_config.wifi_max_connection_attempt_interval,
-        .mqtt_enabled = sys_config.mqtt,
+        .mqtt_enabled = false, // Handled by MqttClient
         .mqtt_host = sys_config.mqtt_host,
         .mqtt_port = sys_config.mqtt_port,
         .mqtt_user = sys_config.mqtt_user,
         .mqtt_password = sys_config.mqtt_password,
     });
 
+    if (sys_config.mqtt) {
+        _mqtt.begin({
+            .client_id = sys_config.mdns_name,
+            .host = sys_config.mqtt_host,
+            .port = sys_config.mqtt_port,
+            .user = sys_config.mqtt_user,
+            .password = sys_config.mqtt_password,
+        }, [this] { _idle_manager.activity(); });
+    }
+
+    _timer.begin();
+
     _ntp_time = std::make_unique<NtpTime>();
-    _night_mode_manager = std::make_unique<NightModeManager>(*_ntp_time, _bootstrap->timer(), _bootstrap->config());
+    _night_mode_manager = std::make_unique<NightModeManager>(*_ntp_time, _timer, _bootstrap->config());
+
+    _group_sync = std::make_unique<GroupSync>(_timer, _bootstrap->config().group_sync, [this](float position) {
+        auto &main_axis = axis();
+        main_axis.homing_if_needed().then<void>([&main_axis, position](auto &) { main_axis.move_to(position); });
+    });
 
     _night_mode_manager->event_night_mode().subscribe(this, [this](auto sender, auto state, auto arg) {
         _night_mode_state_changed(sender, state, arg);
@@ -34,62 +57,82 @@ void Application::begin() {
         _bootstrap_state_changed(sender, state, arg);
     });
 
-    _bootstrap->timer().add_interval([this](auto) { _notify_periodic_status(); }, APP_STATE_NOTIFICATION_INTERVAL);
-    _bootstrap->timer().add_interval([this](auto) { _move_notification_loop(); }, APP_STATE_MOVE_NOTIFICATION_INTERVAL);
+    _profiler.begin();
+
+    _timer.add_interval([this](auto) {
+        ProfileScope scope(_profiler, ProfileSection::PERIODIC_STATUS);
+        _notify_periodic_status();
+    }, APP_STATE_NOTIFICATION_INTERVAL);
+
+    _timer.add_interval([this](auto) {
+        ProfileScope scope(_profiler, ProfileSection::MOVE_NOTIFICATION);
+        _move_notification_loop();
+    }, APP_STATE_MOVE_NOTIFICATION_INTERVAL);
+
+    _timer.add_interval([this](auto) {
+        _profiler.snapshot(_step_scheduler.timing(), _idle_manager.stats());
+    }, PROFILE_SNAPSHOT_INTERVAL);
 
     _bootstrap->event_state_changed().subscribe(this, BootstrapState::READY, [this](auto, auto, auto) {
         _on_bootstrap_ready();
     });
 
-    auto &stepper_cfg = config().stepper_config;
-    _stepper = std::make_unique<GStepper2<STEPPER_TYPE>>(
-        (uint16_t) stepper_cfg.resolution,
-        sys_config.stepper_pin_1,
-        sys_config.stepper_pin_2,
-        sys_config.stepper_pin_3,
-        sys_config.stepper_pin_4,
-        sys_config.stepper_pin_en
-    );
+    for (uint8_t i = 0; i < AXIS_COUNT; ++i) {
+        _axes[i] = std::make_unique<ShadeAxis>(i, _timer, config().axes[i], sys_config.axis_pins[i],
+                                               [this](bool immediate) { update(immediate); });
 
-    _stepper->disable(); // Make sure stepper pins are disabled
+        _axes[i]->begin();
+        _step_scheduler.add(&_axes[i]->stepper());
 
-    _stepper->setAcceleration(stepper_cfg.acceleration);
-    _stepper->reverse(stepper_cfg.reverse);
-    _stepper->autoPower(true);
-
-    _endstop = std::make_unique<Button>(sys_config.endstop_pin, sys_config.endstop_high_state);
-    _endstop->set_hold_repeat(false);
-    _endstop->set_on_hold([this](auto) { endstop_triggered(); });
-    _endstop->set_on_hold_release([this](auto) { endstop_release(); });
+        _sequence_runners[i] = std::make_unique<SequenceRunner>(_timer, *_ntp_time, *_axes[i]);
+        _update_wake_pin(*_axes[i]);
+    }
 
-    _bootstrap->timer().add_interval([this](auto) { _service_loop(); }, APP_SERVICE_LOOP_INTERVAL);
+    _idle_manager.begin();
+    _start_service_loop();
 
     _setup();
-    change_state(AppState::INITIALIZATION);
 }
 
 void Application::_setup() {
     NotificationBus::get().subscribe([this](auto sender, auto param) {
-        if (sender != this) _handle_property_change(param);
+        Metrics::get().notifications++;
+        _mqtt.notify(param);
+
+        if (_is_own_sender(sender)) {
+            // Own changes of persistent config (scene speed, calibration results) must invalidate cached copies too
+            if (auto it = _parameter_to_packet.find(param); it != _parameter_to_packet.end() && _is_config_parameter(it->second)) {
+                _config_changed();
+            }
+
+            return;
+        }
+
+        _idle_manager.activity();
+
+        if (_command_trace.recording()) _trace_parameter(sender, param);
+        _handle_property_change(param);
     });
 
     auto &ws_server = _bootstrap->ws_server();
-    auto &mqtt_server = _bootstrap->mqtt_server();
 
-    _metadata = std::make_unique<ConfigMetadata>(build_metadata(config(), _runtime_info));
-    _metadata->visit([this, &ws_server, &mqtt_server](AbstractPropertyMeta *meta) {
+    _metadata = std::make_unique<ConfigMetadata>(build_metadata(config(), _group_sync->info(), _profiler.info(),
+                                                                  _command_trace.data(), _config_revision, _sequence_scripts,
+                                                                  _sequence_errors, _transaction.batch(), _transaction.status()));
+    _metadata->visit([this, &ws_server](AbstractPropertyMeta *meta) {
         auto binary_protocol = (BinaryProtocolMeta<PacketType> *) meta->get_binary_protocol();
         if (binary_protocol->packet_type.has_value()) {
             ws_server->register_parameter(*binary_protocol->packet_type, meta->get_parameter());
+            _packet_to_parameter[*binary_protocol->packet_type] = meta->get_parameter();
             VERBOSE(D_PRINTF("WebSocket: Register property %s\r\n", __debug_enum_str(*binary_protocol->packet_type)));
         }
 
         auto mqtt_protocol = meta->get_mqtt_protocol();
         if (mqtt_protocol->topic_in && mqtt_protocol->topic_out) {
-            mqtt_server->register_parameter(mqtt_protocol->topic_in, mqtt_protocol->topic_out, meta->get_parameter());
+            _mqtt.register_parameter(mqtt_protocol->topic_in, mqtt_protocol->topic_out, meta->get_parameter());
             VERBOSE(D_PRINTF("MQTT: Register property %s <-> %s\r\n", mqtt_protocol->topic_in, mqtt_protocol->topic_out));
         } else if (mqtt_protocol->topic_out) {
-            mqtt_server->register_notification(mqtt_protocol->topic_out, meta->get_parameter());
+            _mqtt.register_notification(mqtt_protocol->topic_out, meta->get_parameter());
             VERBOSE(D_PRINTF("MQTT: Register notification -> %s\r\n", mqtt_protocol->topic_out));
         }
 
@@ -98,342 +141,593 @@ void Application::_setup() {
         }
     });
 
-    ws_server->register_notification(PacketType::HOMED, _metadata->data.homed);
-    ws_server->register_notification(PacketType::MOVING, _metadata->data.moving);
-    ws_server->register_notification(PacketType::POSITION, _metadata->data.position);
+    for (auto &axis: _axes) _setup_axis(*axis);
+
+    if constexpr (MQTT_DISCOVERY) {
+        _publish_discovery();
+
+        // Home Assistant announces restart, discovery and state are sent again then
+        _mqtt.register_command(MQTT_DISCOVERY_PREFIX "/status", [this](const auto &payload) {
+            if (payload == "online") _mqtt.republish(true);
+        });
+    }
 
     ws_server->register_data_request(PacketType::GET_CONFIG, _metadata->data.config);
-    ws_server->register_data_request(PacketType::GET_STATE, _metadata->data.state);
+    ws_server->register_data_request(PacketType::GET_GROUP_SYNC, _metadata->data.group_sync);
+    ws_server->register_data_request(PacketType::GET_PROFILE, _metadata->data.profile);
+    ws_server->register_data_request(PacketType::GET_TRACE, _metadata->data.trace);
+    ws_server->register_data_request(PacketType::GET_REVISION, _metadata->data.revision);
+    ws_server->register_data_request(PacketType::GET_TX_STATUS, _metadata->data.transaction);
+    ws_server->register_notification(PacketType::GET_TX_STATUS, _metadata->data.transaction);
+    ws_server->register_notification(PacketType::SEQUENCE_1_ERROR, _metadata->data.sequence_1_error);
+    ws_server->register_notification(PacketType::SEQUENCE_2_ERROR, _metadata->data.sequence_2_error);
+
+    ws_server->register_command(PacketType::RESTART, [this] {
+        // Delayed config save would be lost on restart
+        _save_config();
+        _bootstrap->restart();
+    });
+    ws_server->register_command(PacketType::PROFILE_RESET, [this] { _profile_reset(); });
 
-    ws_server->register_command(PacketType::RESTART, [this] { _bootstrap->restart(); });
-    ws_server->register_command(PacketType::HOMING, [this] { homing_async(); });
-    ws_server->register_command(PacketType::OPEN, [this] { open(); });
-    ws_server->register_command(PacketType::CLOSE, [this] { close(); });
-    ws_server->register_command(PacketType::STOP, [this] { emergency_stop(); });
+    ws_server->register_command(PacketType::TRACE_START, [this] { _command_trace.start(); });
+    ws_server->register_command(PacketType::TRACE_STOP, [this] { _command_trace.stop(); });
 
-    ws_server->register_command(PacketType::APPLY_OFFSET, [this] { apply_offset(); });
+    ws_server->register_command(PacketType::TX_BEGIN, [this] { _transaction.begin(); });
+    ws_server->register_command(PacketType::TX_COMMIT, [this] { _commit_transaction(); });
 
-    mqtt_server->register_notification(MQTT_OUT_TOPIC_OPEN, _metadata->data.openned);
-    mqtt_server->register_command(MQTT_TOPIC_OPEN, [this](const auto &payload) {
-        homing_if_needed().then<void>([this, value = payload.toInt() == 1](const auto &) {
-            if (value) open();
-            else close();
-        });
+    _bootstrap->web_server()->on(STATIC_ASSETS_URL "*", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        _static_assets.handle(request);
     });
-}
-void Application::_load() {
-    float speed_f;
 
-    if (auto value = config().speed; value == Speed::FAST) speed_f = 1.f;
-    else if (value == Speed::NORMAL) speed_f = 0.5f;
-    else speed_f = 0.f;
+    _bootstrap->web_server()->on(METRICS_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(200, "text/plain; version=0.0.4", Metrics::get().format(AXIS_COUNT));
+    });
 
-    _runtime_info.speed = speed_f;
-}
+    _bootstrap->web_server()->on(EVENT_TRACE_PATH, HTTP_GET, [](AsyncWebServerRequest *request) {
+        std::vector<TraceRecord> records;
+        const auto header = EventTrace::get().snapshot(records);
 
-void Application::_notify_periodic_status() {
-    NotificationBus::get().notify_parameter_changed(this, _metadata->data.homed);
-    NotificationBus::get().notify_parameter_changed(this, _metadata->data.moving);
-    NotificationBus::get().notify_parameter_changed(this, _metadata->data.position);
+        auto *response = request->beginResponseStream("application/octet-stream", sizeof(header) + records.size() * sizeof(TraceRecord));
+        response->write((const uint8_t *) &header, sizeof(header));
+        response->write((const uint8_t *) records.data(), records.size() * sizeof(TraceRecord));
+
+        request->send(response);
+    });
+
+    // Web interface controls the first axis, additional axes are controlled over MQTT
+    auto &main_axis = axis();
+    auto &main_meta = main_axis.metadata();
+
+    ws_server->register_notification(PacketType::HOMED, main_meta.data.homed);
+    ws_server->register_notification(PacketType::MOVING, main_meta.data.moving);
+    ws_server->register_notification(PacketType::POSITION, main_meta.data.position);
+    ws_server->register_notification(PacketType::CALIBRATION_STAGE, main_meta.data.calibration_stage);
+    ws_server->register_notification(PacketType::SEQUENCE_STEP, main_meta.data.sequence_step);
+
+    ws_server->register_data_request(PacketType::GET_STATE, main_meta.data.state);
+    ws_server->register_data_request(PacketType::GET_DRIFT, main_meta.data.drift);
+    ws_server->register_data_request(PacketType::GET_CALIBRATION, main_meta.data.calibration);
+    ws_server->register_data_request(PacketType::GET_ENDSTOP, main_meta.data.endstop);
+    ws_server->register_data_request(PacketType::GET_SPEED_PROFILE, main_meta.data.speed_profile);
+
+    ws_server->register_command(PacketType::HOMING, _traced_command(PacketType::HOMING, [this, &main_axis] {
+        _sequence_runners[main_axis.index()]->cancel();
+        main_axis.homing_async();
+    }));
+    ws_server->register_command(PacketType::OPEN, _traced_command(PacketType::OPEN, [this, &main_axis] {
+        _request_move(main_axis, 0);
+    }));
+    ws_server->register_command(PacketType::CLOSE, _traced_command(PacketType::CLOSE, [this, &main_axis] {
+        _request_move(main_axis, 100);
+    }));
+    ws_server->register_command(PacketType::STOP, _traced_command(PacketType::STOP, [this, &main_axis] {
+        _sequence_runners[main_axis.index()]->cancel();
+        main_axis.emergency_stop();
+    }));
+
+    ws_server->register_command(PacketType::APPLY_OFFSET, _traced_command(PacketType::APPLY_OFFSET, [&main_axis] {
+        main_axis.apply_offset();
+    }));
+
+    ws_server->register_command(PacketType::CALIBRATION_START, [this, &main_axis] {
+        _sequence_runners[main_axis.index()]->cancel();
+        main_axis.calibrate();
+    });
+    ws_server->register_command(PacketType::CALIBRATION_CONFIRM, [&main_axis] { main_axis.calibration_confirm(); });
+    ws_server->register_command(PacketType::CALIBRATION_APPLY, [this, &main_axis] {
+        main_axis.calibration_apply();
+        _config_changed();
+    });
+    ws_server->register_command(PacketType::ENDSTOP_CALIBRATE, [this, &main_axis] {
+        _sequence_runners[main_axis.index()]->cancel();
+        main_axis.calibrate_endstop();
+    });
+    ws_server->register_command(PacketType::SPEED_PROFILE_RESET, [this, &main_axis] {
+        main_axis.reset_speed_profile();
+        _config_changed();
+    });
 }
 
-void Application::_notify_position_status() {
-    NotificationBus::get().notify_parameter_changed(this, _metadata->data.openned);
-    NotificationBus::get().notify_parameter_changed(this, _metadata->data.position_target);
+void Application::_setup_axis(ShadeAxis &axis) {
+    auto &ws_server = _bootstrap->ws_server();
+
+    // Packet types are shared between axes, so only the first one is exposed over WebSocket
+    const bool main_axis = axis.index() == 0;
+
+    axis.metadata().visit([this, &axis, main_axis, &ws_server](AbstractPropertyMeta *meta) {
+        auto binary_protocol = (BinaryProtocolMeta<PacketType> *) meta->get_binary_protocol();
+        if (main_axis && binary_protocol->packet_type.has_value()) {
+            ws_server->register_parameter(*binary_protocol->packet_type, meta->get_parameter());
+            _packet_to_parameter[*binary_protocol->packet_type] = meta->get_parameter();
+            VERBOSE(D_PRINTF("WebSocket: Register property %s\r\n", __debug_enum_str(*binary_protocol->packet_type)));
+        }
+
+        auto mqtt_protocol = meta->get_mqtt_protocol();
+        if (mqtt_protocol->topic_in && mqtt_protocol->topic_out) {
+            _mqtt.register_parameter(mqtt_protocol->topic_in, mqtt_protocol->topic_out, meta->get_parameter());
+            VERBOSE(D_PRINTF("MQTT: Register property %s <-> %s\r\n", mqtt_protocol->topic_in, mqtt_protocol->topic_out));
+        } else if (mqtt_protocol->topic_out) {
+            _mqtt.register_notification(mqtt_protocol->topic_out, meta->get_parameter());
+            VERBOSE(D_PRINTF("MQTT: Register notification -> %s\r\n", mqtt_protocol->topic_out));
+        }
+
+        if (binary_protocol->packet_type.has_value()) {
+            _parameter_to_packet[meta->get_parameter()] = binary_protocol->packet_type.value();
+            _parameter_to_axis[meta->get_parameter()] = &axis;
+        }
+    });
+
+    _mqtt.register_command(axis.topics().open.c_str(), [this, &axis](const auto &payload) {
+        const bool open = payload.toInt() == 1;
+        _command_trace.record(TraceSource::MQTT_CLIENT, open ? PacketType::OPEN : PacketType::CLOSE);
+
+        _request_move(axis, open ? 0 : 100);
+    });
 }
 
-void Application::_on_bootstrap_ready() {
-    _load();
+void Application::_publish_discovery() {
+    const char *node_id = sys_config().mdns_name;
+
+    for (auto &axis: _axes) {
+        const auto &topics = axis->topics();
+        const unsigned number = axis->index() + 1;
+
+        char topic[96];
+        snprintf(topic, sizeof(topic), MQTT_DISCOVERY_PREFIX "/cover/%s/shade%u/config", node_id, number);
+
+        char payload[640];
+        snprintf(payload, sizeof(payload),
+                 R"({"name":"Shade %u","unique_id":"%s_shade%u","device_class":"shade",)"
+                 R"("command_topic":"%s","payload_open":"1","payload_close":"0","payload_stop":null,)"
+                 R"("set_position_topic":"%s","position_topic":"%s","position_open":%u,"position_closed":%u,)"
+                 R"("availability_topic":"%s","qos":1,)"
+                 R"("device":{"identifiers":["%s"],"name":"%s","model":"esp_shades"}})",
+                 number, node_id, number,
+                 topics.open.c_str(), topics.position.c_str(), topics.position_out.c_str(),
+                 MQTT_INVERT_POSITION ? 100u : 0u, MQTT_INVERT_POSITION ? 0u : 100u,
+                 MQTT_OUT_TOPIC_AVAILABILITY, node_id, node_id);
+
+        _mqtt.publish(topic, payload, true);
+    }
+}
 
-    _ntp_time->begin(config().sys_config.time_zone);
+bool Application::_is_own_sender(const void *sender) const {
+    if (sender == this) return true;
 
-    _ntp_time->update();
-    _night_mode_manager->update();
+    for (auto &axis: _axes) {
+        if (sender == axis.get()) return true;
+    }
 
-    _bootstrap->timer().add_interval([this](auto) {
-        _bootstrap_service_loop();
-    }, BOOTSTRAP_SERVICE_LOOP_INTERVAL);
+    return false;
 }
 
-void Application::event_loop() {
-    _stepper->tick();
-    _bootstrap->event_loop();
+TraceSource Application::_trace_source(const void *sender) const {
+    if (sender == _bootstrap->ws_server().get()) return TraceSource::WEB_SOCKET;
+    if (sender == &_mqtt) return TraceSource::MQTT_CLIENT;
+
+    return TraceSource::OTHER;
 }
 
-void Application::_handle_property_change(const AbstractParameter *parameter) {
+void Application::_trace_parameter(const void *sender, const AbstractParameter *parameter) {
     auto it = _parameter_to_packet.find(parameter);
     if (it == _parameter_to_packet.end()) return;
 
-    _load();
+    _command_trace.record(_trace_source(sender), it->second, parameter->get_value(), parameter->size());
+}
 
-    auto type = it->second;
-    if (type == PacketType::POSITION_TARGET) {
-        auto value = *(float *) parameter->get_value();
-        D_PRINTF("Requested target position: %0.2f%%", value);
+std::function<void()> Application::_traced_command(PacketType type, std::function<void()> fn) {
+    return [this, type, fn = std::move(fn)] {
+        _command_trace.record(TraceSource::WEB_SOCKET, type);
+        fn();
+    };
+}
 
-        homing_if_needed().then<void>([this, value](auto &) {
-            move_to(value);
-        });
-    } else if (type == PacketType::SPEED) {
-        if (_state == AppState::MOVING) {
-            auto new_speed = _runtime_info.speed_steps * _runtime_info.speed;
+void Application::_request_move(ShadeAxis &axis, float position) {
+    // Direct command takes over the shade
+    _sequence_runners[axis.index()]->cancel();
 
-            _stepper->setMaxSpeed(std::max((int32_t) new_speed, STEPPER_MIN_SPEED));
-            _stepper->setTarget(_stepper->getTarget());
-        }
-    } else if (type >= PacketType::NIGHT_MODE_ENABLED && type <= PacketType::NIGHT_MODE_END) {
-        _night_mode_manager->update();
+    // Group leader delays own move too, so the whole group starts at once
+    if (axis.index() == 0 && _group_sync->leader()) {
+        _group_sync->move(position);
+        return;
     }
 
-    update();
+    axis.homing_if_needed().then<void>([&axis, position](auto &) { axis.move_to(position); });
 }
 
+void Application::_apply_scene(ShadeAxis &axis, uint8_t id) {
+    if (id == 0 || id > SCENE_COUNT) {
+        D_PRINTF("Unknown scene: %u\r\n", id);
+        return;
+    }
 
-void Application::update() {
-    _bootstrap->save_changes();
+    // Speed is applied before the move, so the motion is planned once with scene speed
+    const auto &scene = config().scenes[id - 1];
+    axis.apply_scene(id, scene);
+
+    _request_move(axis, scene.position);
 }
 
-void Application::change_state(AppState s) {
-    _state_change_time = millis();
-    _state = s;
-    D_PRINTF("Change app state: %s\r\n", __debug_enum_str(s));
+void Application::_sunrise(ShadeAxis &axis, uint8_t scene_id) {
+    float position = 0;
+    if (scene_id > 0 && scene_id <= SCENE_COUNT) position = config().scenes[scene_id - 1].position;
+
+    _sequence_runners[axis.index()]->cancel();
+
+    const uint32_t duration = (uint32_t) config().night_mode.sunrise_duration * 60 * 1000;
+    axis.homing_if_needed().then<void>([&axis, position, duration](auto &) { axis.sunrise(position, duration); });
 }
 
-void Application::open() {
-    move_to(0);
+void Application::_run_sequence(ShadeAxis &axis, uint8_t id) {
+    auto &runner = *_sequence_runners[axis.index()];
+
+    if (id == 0) {
+        runner.cancel();
+        return;
+    }
+
+    if (id > SEQUENCE_COUNT) {
+        D_PRINTF("Unknown sequence: %u\r\n", id);
+        return;
+    }
+
+    runner.run(id, config().sequences[id - 1]);
 }
 
-void Application::close() {
-    move_to(100);
+void Application::_compile_sequence(uint8_t index) {
+    char script[SEQUENCE_SCRIPT_SIZE + 1]{};
+    memcpy(script, _sequence_scripts[index], SEQUENCE_SCRIPT_SIZE);
+
+    // Previously compiled steps are kept on error, client is told which step was rejected
+    if (!sequence_compile(script, config().sequences[index], &_sequence_errors[index])) {
+        D_PRINTF("Sequence %u: Unable to compile script\r\n", index + 1);
+    }
+
+    static_assert(SEQUENCE_COUNT == 2, "Every sequence must have error notification");
+    auto &data = _metadata->data;
+    NotificationBus::get().notify_parameter_changed(this, index == 0 ? data.sequence_1_error : data.sequence_2_error);
 }
 
-void Application::move_to(float value) {
-    auto k = std::min(std::max(value, 0.0f), 100.f) / 100.f;
-    _runtime_info.position_target = k * 100.f;
+void Application::_on_bootstrap_ready() {
+    for (auto &axis: _axes) axis->load();
+
+#ifdef SHADE_SIMULATOR
+    _benchmark = std::make_unique<SimulatorBenchmark>(axis());
+    _benchmark->run_async();
+#endif
+
+    _group_sync->begin();
+
+    _ntp_time->begin(config().sys_config.time_zone);
 
-    _notify_position_status();
+    _ntp_time->update();
+    _night_mode_manager->update();
 
-    move_to_step((int32_t) (config().stepper_calibration.open_position * k));
+    _timer.add_interval([this](auto) {
+        ProfileScope scope(_profiler, ProfileSection::BOOTSTRAP_SERVICE);
+        _bootstrap_service_loop();
+    }, BOOTSTRAP_SERVICE_LOOP_INTERVAL);
 }
 
-void Application::apply_offset() {
-    if (_state != AppState::STAND_BY) return;
+void Application::event_loop() {
+    _idle_loop();
+
+    ProfileScope loop_scope(_profiler, ProfileSection::LOOP);
 
-    auto new_offset = config().stepper_calibration.offset;
-    if (new_offset == _runtime_info.offset) return;
+    {
+        ProfileScope scope(_profiler, ProfileSection::STEP_TICK);
+        _step_scheduler.tick();
+    }
 
-    auto pos = _stepper->getCurrent();
-    auto d_offset = new_offset - _runtime_info.offset;
-    _runtime_info.offset = new_offset;
+    ProfileScope scope(_profiler, ProfileSection::BOOTSTRAP);
 
-    _stepper->setCurrent(pos - d_offset);
-    move_to_step(pos);
+    // Application timers, framework keeps own Timer for its internal tasks
+    _timer.handle_timers();
+    _bootstrap->event_loop();
 }
 
-void Application::move_to_step(int32_t pos) {
-    if (!_runtime_info.homed) {
-        D_PRINT("Must home first!");
+void Application::_handle_property_change(const AbstractParameter *parameter) {
+    auto it = _parameter_to_packet.find(parameter);
+    if (it == _parameter_to_packet.end()) return;
+
+    auto type = it->second;
+    if (type == PacketType::TX_SET) {
+        _transaction.append();
         return;
     }
 
-    if (pos == _stepper->getCurrent()) {
-        D_PRINT("Moving cancelled: already in position");
-        return;
+    auto axis_it = _parameter_to_axis.find(parameter);
+    if (axis_it != _parameter_to_axis.end() && type == PacketType::POSITION_TARGET) {
+        auto &axis = *axis_it->second;
+        axis.load();
+        _request_move(axis, *(float *) parameter->get_value());
+    } else if (axis_it != _parameter_to_axis.end() && type == PacketType::APPLY_SCENE) {
+        _apply_scene(*axis_it->second, *(uint8_t *) parameter->get_value());
+    } else if (axis_it != _parameter_to_axis.end() && type == PacketType::RUN_SEQUENCE) {
+        _run_sequence(*axis_it->second, *(uint8_t *) parameter->get_value());
+    } else {
+        PendingChanges changes;
+        _collect_change(type, parameter, changes);
+        _apply_changes(changes);
     }
 
-    D_PRINTF("Moving to position: %d\r\n", pos);
+    update();
+}
 
-    if (_state == AppState::STAND_BY) {
-        _stepper->enable();
+void Application::_collect_change(PacketType type, const AbstractParameter *parameter, PendingChanges &changes) {
+    if (auto axis_it = _parameter_to_axis.find(parameter); axis_it != _parameter_to_axis.end()) {
+        // Axis reloads whole config anyway, only SPEED has additional handling
+        auto &pending = changes.axes[axis_it->second->index()];
+        if (!pending.has_value() || type == PacketType::SPEED) pending = type;
+    } else if (type >= PacketType::NIGHT_MODE_ENABLED && type <= PacketType::NIGHT_MODE_END) {
+        changes.night_mode = true;
+    } else if (type >= PacketType::GROUP_SYNC_ENABLED && type <= PacketType::GROUP_SYNC_START_DELAY) {
+        changes.group_sync = true;
+    } else if (type >= PacketType::SEQUENCE_1_SCRIPT && type <= PacketType::SEQUENCE_2_SCRIPT) {
+        changes.sequences[(uint8_t) type - (uint8_t) PacketType::SEQUENCE_1_SCRIPT] = true;
+    }
+}
 
-        _runtime_info.moving = true;
-        _notify_periodic_status();
-        change_state(AppState::MOVING);
+void Application::_apply_changes(const PendingChanges &changes) {
+    for (auto &axis: _axes) {
+        if (auto &type = changes.axes[axis->index()]; type.has_value()) {
+            axis->handle_property_change(*type);
+            _update_wake_pin(*axis);
+        }
     }
 
+    for (uint8_t i = 0; i < SEQUENCE_COUNT; ++i) {
+        if (changes.sequences[i]) _compile_sequence(i);
+    }
 
-    _runtime_info.speed_steps = pos > _runtime_info.position
-                                ? config().stepper_config.close_speed
-                                : config().stepper_config.open_speed;
+    if (changes.night_mode) _night_mode_manager->update();
+    if (changes.group_sync) _group_sync->begin();
 
-    auto new_speed = _runtime_info.speed_steps * _runtime_info.speed;
+    _config_changed();
+}
 
-    _stepper->setMaxSpeed(std::max((int32_t) new_speed, STEPPER_MIN_SPEED));
-    _stepper->setTarget(pos);
+bool Application::_is_config_parameter(PacketType type) {
+    // Runtime commands are executed immediately, they are neither persisted nor accepted in config batch
+    return type != PacketType::POSITION_TARGET
+           && type != PacketType::APPLY_SCENE
+           && type != PacketType::RUN_SEQUENCE
+           && type != PacketType::TX_SET;
 }
 
-void Application::emergency_stop() {
-    _stepper->brake();
-    _stepper->disable();
+void Application::_commit_transaction() {
+    // Whole batch is validated first, so a typo in the last entry doesn't leave config half-updated
+    PacketType failed_type = PacketType::TX_COMMIT;
+    auto error = !_transaction.open() ? TransactionError::NOT_STARTED : _transaction.visit(
+        [this](PacketType type, const uint8_t *value, uint8_t size) {
+            auto it = _packet_to_parameter.find(type);
+            if (it == _packet_to_parameter.end()) return TransactionError::UNKNOWN_PARAMETER;
+            if (!_is_config_parameter(type)) return TransactionError::NOT_ALLOWED;
+            if (it->second->size() != size) return TransactionError::SIZE_MISMATCH;
+
+            if (type >= PacketType::SEQUENCE_1_SCRIPT && type <= PacketType::SEQUENCE_2_SCRIPT) {
+                char script[SEQUENCE_SCRIPT_SIZE + 1]{};
+                memcpy(script, value, std::min<uint8_t>(size, SEQUENCE_SCRIPT_SIZE));
+
+                SequenceConfig sequence{};
+                if (!sequence_compile(script, sequence)) return TransactionError::REJECTED;
+            }
 
-    if (_state != AppState::HOMING) {
-        _runtime_info.moving = false;
-        _runtime_info.position_target = (float) _stepper->getCurrent() / config().stepper_calibration.open_position * 100.f;
+            return TransactionError::NONE;
+        }, failed_type);
 
+    // Previous values are kept to roll back if parameter rejects the new one
+    std::vector<std::pair<AbstractParameter *, std::vector<uint8_t>>> backup;
+    PendingChanges changes;
 
-        _notify_periodic_status();
-        _notify_position_status();
+    if (error == TransactionError::NONE) {
+        error = _transaction.visit([&](PacketType type, const uint8_t *value, uint8_t size) {
+            auto *parameter = _packet_to_parameter[type];
+            auto *current = (const uint8_t *) parameter->get_value();
+            backup.emplace_back(parameter, std::vector<uint8_t>(current, current + size));
 
-        change_state(AppState::STAND_BY);
-    }
-}
+            if (!parameter->set_value(value, size)) return TransactionError::REJECTED;
 
-Future<void> Application::homing_async() {
-    if (_state != AppState::STAND_BY) {
-        D_PRINTF("Homing forbidden for state: %s\r\n", __debug_enum_str(_state));
-        return Future<void>::errored();
+            _collect_change(type, parameter, changes);
+            return TransactionError::NONE;
+        }, failed_type);
     }
 
-    change_state(AppState::HOMING);
-
-    _runtime_info.position = 0;
-    _runtime_info.position_target = 0;
-    _runtime_info.homed = false;
-    _runtime_info.moving = true;
+    if (error == TransactionError::NONE) {
+        _apply_changes(changes);
+        update();
 
-    _notify_periodic_status();
+        // Same notifications as for single changes, so MQTT topics and other clients stay in sync
+        std::set<const AbstractParameter *> notified;
+        for (auto &[parameter, _]: backup) {
+            if (notified.insert(parameter).second) NotificationBus::get().notify_parameter_changed(this, parameter);
+        }
+    } else {
+        for (auto it = backup.rbegin(); it != backup.rend(); ++it) {
+            it->first->set_value(it->second.data(), it->second.size());
+        }
+    }
 
-    auto &cfg = config().stepper_config;
+    _transaction.finish(error, failed_type, error == TransactionError::NONE ? backup.size() : 0, _config_revision.revision);
 
-    return Future<void>::successful()
-        .then<bool>([this, &cfg](auto &) {
-            D_PRINT("Homing: Preparing");
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.transaction);
+}
 
-            _stepper->enable();
-            _stepper->reset();
+void Application::_config_changed() {
+    // Lets web clients skip GET_CONFIG when their cached copy is still actual
+    _config_revision.revision++;
+}
 
-            // Go down a little
-            _stepper->setMaxSpeed(cfg.homing_speed);
-            _stepper->setTarget(cfg.homing_steps);
+void Application::update(bool immediate) {
+    // Invalidation record is a few bytes appended to the log, it's written right away even while other axes step,
+    // otherwise power loss during the move would leave a trusted stale position
+    if (immediate) {
+        _timer.clear_timeout(_config_save_timer);
+        _config_save_timer = -1ul;
+        _config_save_pending = false;
 
-            return homing_move_async(false);
-        })
-        .then<bool>([this, &cfg](auto &) {
-            D_PRINT("Homing: First step");
+        _save_config();
+        return;
+    }
 
-            // First homing step
-            _stepper->setTarget(-cfg.homing_steps_max, RELATIVE);
+    if (_config_save_timer != -1ul) return;
 
-            return homing_move_async();
-        })
-        .then<bool>([this, &cfg](auto &f) {
-            if (!f.result()) {
-                D_PRINT("Homing failed! Movement limit exceeded");
-                return Future<bool>::errored();
-            }
+    _config_save_timer = _timer.add_timeout([this](auto) {
+        _config_save_timer = -1ul;
 
-            D_PRINT("Homing: Rewind");
-            _stepper->brake();
+        // Held until motion ends, service loop writes it once every axis is back in stand-by
+        if (_motion_active()) {
+            _config_save_pending = true;
+            return;
+        }
 
-            // Go up a little
-            _stepper->setTarget(cfg.homing_steps, RELATIVE);
+        _save_config();
+    }, CONFIG_LOG_SAVE_DELAY);
+}
 
-            return homing_move_async(false);
-        })
-        .then<bool>([this, &cfg](auto &f) {
-            if (f.result()) {
-                D_PRINT("Homing failed! Endstop did not reset");
-                return Future<bool>::errored();
-            }
+void Application::_load_config() {
+    // Metadata is built only to resolve field locations, runtime data is not persisted
+    GroupSyncInfo group_sync_info{};
+    auto metadata = build_metadata(config(), group_sync_info, _profiler.info(), _command_trace.data(),
+                                   _config_revision, _sequence_scripts, _sequence_errors, _transaction.batch(), _transaction.status());
 
-            D_PRINT("Homing: Second step");
+    auto add_fields = [this](uint8_t scope, AbstractPropertyMeta *meta) {
+        auto binary_protocol = (BinaryProtocolMeta<PacketType> *) meta->get_binary_protocol();
+        if (!binary_protocol->packet_type.has_value() || !_is_config_parameter(*binary_protocol->packet_type)) return;
 
-            // Second homing step
-            _stepper->setMaxSpeed(cfg.homing_speed_second);
-            _stepper->setTarget((int32_t) (-1.5 * cfg.homing_steps), RELATIVE);
+        auto *parameter = meta->get_parameter();
+        _config_log.add(ConfigLog::key(scope, (uint8_t) *binary_protocol->packet_type),
+                        (void *) parameter->get_value(), parameter->size());
+    };
 
-            return homing_move_async();
-        })
-        .then<void>([this](auto &f) {
-            if (!f.result()) {
-                D_PRINT("Homing failed! Second movement limit exceeded");
-                return Future<void>::errored();
-            }
+    metadata.visit([&add_fields](AbstractPropertyMeta *meta) { add_fields(0, meta); });
 
-            _stepper->brake();
-            return Future<void>::successful();
-        }).then<void>([this, &cfg](auto &) {
-            D_PRINT("Applying offset...");
+    for (uint8_t i = 0; i < AXIS_COUNT; ++i) {
+        auto &axis_config = config().axes[i];
 
-            _stepper->setMaxSpeed(cfg.homing_speed);
-            _stepper->setTarget(config().stepper_calibration.offset, RELATIVE);
+        const auto topics = build_axis_topics(i);
+        RuntimeInfo runtime_info{};
+        DriftHistory drift_history{};
+        CalibrationInfo calibration_info{};
+        EndstopInfo endstop_info{};
 
-            return homing_move_async(false);
-        }).then<void>([this](auto &) {
-            _runtime_info.homed = true;
-            _stepper->reset();
+        auto axis_metadata = build_axis_metadata(axis_config, sys_config().axis_pins[i], topics,
+                                                 runtime_info, drift_history, calibration_info, endstop_info);
+        axis_metadata.visit([&add_fields, i](AbstractPropertyMeta *meta) { add_fields(i + 1, meta); });
 
-            D_PRINT("Homing success!");
-        })
-        .finally([this] {
-            _stepper->brake();
-            _stepper->disable();
+        _config_log.add(ConfigLog::key(i + 1, (uint8_t) ConfigLogField::STEPPER_STATE),
+                        &axis_config.stepper_state, sizeof(axis_config.stepper_state));
+        _config_log.add(ConfigLog::key(i + 1, (uint8_t) ConfigLogField::SPEED_PROFILE),
+                        &axis_config.speed_profile_state, sizeof(axis_config.speed_profile_state));
+    }
 
-            _runtime_info.moving = false;
-            _notify_periodic_status();
+    static_assert(SEQUENCE_COUNT == 2, "ConfigLogField must declare every sequence");
+    for (uint8_t i = 0; i < SEQUENCE_COUNT; ++i) {
+        _config_log.add(ConfigLog::key(0, (uint8_t) ConfigLogField::SEQUENCE_1 + i),
+                        &config().sequences[i], sizeof(config().sequences[i]));
+    }
 
-            change_state(AppState::STAND_BY);
-        });
+    _config_log.load();
 }
 
-Future<bool> Application::homing_move_async(bool detect_endstop) {
-    auto promise = Promise<bool>::create();
-    auto timer_id = _bootstrap->timer().add_interval([=, this](auto) {
-        if (promise->finished()) return;
+void Application::_save_config() {
+    if (auto written = _config_log.flush(); written > 0) {
+        Metrics::get().config_saves++;
+        D_PRINTF("Config Log: Saved %u bytes\r\n", written);
+    }
+}
 
-        if ((_endstop_pressed && detect_endstop) || _stepper->getStatus() == 0) {
-            promise->set_success(_endstop_pressed);
-        }
+void Application::_start_service_loop() {
+    _service_loop_timer = _timer.add_interval([this](auto) {
+        ProfileScope scope(_profiler, ProfileSection::SERVICE_LOOP);
+        _service_loop();
     }, APP_SERVICE_LOOP_INTERVAL);
+}
 
-    return Future{promise}.finally([this, timer_id](auto &) {
-        _bootstrap->timer().clear_interval(timer_id);
-    });
+void Application::_update_wake_pin(const ShadeAxis &axis) {
+#ifndef SHADE_SIMULATOR
+    // Analog endstop pin is sampled by ADC, it can't wake the chip. Mode may be switched at runtime
+    const auto pin = sys_config().axis_pins[axis.index()].endstop_pin;
+    if (axis.config().endstop.mode == EndstopMode::DIGITAL) {
+        _idle_manager.add_wake_pin(pin);
+    } else {
+        _idle_manager.remove_wake_pin(pin);
+    }
+#endif
 }
 
-Future<void> Application::homing_if_needed() {
-    if (_runtime_info.homed) return Future<void>::successful();
-    if (_state == AppState::HOMING) return Future<void>::errored();
+bool Application::_motion_active() const {
+    for (auto &axis: _axes) {
+        // Pauses between sunrise bursts may take minutes, config is written there as well
+        const auto state = axis->state();
+        if (axis->stepping() || (state >= AppState::HOMING && state <= AppState::CALIBRATION)) return true;
+    }
 
-    return homing_async();
+    return false;
 }
 
-void Application::endstop_triggered() {
-    if (_endstop_pressed) return;
-
-    _endstop_pressed = true;
-    D_PRINT("Endstop triggered!");
+bool Application::_can_idle() const {
+    if (!_initialized) return false;
 
-    if (_state == AppState::MOVING) {
-        D_PRINT("Endstop triggered during movement!");
-        emergency_stop();
+    for (auto &axis: _axes) {
+        if (!axis->idle()) return false;
     }
+
+    return true;
 }
 
-void Application::endstop_release() {
-    if (!_endstop_pressed) return;
+void Application::_idle_loop() {
+    if (_idle_manager.update(_can_idle())) {
+        if (_idle_manager.idle()) {
+            // Service loop is polled on every wake-up instead, otherwise it would limit sleep to its 2 ms interval
+            _timer.clear_interval(_service_loop_timer);
+            _service_loop_timer = -1ul;
+        } else {
+            _start_service_loop();
+        }
+
+        _profiler.update_frequency();
+    }
+
+    if (!_idle_manager.idle()) return;
 
-    _endstop_pressed = false;
-    D_PRINT("Endstop released!");
+    _idle_manager.wait(_timer.next_deadline());
+    _service_loop();
 }
 
 void Application::_service_loop() {
-    _endstop->handle();
-    bool moving = _stepper->getStatus() != 0;
+#ifndef SHADE_SIMULATOR
+    AdcSampler::get().handle();
+#endif
 
-    if (_state == AppState::MOVING && !moving) {
-        _stepper->brake();
-        _stepper->disable();
+    for (auto &axis: _axes) axis->service_loop();
 
-        _runtime_info.moving = false;
-        change_state(AppState::STAND_BY);
+    _mqtt.handle();
 
-        _notify_periodic_status();
-        _notify_position_status();
-    }
+    _group_sync->handle();
 
-    if (_runtime_info.homed && moving) {
-        _runtime_info.position = _stepper->getCurrent();
+    if (_config_save_pending && !_motion_active()) {
+        _config_save_pending = false;
+        _save_config();
     }
 }
 
@@ -444,27 +738,47 @@ void Application::_bootstrap_service_loop() {
 }
 
 void Application::_move_notification_loop() {
-    if (_state == AppState::MOVING) {
-        NotificationBus::get().notify_parameter_changed(this, _metadata->data.position);
-    }
+    for (auto &axis: _axes) axis->move_notification_loop();
+}
+
+void Application::_notify_periodic_status() {
+    for (auto &axis: _axes) axis->notify_periodic_status();
+}
+
+void Application::_profile_reset() {
+    _profiler.reset();
+    _step_scheduler.reset_timing();
+    _idle_manager.reset_stats();
+
+    _profiler.snapshot(_step_scheduler.timing(), _idle_manager.stats());
 }
 
 void Application::_bootstrap_state_changed(void *sender, BootstrapState state, void *arg) {
     if (state == BootstrapState::INITIALIZING) {
         _ntp_time->begin(TIME_ZONE);
 
-        change_state(AppState::INITIALIZATION);
+        for (auto &axis: _axes) axis->change_state(AppState::INITIALIZATION);
     } else if (state == BootstrapState::READY && !_initialized) {
         _initialized = true;
 
-        change_state(AppState::STAND_BY);
+        for (auto &axis: _axes) axis->change_state(AppState::STAND_BY);
     }
 }
 
 void Application::_night_mode_state_changed(void *sender, NightModeState state, void *arg) {
-    if (state == NightModeState::ACTIVE) {
-        homing_if_needed().then<void>([this](auto) { close(); });
-    } else if (state == NightModeState::WAITING) {
-        homing_if_needed().then<void>([this](auto) { open(); });
+    const auto &night_mode = config().night_mode;
+
+    for (auto &axis_ptr: _axes) {
+        auto &axis = *axis_ptr;
+
+        if (state == NightModeState::ACTIVE) {
+            if (night_mode.start_scene) _apply_scene(axis, night_mode.start_scene);
+            else axis.homing_if_needed().then<void>([&axis](auto) { axis.close(); });
+        } else if (state == NightModeState::WAITING && night_mode.sunrise_duration) {
+            _sunrise(axis, night_mode.end_scene);
+        } else if (state == NightModeState::WAITING) {
+            if (night_mode.end_scene) _apply_scene(axis, night_mode.end_scene);
+            else axis.homing_if_needed().then<void>([&axis](auto) { axis.open(); });
+        }
     }
 }
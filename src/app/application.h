@@ -3,80 +3,130 @@
 #include "sys_constants.h"
 
 #include "lib/bootstrap.h"
-#include "lib/misc/button.h"
 #include "lib/misc/ntp_time.h"
 #include "lib/async/promise.h"
 
 #include "config.h"
 #include "metadata.h"
 #include "cmd.h"
+#include "axis.h"
+#include "sequence_runner.h"
+#include "simulator_benchmark.h"
+#include "misc/adc_sampler.h"
+#include "misc/command_trace.h"
+#include "misc/config_log.h"
+#include "misc/event_trace.h"
+#include "misc/group_sync.h"
+#include "misc/idle_manager.h"
+#include "misc/mqtt_client.h"
 #include "misc/night_mode.h"
-
-#include <GyverStepper2.h>
+#include "misc/profiler.h"
+#include "misc/static_assets.h"
+#include "misc/step_scheduler.h"
+#include "misc/timer_wheel.h"
+#include "misc/transaction.h"
+
+// Side effects of changed parameters, collected so a transaction applies each of them once
+struct PendingChanges {
+    std::array<std::optional<PacketType>, AXIS_COUNT> axes{};
+    std::array<bool, SEQUENCE_COUNT> sequences{};
+
+    bool night_mode = false;
+    bool group_sync = false;
+};
 
 class Application {
     std::unique_ptr<Bootstrap<Config, PacketType>> _bootstrap = nullptr;
     std::unique_ptr<ConfigMetadata> _metadata = nullptr;
     std::unique_ptr<NightModeManager> _night_mode_manager = nullptr;
     std::unique_ptr<NtpTime> _ntp_time = nullptr;
-    std::unique_ptr<Button> _endstop = nullptr;
-    std::unique_ptr<GStepper2<STEPPER_TYPE>> _stepper = nullptr;
-
-    RuntimeInfo _runtime_info{};
+    std::unique_ptr<GroupSync> _group_sync = nullptr;
+
+    std::array<std::unique_ptr<ShadeAxis>, AXIS_COUNT> _axes{};
+    std::array<std::unique_ptr<SequenceRunner>, AXIS_COUNT> _sequence_runners{};
+    StepScheduler<ShadeStepper, AXIS_COUNT> _step_scheduler{};
+    TimerWheel _timer{};
+    IdleManager _idle_manager{};
+    Profiler _profiler{};
+    CommandTrace _command_trace{};
+    StaticAssets _static_assets{LittleFS};
+    Transaction _transaction{};
+    ConfigLog _config_log{LittleFS};
+    MqttClient _mqtt{};
+
+#ifdef SHADE_SIMULATOR
+    std::unique_ptr<SimulatorBenchmark> _benchmark = nullptr;
+#endif
 
     bool _initialized = false;
-    volatile bool _endstop_pressed = false;
+    unsigned long _service_loop_timer = -1ul;
+    unsigned long _config_save_timer = -1ul;
+    bool _config_save_pending = false;
 
-    unsigned long _state_change_time = 0;
-    AppState _state = AppState::UNINITIALIZED;
+    SequenceScript _sequence_scripts[SEQUENCE_COUNT]{};
+    uint8_t _sequence_errors[SEQUENCE_COUNT]{};
+    ConfigRevision _config_revision{};
 
     std::map<const AbstractParameter *, PacketType> _parameter_to_packet{};
+    std::map<const AbstractParameter *, ShadeAxis *> _parameter_to_axis{};
+    std::map<PacketType, AbstractParameter *> _packet_to_parameter{};
 
 public:
     [[nodiscard]] Config &config() const { return _bootstrap->config(); }
     [[nodiscard]] SysConfig &sys_config() const { return config().sys_config; }
 
+    [[nodiscard]] ShadeAxis &axis(uint8_t index = 0) const { return *_axes[index]; }
+
     void begin();
     void event_loop();
 
-    void update();
-
-    void open();
-    void close();
-
-    void move_to(float value);
-    void apply_offset();
+    void update(bool immediate = false);
 
     void restart() { _bootstrap->restart(); }
 
-protected:
-    void change_state(AppState s);
-
-    void emergency_stop();
-    void move_to_step(int32_t pos);
+private:
+    void _load_config();
+    void _save_config();
 
-    Future<void> homing_async();
-    Future<bool> homing_move_async(bool detect_endstop = true);
+    void _setup();
+    void _setup_axis(ShadeAxis &axis);
+    void _publish_discovery();
 
-    Future<void> homing_if_needed();
+    [[nodiscard]] bool _is_own_sender(const void *sender) const;
 
-    void endstop_triggered();
-    void endstop_release();
+    [[nodiscard]] TraceSource _trace_source(const void *sender) const;
+    void _trace_parameter(const void *sender, const AbstractParameter *parameter);
+    std::function<void()> _traced_command(PacketType type, std::function<void()> fn);
 
-private:
-    void _setup();
-    void _load();
+    void _request_move(ShadeAxis &axis, float position);
+    void _apply_scene(ShadeAxis &axis, uint8_t id);
+    void _sunrise(ShadeAxis &axis, uint8_t scene_id);
 
-    void _notify_periodic_status();
-    void _notify_position_status();
+    void _run_sequence(ShadeAxis &axis, uint8_t id);
+    void _compile_sequence(uint8_t index);
 
     void _on_bootstrap_ready();
     void _bootstrap_state_changed(void *sender, BootstrapState state, void *arg);
     void _night_mode_state_changed(void *sender, NightModeState state, void *arg);
 
+    void _start_service_loop();
+    [[nodiscard]] bool _motion_active() const;
+    void _update_wake_pin(const ShadeAxis &axis);
+    [[nodiscard]] bool _can_idle() const;
+    void _idle_loop();
+
     void _service_loop();
     void _bootstrap_service_loop();
     void _move_notification_loop();
+    void _notify_periodic_status();
+
+    void _profile_reset();
 
     void _handle_property_change(const AbstractParameter *param);
+    void _collect_change(PacketType type, const AbstractParameter *parameter, PendingChanges &changes);
+    void _apply_changes(const PendingChanges &changes);
+    void _config_changed();
+
+    [[nodiscard]] static bool _is_config_parameter(PacketType type);
+    void _commit_transaction();
 };
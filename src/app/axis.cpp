@@ -0,0 +1,1345 @@
+#include "axis.h"
+
+#include "misc/adc_sampler.h"
+
+ShadeAxis::ShadeAxis(uint8_t index, TimerWheel &timer, AxisConfig &config, AxisPinsConfig &pins, AxisUpdateFn update_fn) :
+    _index(index), _timer(timer), _config(config), _pins(pins), _update_fn(std::move(update_fn)),
+    _topics(build_axis_topics(index)) {}
+
+void ShadeAxis::begin() {
+    _drift_monitor = std::make_unique<DriftMonitor>(_config.stepper_config);
+    _speed_profile = std::make_unique<SpeedProfile>(_config);
+
+    _metadata = std::make_unique<AxisMetadata>(build_axis_metadata(
+        _config, _pins, _topics, _runtime_info, _drift_monitor->history(), _calibration_info,
+        _endstop_info));
+
+    auto &stepper_cfg = _config.stepper_config;
+    _stepper = std::make_unique<ShadeStepper>((uint16_t) stepper_cfg.resolution);
+
+#ifdef SHADE_SIMULATOR
+    D_PRINTF("Axis %u: Using simulated mechanism\r\n", _index);
+
+    _simulator = std::make_unique<ShadeSimulator>(SimulatorConfig{.seed = SIMULATOR_SEED + _index});
+    attach_axis_simulator(_index, *_stepper, *_simulator);
+#else
+    const uint8_t stepper_pins[] = {
+        _pins.stepper_pin_1,
+        _pins.stepper_pin_2,
+        _pins.stepper_pin_3,
+        _pins.stepper_pin_4,
+    };
+
+    if (!attach_axis_phase_driver(_index, *_stepper, stepper_cfg.drive_mode, stepper_pins, _pins.stepper_pin_en, stepper_cfg.reverse)) {
+        D_PRINTF("Axis %u: Unable to initialize stepper driver\r\n", _index);
+    }
+#endif
+
+    _stepper->disable(); // Make sure stepper pins are disabled
+
+    _stepper->setAcceleration(stepper_cfg.acceleration);
+    _stepper->autoPower(false); // Coils power is controlled by CoilPowerManager
+
+    _coil_power = std::make_unique<CoilPowerManager>(_timer, _config, _runtime_info);
+    _coil_power->begin(_pins.stepper_pin_en, COIL_PWM_CHANNEL + _index, [this](bool enabled) {
+        if (enabled) _stepper->enable();
+        else _stepper->disable();
+    });
+
+    _setup_endstop();
+
+    change_state(AppState::INITIALIZATION);
+}
+
+void ShadeAxis::load() {
+    float speed_f;
+
+    if (auto value = _config.speed; value == Speed::FAST) speed_f = 1.f;
+    else if (value == Speed::NORMAL) speed_f = 0.5f;
+    else speed_f = 0.f;
+
+    _runtime_info.speed = speed_f;
+}
+
+void ShadeAxis::_setup_endstop() {
+    const auto mode = _config.endstop.mode;
+    if (_endstop_initialized && mode == _endstop_mode) return;
+
+    _endstop_initialized = true;
+    _endstop_mode = mode;
+
+#ifndef SHADE_SIMULATOR
+    if (_analog_endstop) AdcSampler::get().remove(_pins.endstop_pin);
+#endif
+
+    _analog_endstop = nullptr;
+    _endstop = nullptr;
+    _endstop_near = false;
+
+    if (mode == EndstopMode::ANALOG) {
+        _analog_endstop = std::make_unique<AnalogEndstop>(_config.endstop, _pins.endstop_high_state, _endstop_info);
+
+#ifndef SHADE_SIMULATOR
+        if (!AdcSampler::get().add(_pins.endstop_pin, *_analog_endstop)) {
+            D_PRINTF("Axis %u: Analog endstop unavailable, using digital input\r\n", _index);
+            _analog_endstop = nullptr;
+        }
+#endif
+    }
+
+#ifndef SHADE_SIMULATOR
+    if (!_analog_endstop) {
+        _endstop = std::make_unique<Button>(_pins.endstop_pin, _pins.endstop_high_state);
+        _endstop->set_hold_repeat(false);
+        _endstop->set_on_hold([this](auto) { endstop_triggered(); });
+        _endstop->set_on_hold_release([this](auto) { endstop_release(); });
+    }
+#endif
+}
+
+void ShadeAxis::_store_position(bool valid) {
+    auto &state = _config.stepper_state;
+    state.position_valid = valid && _runtime_info.homed;
+    state.position = _stepper->getCurrent();
+
+    // Invalidation is written before the motor starts, otherwise power loss mid-move would leave a trusted stale position
+    if (_update_fn) _update_fn(!valid);
+}
+
+void ShadeAxis::_notify_calibration_status() {
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.calibration_stage);
+}
+
+void ShadeAxis::notify_periodic_status() {
+    _coil_power->update();
+
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.homed);
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.moving);
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.position);
+}
+
+void ShadeAxis::_notify_position_status() {
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.openned);
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.position_target);
+}
+
+void ShadeAxis::update() {
+    if (_update_fn) _update_fn(false);
+}
+
+void ShadeAxis::handle_property_change(PacketType type) {
+    load();
+
+    // Changes are coalesced per axis, so mode is compared instead of the packet type
+    _setup_endstop();
+
+    if (type == PacketType::SPEED) {
+        if (_state == AppState::MOVING) {
+            _move_speed = _profile_speed(_stepper->getCurrent(), _stepper->getTarget());
+
+            _stepper->setMaxSpeed(_move_speed);
+            _stepper->setTarget(_stepper->getTarget());
+        }
+    }
+}
+
+void ShadeAxis::change_state(AppState s) {
+    _state_change_time = millis();
+    _state = s;
+    TRACE_EVENT(TraceEvent::STATE_CHANGED, _index, s);
+}
+
+void ShadeAxis::open() {
+    move_to(0);
+}
+
+void ShadeAxis::close() {
+    move_to(100);
+}
+
+void ShadeAxis::move_to(float value) {
+    auto k = std::min(std::max(value, 0.0f), 100.f) / 100.f;
+    _runtime_info.position_target = k * 100.f;
+
+    _notify_position_status();
+
+    move_to_step((int32_t) (_config.stepper_calibration.open_position * k));
+}
+
+void ShadeAxis::apply_scene(uint8_t id, const SceneConfig &scene) {
+    TRACE_EVENT(TraceEvent::SCENE_APPLIED, _index, id, scene.position, (uint8_t) scene.speed);
+
+    _runtime_info.scene = id;
+    set_speed(scene.speed);
+}
+
+void ShadeAxis::set_speed(Speed speed) {
+    if (_config.speed == speed) return;
+
+    _config.speed = speed;
+    load();
+
+    NotificationBus::get().notify_parameter_changed(this, _metadata->speed);
+}
+
+Future<void> ShadeAxis::move_async(float value) {
+    move_to(value);
+
+    auto promise = Promise<void>::create();
+    auto timer_id = _timer.add_interval([=, this](auto) {
+        if (promise->finished()) return;
+
+        // Movement is finished either normally, by STOP, or after the drift probe
+        if (_state == AppState::STAND_BY) promise->set_success();
+    }, APP_SERVICE_LOOP_INTERVAL);
+
+    return Future{promise}.finally([this, timer_id](auto &) {
+        _timer.clear_interval(timer_id);
+    });
+}
+
+void ShadeAxis::sunrise(float value, uint32_t duration) {
+    if (_state != AppState::STAND_BY && _state != AppState::SUNRISE) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::SUNRISE, 0, (uint8_t) _state);
+        return;
+    }
+
+    auto k = std::min(std::max(value, 0.0f), 100.f) / 100.f;
+    const auto target = (int32_t) (_config.stepper_calibration.open_position * k);
+
+    if (!_runtime_info.homed) {
+        TRACE_DETAIL(TraceEvent::MOVE_REJECTED, _index, MoveRejectReason::NOT_HOMED, target);
+        return;
+    }
+
+    if (_state == AppState::SUNRISE) _sunrise_stop();
+
+    const int32_t from = _stepper->getCurrent();
+    const auto distance = (uint32_t) std::abs(target - from);
+    if (distance == 0) {
+        TRACE_DETAIL(TraceEvent::MOVE_REJECTED, _index, MoveRejectReason::IN_POSITION, target);
+        return;
+    }
+
+    // As many bursts as the interval allows, but not smaller than SUNRISE_MIN_BURST_STEPS
+    const auto max_bursts = std::max<uint32_t>(1, distance / SUNRISE_MIN_BURST_STEPS);
+    const auto bursts = std::min(std::max<uint32_t>(1, duration / SUNRISE_MIN_BURST_INTERVAL), max_bursts);
+
+    TRACE_EVENT(TraceEvent::MOVE_STARTED, _index, 0, target, from);
+    Metrics::get().axes[_index].moves++;
+
+    _runtime_info.position_target = k * 100.f;
+    _notify_position_status();
+
+    _sunrise = {
+        .start = millis(),
+        .duration = duration,
+        .from = from,
+        .to = target,
+        .bursts = bursts,
+    };
+
+    _runtime_info.moving = true;
+    change_state(AppState::SUNRISE);
+    notify_periodic_status();
+
+    _store_position(false);
+
+    _sunrise_burst();
+}
+
+void ShadeAxis::_sunrise_burst() {
+    _sunrise.timer = -1ul;
+
+    const auto delta = (int64_t) (_sunrise.to - _sunrise.from) * (_sunrise.burst + 1) / _sunrise.bursts;
+    const auto target = _sunrise.from + (int32_t) delta;
+
+    TRACE_DETAIL(TraceEvent::SUNRISE_BURST, _index, _sunrise.burst, target, _stepper->getCurrent());
+
+    // Same speed as the final homing step: slow enough to be quiet and known to be reliable under load
+    _coil_power->activate();
+    _stepper->setMaxSpeed(_config.stepper_config.homing_speed_second);
+    _stepper->setTarget(target);
+}
+
+void ShadeAxis::_sunrise_burst_finished() {
+    _stepper->brake();
+
+    _runtime_info.position = _stepper->getCurrent();
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.position);
+
+    if (++_sunrise.burst >= _sunrise.bursts) {
+        // Finish as a regular move, including the drift probe on full open
+        _drift_probe_pending = _sunrise.to == 0 && _config.stepper_config.drift_check;
+        _sunrise = {};
+
+        change_state(AppState::MOVING);
+        return;
+    }
+
+    _coil_power->settle(true);
+
+    // Burst time is counted from the start, so burst duration and timer latency don't stretch the whole move
+    const auto at = _sunrise.start + (unsigned long) ((uint64_t) _sunrise.duration * _sunrise.burst / _sunrise.bursts);
+    const auto delay = (long) (at - millis());
+
+    _sunrise.timer = _timer.add_timeout([this](auto) { _sunrise_burst(); }, std::max(delay, 0l));
+    if (_sunrise.timer == -1ul) _sunrise_burst();
+}
+
+void ShadeAxis::_sunrise_cancel() {
+    if (_sunrise.timer != -1ul) _timer.clear_timeout(_sunrise.timer);
+    _sunrise = {};
+}
+
+void ShadeAxis::_sunrise_stop() {
+    _sunrise_cancel();
+
+    _stepper->brake();
+    _coil_power->settle();
+
+    _runtime_info.moving = false;
+    _runtime_info.position = _stepper->getCurrent();
+
+    change_state(AppState::STAND_BY);
+
+    notify_periodic_status();
+    _store_position(true);
+}
+
+void ShadeAxis::set_sequence_progress(uint8_t id, uint8_t step) {
+    _runtime_info.sequence = id;
+    _runtime_info.sequence_step = step;
+
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.sequence);
+    NotificationBus::get().notify_parameter_changed(this, _metadata->data.sequence_step);
+}
+
+void ShadeAxis::apply_offset() {
+    if (_state != AppState::STAND_BY) return;
+
+    auto new_offset = _config.stepper_calibration.offset;
+    if (new_offset == _runtime_info.offset) return;
+
+    auto pos = _stepper->getCurrent();
+    auto d_offset = new_offset - _runtime_info.offset;
+    _runtime_info.offset = new_offset;
+
+    _stepper->setCurrent(pos - d_offset);
+    move_to_step(pos);
+}
+
+void ShadeAxis::calibrate() {
+    if (_state != AppState::STAND_BY) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::CALIBRATION, 0, (uint8_t) _state);
+        return;
+    }
+
+    _calibration_info = {};
+    _calibration_info.stage = CalibrationStage::HOMING;
+    _notify_calibration_status();
+
+    auto &cfg = _config.stepper_config;
+
+    homing_async()
+        .then<bool>([this, &cfg](auto &) {
+            D_PRINT("Calibration: Searching bottom position");
+
+            change_state(AppState::CALIBRATION);
+
+            _runtime_info.moving = true;
+            notify_periodic_status();
+
+            _calibration_info.stage = CalibrationStage::BOTTOM_SEARCH;
+            _notify_calibration_status();
+
+            // Movement stops either on user confirmation or on the travel limit
+            _coil_power->activate();
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(cfg.homing_steps_max);
+
+            return homing_move_async(false);
+        })
+        .then<void>([this, &cfg](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<void>::errored();
+
+            if (_stepper->getCurrent() >= cfg.homing_steps_max) {
+                D_PRINT("Calibration failed! Bottom position wasn't confirmed");
+                return Future<void>::errored();
+            }
+
+            _calibration_info.bottom = _stepper->getCurrent();
+            _calibration_info.stage = CalibrationStage::TRAVEL_MEASURE;
+            _notify_calibration_status();
+
+            D_PRINTF("Calibration: Bottom position %d\r\n", _calibration_info.bottom);
+
+            return _calibration_measure_async(0);
+        })
+        .then<void>([this, &cfg](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _calibration_compute_travel();
+
+            _calibration_info.stage = CalibrationStage::SPEED_TEST;
+            _notify_calibration_status();
+
+            // Speed tests start from the open position
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(0);
+
+            return homing_move_async(false);
+        })
+        .then<uint16_t>([this, &cfg](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<uint16_t>::errored();
+
+            D_PRINT("Calibration: Searching close speed");
+
+            return _calibration_search_async(cfg.homing_speed, 0, CALIBRATION_SPEED_LIMIT, [this, &cfg](auto speed) {
+                return _calibration_test_async(speed, cfg.homing_speed, cfg.acceleration);
+            });
+        })
+        .then<uint16_t>([this, &cfg](auto &f) {
+            _calibration_info.suggested_close_speed = (uint16_t) ((float) f.result() * CALIBRATION_SAFETY_FACTOR);
+
+            D_PRINT("Calibration: Searching open speed");
+
+            return _calibration_search_async(cfg.homing_speed, 0, CALIBRATION_SPEED_LIMIT, [this, &cfg](auto speed) {
+                return _calibration_test_async(cfg.homing_speed, speed, cfg.acceleration);
+            });
+        })
+        .then<uint16_t>([this, &cfg](auto &f) {
+            _calibration_info.suggested_open_speed = (uint16_t) ((float) f.result() * CALIBRATION_SAFETY_FACTOR);
+
+            auto close_speed = _calibration_info.suggested_close_speed;
+            auto open_speed = _calibration_info.suggested_open_speed;
+            if (close_speed == 0 || open_speed == 0) return Future<uint16_t>::successful(0);
+
+            D_PRINT("Calibration: Searching acceleration");
+
+            return _calibration_search_async(
+                CALIBRATION_ACCELERATION_MIN, 0, CALIBRATION_ACCELERATION_LIMIT,
+                [this, close_speed, open_speed](auto acceleration) {
+                    return _calibration_test_async(close_speed, open_speed, acceleration);
+                });
+        })
+        .then<void>([this](auto &f) {
+            _calibration_info.suggested_acceleration = (uint16_t) ((float) f.result() * CALIBRATION_SAFETY_FACTOR);
+            _calibration_info.stage = CalibrationStage::DONE;
+
+            D_PRINTF("Calibration: Suggested speed: open %u, close %u, acceleration %u\r\n",
+                     _calibration_info.suggested_open_speed, _calibration_info.suggested_close_speed,
+                     _calibration_info.suggested_acceleration);
+        })
+        .finally([this] {
+            if (_calibration_info.stage != CalibrationStage::DONE) {
+                D_PRINT("Calibration failed!");
+                _calibration_info.stage = CalibrationStage::FAILED;
+            }
+
+            _stepper->setAcceleration(_config.stepper_config.acceleration);
+
+            if (_state == AppState::CALIBRATION) {
+                _stepper->brake();
+                _coil_power->settle();
+
+                _runtime_info.moving = false;
+                _runtime_info.position = _stepper->getCurrent();
+
+                change_state(AppState::STAND_BY);
+
+                notify_periodic_status();
+                _store_position(true);
+            }
+
+            _notify_calibration_status();
+        });
+}
+
+void ShadeAxis::calibration_confirm() {
+    if (_state != AppState::CALIBRATION || _calibration_info.stage != CalibrationStage::BOTTOM_SEARCH) return;
+
+    D_PRINT("Calibration: Bottom position confirmed");
+    _stepper->brake();
+}
+
+void ShadeAxis::calibration_apply() {
+    if (_calibration_info.stage != CalibrationStage::DONE) return;
+    if (_state != AppState::STAND_BY) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::CALIBRATION, 0, (uint8_t) _state);
+        return;
+    }
+
+    auto &calibration = _config.stepper_calibration;
+    auto &calibration_meta = _metadata->stepper_calibration;
+
+    calibration.offset = _calibration_info.suggested_offset;
+    NotificationBus::get().notify_parameter_changed(this, calibration_meta.offset);
+
+    calibration.open_position = _calibration_info.suggested_open_position;
+    NotificationBus::get().notify_parameter_changed(this, calibration_meta.open_position);
+
+    auto &cfg = _config.stepper_config;
+    auto &meta = _metadata->stepper_config;
+
+    if (_calibration_info.suggested_open_speed > 0) {
+        cfg.open_speed = _calibration_info.suggested_open_speed;
+        NotificationBus::get().notify_parameter_changed(this, meta.open_speed);
+    }
+
+    if (_calibration_info.suggested_close_speed > 0) {
+        cfg.close_speed = _calibration_info.suggested_close_speed;
+        NotificationBus::get().notify_parameter_changed(this, meta.close_speed);
+    }
+
+    if (_calibration_info.suggested_acceleration > 0) {
+        cfg.acceleration = _calibration_info.suggested_acceleration;
+        NotificationBus::get().notify_parameter_changed(this, meta.acceleration);
+
+        _stepper->setAcceleration(cfg.acceleration);
+    }
+
+    // Learned factors are relative to the replaced speeds
+    _speed_profile->reset();
+
+    // Position is re-referenced to the new offset without homing
+    apply_offset();
+
+    update();
+}
+
+void ShadeAxis::calibrate_endstop() {
+    if (_state != AppState::STAND_BY || !_analog_endstop || !_runtime_info.homed) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::ENDSTOP_CALIBRATION, 0, (uint8_t) _state);
+        return;
+    }
+
+    D_PRINT("Endstop calibration: Measuring baseline");
+
+    change_state(AppState::CALIBRATION);
+
+    _runtime_info.moving = true;
+    notify_periodic_status();
+    _store_position(false);
+
+    auto &cfg = _config.stepper_config;
+
+    // Endstop position in home coordinates, as it was found by the last homing
+    const int32_t reference = -_runtime_info.offset;
+
+    // Baseline is measured beyond the slowdown zone
+    _coil_power->activate();
+    _stepper->setMaxSpeed(cfg.homing_speed);
+    _stepper->setTarget(reference + 2 * cfg.homing_steps);
+
+    homing_move_async(false)
+        .then<uint16_t>([this](auto &) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<uint16_t>::errored();
+            return _endstop_level_async();
+        })
+        .then<void>([this, &cfg, reference](auto &f) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<bool>::errored();
+
+            _endstop_info.baseline = f.result();
+            D_PRINTF("Endstop calibration: Baseline %u mV, noise %u mV\r\n", _endstop_info.baseline, _endstop_info.noise);
+
+            _stepper->setMaxSpeed(cfg.homing_speed_second);
+            _stepper->setTarget(reference + cfg.homing_steps);
+
+            return homing_move_async(false);
+        })
+        .then<uint16_t>([this](auto &) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<uint16_t>::errored();
+            return _endstop_level_async();
+        })
+        .then<void>([this, &cfg, reference](auto &f) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<bool>::errored();
+
+            _endstop_info.slowdown_level = f.result();
+
+            _stepper->setMaxSpeed(cfg.homing_speed_second);
+            _stepper->setTarget(reference);
+
+            return homing_move_async(false);
+        })
+        .then<uint16_t>([this](auto &) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<uint16_t>::errored();
+            return _endstop_level_async();
+        })
+        .then<void>([this, &cfg](auto &f) {
+            if (_state != AppState::CALIBRATION || !_analog_endstop) return Future<bool>::errored();
+
+            auto &info = _endstop_info;
+            info.trigger_level = f.result();
+
+            D_PRINTF("Endstop calibration: Slowdown %u mV, trigger %u mV\r\n", info.slowdown_level, info.trigger_level);
+
+            const auto noise_margin = (uint16_t) std::max<uint32_t>(ENDSTOP_MIN_HYSTERESIS, info.noise * ENDSTOP_CALIBRATION_NOISE_FACTOR);
+            if (info.trigger_level < info.baseline + std::max<uint32_t>(ENDSTOP_CALIBRATION_MIN_SPAN, 2 * noise_margin)) {
+                D_PRINT("Endstop calibration failed! Field at the endstop is too weak");
+                return Future<bool>::errored();
+            }
+
+            // Weak field at homing_steps distance would make slowdown level indistinguishable from noise
+            const auto slowdown_level = std::clamp<uint32_t>(
+                info.slowdown_level, info.baseline + noise_margin, info.trigger_level - noise_margin);
+
+            auto &endstop = _config.endstop;
+            endstop.slowdown_level = slowdown_level;
+            endstop.trigger_level = info.trigger_level;
+            endstop.hysteresis = std::min<uint16_t>(noise_margin, (info.trigger_level - slowdown_level) / 2);
+
+            auto &meta = _metadata->endstop;
+            NotificationBus::get().notify_parameter_changed(this, meta.slowdown_level);
+            NotificationBus::get().notify_parameter_changed(this, meta.trigger_level);
+            NotificationBus::get().notify_parameter_changed(this, meta.hysteresis);
+
+            update();
+
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(0);
+
+            return homing_move_async(false);
+        })
+        .finally([this] {
+            if (_state != AppState::CALIBRATION) return;
+
+            _stepper->brake();
+            _coil_power->settle();
+
+            _runtime_info.moving = false;
+            _runtime_info.position = _stepper->getCurrent();
+
+            change_state(AppState::STAND_BY);
+
+            notify_periodic_status();
+            _store_position(true);
+        });
+}
+
+Future<uint16_t> ShadeAxis::_endstop_level_async() {
+    _stepper->brake();
+
+    // Coils keep holding, filter settles on the standing position
+    auto promise = Promise<uint16_t>::create();
+    _timer.add_timeout([this, promise](auto) {
+        promise->set_success(_endstop_info.level);
+    }, ENDSTOP_CALIBRATION_SETTLE_TIME);
+
+    return Future{promise};
+}
+
+Future<void> ShadeAxis::_calibration_measure_async(uint8_t iteration) {
+    auto &cfg = _config.stepper_config;
+
+    D_PRINTF("Calibration: Measuring travel, attempt %u\r\n", iteration + 1);
+
+    return endstop_approach_async()
+        .then<void>([this, iteration](auto &f) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _stepper->brake();
+
+            if (!f.result()) {
+                D_PRINT("Calibration failed! Endstop not found");
+                return Future<bool>::errored();
+            }
+
+            const int32_t trigger = _stepper->getCurrent();
+            auto travel = _calibration_info.bottom - trigger;
+            _calibration_info.travel_samples[iteration] = travel;
+            _calibration_info.travel_count = iteration + 1;
+
+            D_PRINTF("Calibration: Travel %d steps\r\n", travel);
+
+            return _endstop_release_async()
+                .then<bool>([this, trigger](auto &f) {
+                    if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+                    _stepper->brake();
+
+                    if (!f.result()) {
+                        D_PRINT("Calibration failed! Endstop not released");
+                        return Future<bool>::errored();
+                    }
+
+                    const int32_t release = _stepper->getCurrent() - trigger;
+                    _calibration_info.release_distance = std::max(_calibration_info.release_distance, release);
+
+                    D_PRINTF("Calibration: Endstop released after %d steps\r\n", release);
+                    return Future<bool>::successful(true);
+                });
+        })
+        .then<void>([this, &cfg](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(_calibration_info.bottom);
+
+            return homing_move_async(false);
+        })
+        .then<void>([this, iteration](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<void>::errored();
+            if (iteration + 1u >= CALIBRATION_REPEAT_COUNT) return Future<void>::successful();
+
+            return _calibration_measure_async(iteration + 1);
+        });
+}
+
+void ShadeAxis::_calibration_compute_travel() {
+    const auto count = _calibration_info.travel_count;
+
+    float sum = 0;
+    for (uint8_t i = 0; i < count; ++i) sum += (float) _calibration_info.travel_samples[i];
+
+    const float mean = sum / (float) count;
+
+    float sq_sum = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        const float diff = (float) _calibration_info.travel_samples[i] - mean;
+        sq_sum += diff * diff;
+    }
+
+    _calibration_info.travel = mean;
+    _calibration_info.travel_deviation = std::sqrt(sq_sum / (float) count);
+
+    D_PRINTF("Calibration: Travel %0.2f ± %0.2f steps\r\n", _calibration_info.travel, _calibration_info.travel_deviation);
+
+    // Open reference is kept past the release point, so the endstop doesn't stay pressed in the open position
+    const auto offset = std::max(1.f, std::round((float) _calibration_info.release_distance * CALIBRATION_OFFSET_FACTOR));
+    _calibration_info.suggested_offset = (int16_t) std::min<float>(offset, INT16_MAX);
+
+    // Travel is measured from the endstop, while open position is counted from the offset
+    _calibration_info.suggested_open_position = (int32_t) std::round(mean) - _calibration_info.suggested_offset;
+
+    D_PRINTF("Calibration: Suggested offset %d, open position %d\r\n",
+             _calibration_info.suggested_offset, _calibration_info.suggested_open_position);
+}
+
+Future<bool> ShadeAxis::_endstop_release_async() {
+    auto &cfg = _config.stepper_config;
+
+    // Back off at the final homing step speed, so the release point is found as precisely as the trigger
+    _stepper->setMaxSpeed(cfg.homing_speed_second);
+    _stepper->setTarget(cfg.homing_steps, RELATIVE);
+
+    auto promise = Promise<bool>::create();
+    auto timer_id = _timer.add_interval([=, this](auto) {
+        if (promise->finished()) return;
+
+        if (!_endstop_pressed || _stepper->getStatus() == 0) {
+            promise->set_success(!_endstop_pressed);
+        }
+    }, APP_SERVICE_LOOP_INTERVAL);
+
+    return Future{promise}.finally([this, timer_id](auto &) {
+        _timer.clear_interval(timer_id);
+    });
+}
+
+Future<bool> ShadeAxis::_calibration_test_async(uint16_t close_speed, uint16_t open_speed, uint16_t acceleration) {
+    auto &cfg = _config.stepper_config;
+
+    D_PRINTF("Calibration: Test close %u, open %u, acceleration %u\r\n", close_speed, open_speed, acceleration);
+
+    _stepper->setAcceleration(acceleration);
+    _stepper->setMaxSpeed(close_speed);
+    // Measured travel isn't applied yet, the test move is limited by it in the current coordinates
+    const auto open_position = (int32_t) std::round(_calibration_info.travel) - _runtime_info.offset;
+    _stepper->setTarget(std::min(CALIBRATION_TEST_DISTANCE, open_position));
+
+    return homing_move_async(false)
+        .then<bool>([this, open_speed](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _stepper->setMaxSpeed(open_speed);
+            _stepper->setTarget(0);
+
+            return homing_move_async(false);
+        })
+        .then<bool>([this](auto &) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _stepper->setAcceleration(_config.stepper_config.acceleration);
+            return endstop_approach_async();
+        })
+        .then<bool>([this, &cfg](auto &f) {
+            if (_state != AppState::CALIBRATION) return Future<bool>::errored();
+
+            _stepper->brake();
+
+            if (!f.result()) {
+                D_PRINT("Calibration failed! Endstop not found");
+                return Future<bool>::errored();
+            }
+
+            const int32_t expected = -_runtime_info.offset;
+            const int32_t drift = _stepper->getCurrent() - expected;
+            const bool passed = std::abs(drift) <= cfg.drift_correction_threshold;
+
+            D_PRINTF("Calibration: Drift %d steps, test %s\r\n", drift, passed ? "passed" : "failed");
+
+            _stepper->setCurrent(expected);
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(0);
+
+            return homing_move_async(false)
+                .then<bool>([passed](auto &) { return Future<bool>::successful(passed); });
+        });
+}
+
+Future<uint16_t> ShadeAxis::_calibration_search_async(uint16_t value, uint16_t passed, uint16_t limit,
+                                                        const CalibrationTestFn &test) {
+    return test(value).then<uint16_t>([this, value, passed, limit, test](auto &f) {
+        if (!f.result()) return Future<uint16_t>::successful(passed);
+        if (value >= limit) return Future<uint16_t>::successful(value);
+
+        auto next = (uint16_t) std::min<float>(limit, std::max((float) value + 1, (float) value * CALIBRATION_SEARCH_FACTOR));
+        return _calibration_search_async(next, value, limit, test);
+    });
+}
+
+void ShadeAxis::move_to_step(int32_t pos) {
+    // Direct move takes over from sunrise at regular speed
+    if (_state == AppState::SUNRISE) _sunrise_stop();
+
+    if (!_runtime_info.homed) {
+        TRACE_DETAIL(TraceEvent::MOVE_REJECTED, _index, MoveRejectReason::NOT_HOMED, pos);
+        return;
+    }
+
+    if (pos == _stepper->getCurrent()) {
+        TRACE_DETAIL(TraceEvent::MOVE_REJECTED, _index, MoveRejectReason::IN_POSITION, pos);
+        return;
+    }
+
+    TRACE_EVENT(TraceEvent::MOVE_STARTED, _index, 0, pos, _stepper->getCurrent());
+    Metrics::get().axes[_index].moves++;
+
+    const bool from_rest = _state == AppState::STAND_BY;
+    if (from_rest) {
+        _coil_power->activate();
+
+        _runtime_info.moving = true;
+        notify_periodic_status();
+        change_state(AppState::MOVING);
+
+        _store_position(false);
+    }
+
+
+    _drift_probe_pending = pos == 0 && _config.stepper_config.drift_check;
+
+    _runtime_info.speed_steps = pos > _runtime_info.position
+                                ? _config.stepper_config.close_speed
+                                : _config.stepper_config.open_speed;
+
+    const auto current = _stepper->getCurrent();
+    _speed_profile->begin_move(current, pos, from_rest);
+
+    const auto acceleration = _config.stepper_config.acceleration * _speed_profile->acceleration_factor(current, pos);
+    _stepper->setAcceleration((uint16_t) std::max(acceleration, 1.f));
+
+    _move_speed = _profile_speed(current, pos);
+
+    _stepper->setMaxSpeed(_move_speed);
+    _stepper->setTarget(pos);
+}
+
+int32_t ShadeAxis::_profile_speed(int32_t position, int32_t target) const {
+    const float speed = _runtime_info.speed_steps * _runtime_info.speed;
+
+    // Slower band has to be entered at its own speed, so bands are checked within the worst case braking distance
+    const auto &profile = _config.speed_profile;
+    const float top_speed = speed * std::max<float>(1.f, (float) profile.max_factor / 100.f);
+    const float acceleration = std::max(1.f, (float) _config.stepper_config.acceleration * (float) profile.min_factor / 100.f);
+    const auto lookahead = (int32_t) (top_speed * top_speed / (2.f * acceleration));
+
+    return std::max((int32_t) (speed * _speed_profile->speed_factor(position, target, lookahead)), STEPPER_MIN_SPEED);
+}
+
+void ShadeAxis::_apply_speed_profile() {
+    if (!_speed_profile->enabled()) return;
+
+    const auto speed = _profile_speed(_stepper->getCurrent(), _stepper->getTarget());
+    if (speed == _move_speed) return;
+
+    _move_speed = speed;
+
+    _stepper->setMaxSpeed(speed);
+    _stepper->setTarget(_stepper->getTarget());
+}
+
+void ShadeAxis::_speed_profile_learned(bool changed, bool lowered, int32_t drift) {
+    if (!changed) return;
+
+    TRACE_EVENT(TraceEvent::SPEED_PROFILE, _index, lowered, drift);
+
+    // Only schedules the save: application holds it while the axis moves, so it's written after the operation finishes
+    update();
+}
+
+void ShadeAxis::reset_speed_profile() {
+    _speed_profile->reset();
+    update();
+}
+
+void ShadeAxis::emergency_stop() {
+    Metrics::get().axes[_index].emergency_stops++;
+
+    _sunrise_cancel();
+
+    _stepper->brake();
+    _coil_power->settle();
+
+    _speed_profile->end_move(_stepper->getCurrent());
+    _stepper->setAcceleration(_config.stepper_config.acceleration);
+
+    _drift_probe_pending = false;
+
+    if (_state != AppState::HOMING) {
+        _runtime_info.moving = false;
+        _runtime_info.position_target = (float) _stepper->getCurrent() / _config.stepper_calibration.open_position * 100.f;
+
+
+        notify_periodic_status();
+        _notify_position_status();
+
+        change_state(AppState::STAND_BY);
+
+        _store_position(true);
+    }
+}
+
+Future<void> ShadeAxis::homing_async() {
+    if (_state != AppState::STAND_BY) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::HOMING, 0, (uint8_t) _state);
+        return Future<void>::errored();
+    }
+
+    change_state(AppState::HOMING);
+
+    auto &metrics = Metrics::get().axes[_index];
+    metrics.homings++;
+
+    const auto homing_start = millis();
+
+    auto &cfg = _config.stepper_config;
+    auto &last_state = _config.stepper_state;
+
+    // Distance to the endstop expected from the last trusted position; 0 means it's unknown
+    int32_t expected_distance = 0;
+    if (cfg.fast_homing && last_state.position_valid) {
+        expected_distance = last_state.position + _config.stepper_calibration.offset;
+        if (expected_distance <= 2 * cfg.fast_homing_margin) expected_distance = 0;
+    }
+
+    _runtime_info.position = 0;
+    _runtime_info.position_target = 0;
+    _runtime_info.homed = false;
+    _runtime_info.moving = true;
+
+    _store_position(false);
+    notify_periodic_status();
+
+    return Future<void>::successful()
+        .then<bool>([this, expected_distance](auto &) {
+            TRACE_EVENT(TraceEvent::HOMING_STAGE, _index, HomingStage::PREPARING, _stepper->getCurrent(), expected_distance);
+
+            _coil_power->activate();
+            _stepper->reset();
+
+            if (_analog_endstop) return _homing_analog_approach_async(true);
+            if (expected_distance > 0) return _homing_fast_approach_async(expected_distance);
+            return _homing_seek_async();
+        })
+        .then<bool>([this, &metrics](auto &f) {
+            if (!f.result()) {
+                TRACE_ERROR(TraceEvent::HOMING_FAILED, _index, HomingFailure::LIMIT_EXCEEDED, _stepper->getCurrent());
+                metrics.homing_limit_failures++;
+                return Future<bool>::errored();
+            }
+
+            // Analog endstop latches at the calibrated level, which is already crossed at the second step speed
+            if (_analog_endstop) return Future<bool>::successful(true);
+
+            return _homing_second_step_async();
+        })
+        .then<void>([this, &metrics](auto &f) {
+            if (!f.result()) {
+                TRACE_ERROR(TraceEvent::HOMING_FAILED, _index, HomingFailure::SECOND_LIMIT_EXCEEDED, _stepper->getCurrent());
+                metrics.homing_limit_failures++;
+                return Future<void>::errored();
+            }
+
+            _stepper->brake();
+            return Future<void>::successful();
+        }).then<void>([this, &cfg](auto &) {
+            TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::APPLY_OFFSET, _stepper->getCurrent());
+
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(_config.stepper_calibration.offset, RELATIVE);
+
+            return homing_move_async(false);
+        }).then<void>([this](auto &) {
+            _runtime_info.homed = true;
+            _runtime_info.offset = _config.stepper_calibration.offset;
+            _stepper->reset();
+
+            // Steps made before homing can't be related to the new reference
+            _speed_profile->reset_exposure();
+
+            _store_position(true);
+
+            TRACE_EVENT(TraceEvent::HOMING_STAGE, _index, HomingStage::SUCCESS, _stepper->getCurrent());
+        })
+        .finally([this, &metrics, homing_start] {
+            _stepper->brake();
+            _coil_power->settle();
+
+            const uint32_t duration = millis() - homing_start;
+            metrics.homing_duration_last = duration;
+            metrics.homing_duration_total += duration;
+
+            _runtime_info.moving = false;
+            notify_periodic_status();
+
+            change_state(AppState::STAND_BY);
+        });
+}
+
+Future<bool> ShadeAxis::_homing_seek_async() {
+    auto &cfg = _config.stepper_config;
+
+    // Go down a little
+    _stepper->setMaxSpeed(cfg.homing_speed);
+    _stepper->setTarget(cfg.homing_steps, RELATIVE);
+
+    return homing_move_async(false)
+        .then<bool>([this, &cfg](auto &) {
+            TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::FIRST_STEP, _stepper->getCurrent());
+
+            // First homing step
+            _stepper->setTarget(-cfg.homing_steps_max, RELATIVE);
+
+            return homing_move_async();
+        });
+}
+
+Future<bool> ShadeAxis::_homing_fast_approach_async(int32_t distance) {
+    auto &cfg = _config.stepper_config;
+
+    TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::FAST_APPROACH, _stepper->getCurrent(), distance);
+
+    // Move at full speed until just short of the expected endstop position
+    _stepper->setMaxSpeed(cfg.open_speed);
+    _stepper->setTarget(-(distance - cfg.fast_homing_margin), RELATIVE);
+
+    return homing_move_async()
+        .then<bool>([this, &cfg](auto &f) {
+            if (f.result()) {
+                TRACE_EVENT(TraceEvent::HOMING_STAGE, _index, HomingStage::EARLY_ENDSTOP, _stepper->getCurrent());
+                return Future<bool>::successful(true);
+            }
+
+            TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::SLOW_APPROACH, _stepper->getCurrent());
+
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(-2 * cfg.fast_homing_margin, RELATIVE);
+
+            return homing_move_async();
+        })
+        .then<bool>([this](auto &f) {
+            if (f.result()) return Future<bool>::successful(true);
+
+            TRACE_EVENT(TraceEvent::HOMING_STAGE, _index, HomingStage::FALLBACK, _stepper->getCurrent());
+            return _homing_seek_async();
+        });
+}
+
+Future<bool> ShadeAxis::_homing_analog_approach_async(bool retreat) {
+    auto &cfg = _config.stepper_config;
+
+    const bool near = _analog_endstop->proximity() != EndstopProximity::FAR;
+    if (near && retreat) {
+        // Start outside of the slowdown zone, so the trigger level is always approached the same way
+        _stepper->setMaxSpeed(cfg.homing_speed);
+        _stepper->setTarget(cfg.homing_steps, RELATIVE);
+
+        return homing_move_async(false)
+            .then<bool>([this](auto &) { return _homing_analog_approach_async(false); });
+    }
+
+    TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::ANALOG_APPROACH, _stepper->getCurrent(), _endstop_info.level);
+
+    // Full speed until proximity slowdown drops to homing_speed_second, see _handle_analog_endstop
+    _stepper->setMaxSpeed(near ? cfg.homing_speed_second : cfg.open_speed);
+    _stepper->setTarget(-cfg.homing_steps_max, RELATIVE);
+
+    return homing_move_async();
+}
+
+Future<bool> ShadeAxis::_homing_second_step_async() {
+    auto &cfg = _config.stepper_config;
+    auto &metrics = Metrics::get().axes[_index];
+
+    TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::REWIND, _stepper->getCurrent());
+    _stepper->brake();
+
+    // Go up a little
+    _stepper->setMaxSpeed(cfg.homing_speed);
+    _stepper->setTarget(cfg.homing_steps, RELATIVE);
+
+    return homing_move_async(false)
+        .then<bool>([this, &cfg, &metrics](auto &f) {
+            if (f.result()) {
+                TRACE_ERROR(TraceEvent::HOMING_FAILED, _index, HomingFailure::ENDSTOP_NOT_RESET, _stepper->getCurrent());
+                metrics.homing_endstop_failures++;
+                return Future<bool>::errored();
+            }
+
+            TRACE_DETAIL(TraceEvent::HOMING_STAGE, _index, HomingStage::SECOND_STEP, _stepper->getCurrent());
+
+            // Second homing step
+            _stepper->setMaxSpeed(cfg.homing_speed_second);
+            _stepper->setTarget((int32_t) (-1.5 * cfg.homing_steps), RELATIVE);
+
+            return homing_move_async();
+        });
+}
+
+Future<bool> ShadeAxis::homing_move_async(bool detect_endstop) {
+    auto promise = Promise<bool>::create();
+    auto timer_id = _timer.add_interval([=, this](auto) {
+        if (promise->finished()) return;
+
+        if ((_endstop_pressed && detect_endstop) || _stepper->getStatus() == 0) {
+            promise->set_success(_endstop_pressed);
+        }
+    }, APP_SERVICE_LOOP_INTERVAL);
+
+    return Future{promise}.finally([this, timer_id](auto &) {
+        _timer.clear_interval(timer_id);
+    });
+}
+
+Future<void> ShadeAxis::drift_probe_async() {
+    if (_state != AppState::STAND_BY && _state != AppState::MOVING) {
+        TRACE_ERROR(TraceEvent::FORBIDDEN, _index, TraceOperation::DRIFT_PROBE, 0, (uint8_t) _state);
+        return Future<void>::errored();
+    }
+
+    change_state(AppState::PROBING);
+
+    auto &cfg = _config.stepper_config;
+
+    // Endstop position in home coordinates, as it was found by homing
+    const int32_t expected = -_runtime_info.offset;
+
+    TRACE_DETAIL(TraceEvent::DRIFT_PROBE, _index, DriftProbeStage::APPROACH, _stepper->getCurrent(), expected);
+
+    return endstop_approach_async()
+        .then<void>([this, &cfg, expected](auto &f) {
+            if (_state != AppState::PROBING) return Future<bool>::errored();
+
+            _stepper->brake();
+
+            const int32_t drift = _stepper->getCurrent() - expected;
+            auto action = f.result() ? _drift_monitor->add(drift) : _drift_monitor->add_missed();
+
+            if (f.result()) {
+                _speed_profile_learned(_speed_profile->observe(drift),
+                                       std::abs(drift) >= cfg.drift_correction_threshold, drift);
+            } else {
+                _speed_profile_learned(_speed_profile->observe_missed(), true, 0);
+            }
+
+            if (action == DriftAction::REHOME) {
+                TRACE_ERROR(TraceEvent::DRIFT_PROBE, _index, DriftProbeStage::REHOME, _stepper->getCurrent(), expected);
+
+                _runtime_info.homed = false;
+                return Future<bool>::errored();
+            }
+
+            if (action == DriftAction::CORRECT) {
+                TRACE_EVENT(TraceEvent::DRIFT_PROBE, _index, DriftProbeStage::CORRECT, _stepper->getCurrent(), expected);
+                _stepper->setCurrent(expected);
+            }
+
+            // Back to the open position
+            _stepper->setMaxSpeed(cfg.homing_speed);
+            _stepper->setTarget(0);
+
+            return homing_move_async(false);
+        })
+        .finally([this] {
+            if (_state != AppState::PROBING) return;
+
+            _stepper->brake();
+            _coil_power->settle();
+
+            _runtime_info.moving = false;
+            _runtime_info.position = _stepper->getCurrent();
+
+            change_state(AppState::STAND_BY);
+
+            notify_periodic_status();
+            _notify_position_status();
+
+            _store_position(true);
+        });
+}
+
+Future<bool> ShadeAxis::endstop_approach_async() {
+    auto &cfg = _config.stepper_config;
+
+    // Endstop position in home coordinates, as it was found by homing
+    const int32_t expected = -_runtime_info.offset;
+    const int32_t slow_approach_from = expected + cfg.homing_steps;
+
+    _coil_power->activate();
+
+    if (_analog_endstop) {
+        // Proximity slowdown takes over near the endstop, so no intermediate stop is needed
+        const bool near = _analog_endstop->proximity() != EndstopProximity::FAR;
+
+        _stepper->setMaxSpeed(near ? cfg.homing_speed_second : cfg.homing_speed);
+        _stepper->setTarget(expected - cfg.drift_rehome_threshold);
+
+        return homing_move_async();
+    }
+
+    if (_stepper->getCurrent() <= slow_approach_from) return _endstop_slow_approach_async();
+
+    _stepper->setMaxSpeed(cfg.homing_speed);
+    _stepper->setTarget(slow_approach_from);
+
+    return homing_move_async()
+        .then<bool>([this](auto &f) {
+            if (f.result()) return Future<bool>::successful(true);
+            return _endstop_slow_approach_async();
+        });
+}
+
+Future<bool> ShadeAxis::_endstop_slow_approach_async() {
+    auto &cfg = _config.stepper_config;
+
+    // Use the same speed as the final homing step, so trigger latency matches the reference
+    _stepper->setMaxSpeed(cfg.homing_speed_second);
+    _stepper->setTarget(-_runtime_info.offset - cfg.drift_rehome_threshold);
+
+    return homing_move_async();
+}
+
+Future<void> ShadeAxis::homing_if_needed() {
+    if (_runtime_info.homed) return Future<void>::successful();
+    if (_state == AppState::HOMING) return Future<void>::errored();
+
+    return homing_async();
+}
+
+void ShadeAxis::endstop_triggered() {
+    if (_endstop_pressed) return;
+
+    _endstop_pressed = true;
+    TRACE_EVENT(TraceEvent::ENDSTOP_TRIGGERED, _index, _state, _stepper->getCurrent());
+
+    if (_state == AppState::MOVING || _state == AppState::SUNRISE) {
+        // Shade is higher than counted, so steps were lost on the way down
+        if (_state == AppState::MOVING) {
+            _speed_profile->end_move(_stepper->getCurrent());
+            _speed_profile_learned(_speed_profile->observe_loss(MoveDirection::CLOSE), true, 0);
+        }
+
+        // Shade stands at the endstop, so the counted position is replaced with the known one before it's stored
+        _stepper->brake();
+        _stepper->setCurrent(-_runtime_info.offset);
+        _runtime_info.position = _stepper->getCurrent();
+
+        emergency_stop();
+    }
+}
+
+void ShadeAxis::endstop_release() {
+    if (!_endstop_pressed) return;
+
+    _endstop_pressed = false;
+    TRACE_DETAIL(TraceEvent::ENDSTOP_RELEASED, _index, 0, _stepper->getCurrent());
+}
+
+void ShadeAxis::service_loop() {
+#ifdef SHADE_SIMULATOR
+    if (_analog_endstop) {
+        uint16_t frame[ENDSTOP_ADC_FRAME_SIZE];
+        _simulator->hall_frame(frame, ENDSTOP_ADC_FRAME_SIZE);
+        _analog_endstop->add_frame(frame, ENDSTOP_ADC_FRAME_SIZE);
+    } else if (_simulator->endstop()) {
+        endstop_triggered();
+    } else {
+        endstop_release();
+    }
+#else
+    if (_endstop) _endstop->handle();
+#endif
+
+    if (_analog_endstop) _handle_analog_endstop();
+    bool moving = _stepper->getStatus() != 0;
+
+    if (_state == AppState::MOVING && moving) {
+        _speed_profile->track(_stepper->getCurrent());
+        _apply_speed_profile();
+    } else if (_state == AppState::MOVING) {
+        _speed_profile->end_move(_stepper->getCurrent());
+        _stepper->setAcceleration(_config.stepper_config.acceleration);
+    }
+
+    if (_state == AppState::MOVING && !moving && _drift_probe_pending) {
+        _drift_probe_pending = false;
+        drift_probe_async();
+    } else if (_state == AppState::MOVING && !moving) {
+        _stepper->brake();
+        _coil_power->settle();
+
+        _runtime_info.moving = false;
+        change_state(AppState::STAND_BY);
+
+        notify_periodic_status();
+        _notify_position_status();
+
+        _store_position(true);
+    } else if (_state == AppState::SUNRISE && !moving && _sunrise.timer == -1ul) {
+        _sunrise_burst_finished();
+    }
+
+    if (_runtime_info.homed && moving) {
+        _runtime_info.position = _stepper->getCurrent();
+    }
+}
+
+void ShadeAxis::_handle_analog_endstop() {
+    const auto proximity = _analog_endstop->proximity();
+
+    if (proximity == EndstopProximity::TRIGGERED) endstop_triggered();
+    else endstop_release();
+
+    const bool near = proximity != EndstopProximity::FAR;
+    const bool entered = near && !_endstop_near;
+    _endstop_near = near;
+
+    if (!entered || _stepper->getStatus() == 0 || _stepper->getTarget() >= _stepper->getCurrent()) return;
+
+    // Endstop searches slow down, so the trigger level is crossed at the same speed as by the last homing.
+    // Regular moves and calibration speed tests aren't affected: open position is usually inside the slowdown zone
+    if (_state == AppState::HOMING || _state == AppState::PROBING) {
+        TRACE_DETAIL(TraceEvent::ENDSTOP_NEAR, _index, _state, _stepper->getCurrent(), _endstop_info.level);
+
+        _stepper->setMaxSpeed(_config.stepper_config.homing_speed_second);
+        _stepper->setTarget(_stepper->getTarget());
+    }
+}
+
+void ShadeAxis::move_notification_loop() {
+    if (_state == AppState::MOVING) {
+        NotificationBus::get().notify_parameter_changed(this, _metadata->data.position);
+    }
+}
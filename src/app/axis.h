@@ -0,0 +1,189 @@
+#pragma once
+
+#include "sys_constants.h"
+
+#include "lib/misc/button.h"
+#include "lib/async/promise.h"
+
+#include "config.h"
+#include "metadata.h"
+#include "cmd.h"
+#include "misc/analog_endstop.h"
+#include "misc/coil_power.h"
+#include "misc/drift_monitor.h"
+#include "misc/event_trace.h"
+#include "misc/metrics.h"
+#include "misc/phase_driver.h"
+#include "misc/speed_profile.h"
+#include "misc/timer_wheel.h"
+
+#ifdef SHADE_SIMULATOR
+#include "misc/shade_simulator.h"
+#endif
+
+#include <GyverStepper2.h>
+
+typedef GStepper2<STEPPER_TYPE, STEPPER_MODE> ShadeStepper;
+
+typedef std::function<Future<bool>(uint16_t value)> CalibrationTestFn;
+typedef std::function<void(bool immediate)> AxisUpdateFn;
+
+struct SunrisePlan {
+    unsigned long start = 0;
+    uint32_t duration = 0;      // ms
+
+    int32_t from = 0;
+    int32_t to = 0;
+
+    uint32_t bursts = 0;
+    uint32_t burst = 0;         // Current burst, targets are interpolated from the start, so rounding doesn't accumulate
+
+    unsigned long timer = -1ul; // Next burst timeout, -1 while burst is in progress
+};
+
+class ShadeAxis {
+    const uint8_t _index;
+
+    TimerWheel &_timer;
+    AxisConfig &_config;
+    AxisPinsConfig &_pins;
+    AxisUpdateFn _update_fn;
+
+    AxisTopics _topics;
+
+    std::unique_ptr<AxisMetadata> _metadata = nullptr;
+    std::unique_ptr<DriftMonitor> _drift_monitor = nullptr;
+    std::unique_ptr<SpeedProfile> _speed_profile = nullptr;
+    std::unique_ptr<Button> _endstop = nullptr;
+    std::unique_ptr<AnalogEndstop> _analog_endstop = nullptr;
+    std::unique_ptr<ShadeStepper> _stepper = nullptr;
+    std::unique_ptr<CoilPowerManager> _coil_power = nullptr;
+
+#ifdef SHADE_SIMULATOR
+    std::unique_ptr<ShadeSimulator> _simulator = nullptr;
+#endif
+
+    RuntimeInfo _runtime_info{};
+    CalibrationInfo _calibration_info{};
+    EndstopInfo _endstop_info{};
+
+    volatile bool _endstop_pressed = false;
+    bool _endstop_near = false;
+    bool _endstop_initialized = false;
+    EndstopMode _endstop_mode = EndstopMode::DIGITAL;
+    bool _drift_probe_pending = false;
+    int32_t _move_speed = 0;
+
+    SunrisePlan _sunrise{};
+
+    unsigned long _state_change_time = 0;
+    AppState _state = AppState::UNINITIALIZED;
+
+public:
+    ShadeAxis(uint8_t index, TimerWheel &timer, AxisConfig &config, AxisPinsConfig &pins, AxisUpdateFn update_fn);
+
+    [[nodiscard]] uint8_t index() const { return _index; }
+    [[nodiscard]] AxisConfig &config() const { return _config; }
+    [[nodiscard]] AxisMetadata &metadata() const { return *_metadata; }
+    [[nodiscard]] const AxisTopics &topics() const { return _topics; }
+    [[nodiscard]] ShadeStepper &stepper() const { return *_stepper; }
+    [[nodiscard]] AppState state() const { return _state; }
+    [[nodiscard]] bool idle() const {
+        // Pauses between sunrise bursts count as idle, so the chip can sleep until the next burst
+        const bool waiting = _state == AppState::STAND_BY || (_state == AppState::SUNRISE && _sunrise.timer != -1ul);
+        return waiting && _coil_power->state() == CoilPowerState::OFF;
+    }
+    [[nodiscard]] bool stepping() const { return _stepper->getStatus() != 0; }
+
+#ifdef SHADE_SIMULATOR
+    [[nodiscard]] ShadeSimulator &simulator() const { return *_simulator; }
+#endif
+
+    void begin();
+    void load();
+    void update();
+
+    void change_state(AppState s);
+    void handle_property_change(PacketType type);
+
+    void open();
+    void close();
+
+    void move_to(float value);
+    void apply_offset();
+
+    void set_speed(Speed speed);
+    void apply_scene(uint8_t id, const SceneConfig &scene);
+
+    Future<void> move_async(float value);
+
+    /**
+     * Moves to the position over given time in sparse bursts, coils are released between them.
+     * Cancelled by any other move or stop.
+     */
+    void sunrise(float value, uint32_t duration);
+    void set_sequence_progress(uint8_t id, uint8_t step);
+
+    void calibrate();
+    void calibration_confirm();
+    void calibration_apply();
+
+    /**
+     * Measures analog endstop levels away from the endstop, at homing_steps from it and at the homed reference,
+     * so analog homing latches where the last homing did.
+     */
+    void calibrate_endstop();
+
+    void reset_speed_profile();
+
+    void emergency_stop();
+
+    Future<void> homing_async();
+    Future<void> homing_if_needed();
+
+    void service_loop();
+    void move_notification_loop();
+    void notify_periodic_status();
+
+protected:
+    void move_to_step(int32_t pos);
+
+    Future<bool> homing_move_async(bool detect_endstop = true);
+
+    Future<void> drift_probe_async();
+    Future<bool> endstop_approach_async();
+
+    void endstop_triggered();
+    void endstop_release();
+
+private:
+    Future<bool> _homing_seek_async();
+    Future<bool> _homing_fast_approach_async(int32_t distance);
+    Future<bool> _homing_analog_approach_async(bool retreat);
+    Future<bool> _homing_second_step_async();
+    Future<bool> _endstop_slow_approach_async();
+
+    void _setup_endstop();
+    void _handle_analog_endstop();
+    Future<uint16_t> _endstop_level_async();
+
+    Future<void> _calibration_measure_async(uint8_t iteration);
+    Future<bool> _calibration_test_async(uint16_t close_speed, uint16_t open_speed, uint16_t acceleration);
+    Future<uint16_t> _calibration_search_async(uint16_t value, uint16_t passed, uint16_t limit, const CalibrationTestFn &test);
+    void _calibration_compute_travel();
+    Future<bool> _endstop_release_async();
+
+    void _sunrise_burst();
+    void _sunrise_burst_finished();
+    void _sunrise_cancel();
+    void _sunrise_stop();
+
+    [[nodiscard]] int32_t _profile_speed(int32_t position, int32_t target) const;
+    void _apply_speed_profile();
+    void _speed_profile_learned(bool changed, bool lowered, int32_t drift);
+
+    void _store_position(bool valid);
+
+    void _notify_position_status();
+    void _notify_calibration_status();
+};
@@ -7,16 +7,45 @@
 #include "credentials.h"
 #include "constants.h"
 
+#include "misc/endstop_config.h"
+#include "misc/group_sync_config.h"
+
 MAKE_ENUM_AUTO(AppState, uint8_t,
     UNINITIALIZED,
     INITIALIZATION,
     STAND_BY,
     HOMING,
-    MOVING
+    MOVING,
+    PROBING,
+    CALIBRATION,
+    SUNRISE
+);
+
+MAKE_ENUM_AUTO(CalibrationStage, uint8_t,
+    IDLE,
+    HOMING,
+    BOTTOM_SEARCH,
+    TRAVEL_MEASURE,
+    SPEED_TEST,
+    DONE,
+    FAILED
 );
 
+static_assert(AXIS_COUNT >= 1 && AXIS_COUNT <= AXIS_MAX_COUNT, "Unsupported axis count");
+
 typedef char ConfigString[CONFIG_STRING_SIZE];
 
+struct __attribute ((packed)) AxisPinsConfig {
+    uint8_t stepper_pin_1;
+    uint8_t stepper_pin_2;
+    uint8_t stepper_pin_3;
+    uint8_t stepper_pin_4;
+    uint8_t stepper_pin_en;
+
+    uint8_t endstop_pin;
+    bool endstop_high_state;
+};
+
 struct __attribute ((packed)) SysConfig {
     ConfigString mdns_name{MDNS_NAME};
 
@@ -27,14 +56,7 @@ struct __attribute ((packed)) SysConfig {
     uint32_t wifi_connection_check_interval = WIFI_CONNECTION_CHECK_INTERVAL;
     uint32_t wifi_max_connection_attempt_interval = WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL;
 
-    uint8_t stepper_pin_1 = STEPPER_PIN_1;
-    uint8_t stepper_pin_2 = STEPPER_PIN_2;
-    uint8_t stepper_pin_3 = STEPPER_PIN_3;
-    uint8_t stepper_pin_4 = STEPPER_PIN_4;
-    uint8_t stepper_pin_en = STEPPER_PIN_EN;
-
-    uint8_t endstop_pin = ENDSTOP_PIN;
-    bool endstop_high_state = ENDSTOP_HIGH_STATE;
+    AxisPinsConfig axis_pins[AXIS_COUNT] = AXIS_PINS;
 
     float time_zone = TIME_ZONE;
 
@@ -50,6 +72,11 @@ struct __attribute ((packed)) NightModeConfig {
 
     uint32_t start_time = 0;
     uint32_t end_time = (uint32_t) 10 * 60 * 60;
+
+    uint8_t start_scene = 0; // 0 - close
+    uint8_t end_scene = 0;   // 0 - open
+
+    uint16_t sunrise_duration = 0; // Minutes to spread the end move over, 0 - regular speed
 };
 
 struct __attribute ((packed)) StepperCalibrationConfig {
@@ -57,6 +84,12 @@ struct __attribute ((packed)) StepperCalibrationConfig {
     int32_t open_position = STEPPER_RESOLUTION * 10;
 };
 
+enum class StepperDriveMode: uint8_t {
+    WAVE = 0,
+    FULL = 1,
+    HALF = 2
+};
+
 struct __attribute ((packed)) StepperConfig {
     bool reverse = false;
 
@@ -71,6 +104,52 @@ struct __attribute ((packed)) StepperConfig {
 
     int32_t homing_steps = 300;
     int32_t homing_steps_max = STEPPER_RESOLUTION * 10;
+
+    bool fast_homing = true;
+    int32_t fast_homing_margin = STEPPER_RESOLUTION / 2;
+
+    bool drift_check = true;
+    uint16_t drift_correction_threshold = 8;
+    uint16_t drift_rehome_threshold = 200;
+
+    StepperDriveMode drive_mode = StepperDriveMode::FULL;
+};
+
+struct __attribute ((packed)) StepperStateConfig {
+    bool position_valid = false;
+    int32_t position = 0;
+};
+
+enum class CoilHoldStrategy: uint8_t {
+    RELEASE = 0,
+    HOLD    = 1,
+    TIMED   = 2,
+    PWM     = 3
+};
+
+struct __attribute ((packed)) CoilPowerConfig {
+    CoilHoldStrategy hold_strategy = CoilHoldStrategy::RELEASE;
+
+    uint16_t hold_time = 5000;
+    uint8_t hold_duty = 30;
+    uint16_t brake_time = 100;
+
+    uint16_t coil_current = 160;
+    uint16_t supply_voltage = 5000;
+};
+
+struct __attribute ((packed)) SpeedProfileConfig {
+    bool enabled = false;
+
+    // Limits of learned factors, % of open / close speed and acceleration
+    uint8_t min_factor = 50;
+    uint8_t max_factor = 150;
+};
+
+struct __attribute ((packed)) SpeedProfileState {
+    // Learned factors per direction (open, close) and travel band, %. Zero means the band has no history yet
+    uint8_t speed[2][SPEED_PROFILE_BANDS]{};
+    uint8_t acceleration[2][SPEED_PROFILE_BANDS]{};
 };
 
 enum class Speed: uint8_t {
@@ -79,14 +158,60 @@ enum class Speed: uint8_t {
     FAST   = 2
 };
 
-struct __attribute ((packed)) Config {
+struct __attribute ((packed)) SceneConfig {
+    char name[SCENE_NAME_SIZE]{};
+
+    uint8_t position = 0;
     Speed speed = Speed::NORMAL;
+};
 
-    StepperCalibrationConfig stepper_calibration{};
-    NightModeConfig night_mode{};
+enum class SequenceOp: uint8_t {
+    END       = 0,
+    MOVE      = 1, // Position, %
+    WAIT      = 2, // Delay, seconds
+    SPEED     = 3, // Speed
+    WAIT_TIME = 4, // Time of day, seconds
+    HOME      = 5
+};
+
+struct __attribute ((packed)) SequenceStep {
+    SequenceOp op = SequenceOp::END;
+    uint32_t arg = 0;
+};
+
+struct __attribute ((packed)) SequenceConfig {
+    SequenceStep steps[SEQUENCE_MAX_STEPS]{};
+};
+
+struct __attribute ((packed)) AxisConfig {
+    Speed speed = Speed::NORMAL;
 
+    StepperCalibrationConfig stepper_calibration{};
     StepperConfig stepper_config{};
+    CoilPowerConfig coil_power{};
+    EndstopConfig endstop{};
+    SpeedProfileConfig speed_profile{};
+
+    StepperStateConfig stepper_state{};
+    SpeedProfileState speed_profile_state{};
+};
+
+struct __attribute ((packed)) Config {
+    AxisConfig axes[AXIS_COUNT]{};
+
+    NightModeConfig night_mode{};
     SysConfig sys_config{};
+
+    GroupSyncConfig group_sync{};
+
+    SceneConfig scenes[SCENE_COUNT]{
+        {"Privacy", 70, Speed::NORMAL},
+        {"Morning", 30, Speed::NORMAL},
+        {"Movie", 100, Speed::SLOW},
+        {"Open", 0, Speed::FAST},
+    };
+
+    SequenceConfig sequences[SEQUENCE_COUNT]{};
 };
 
 struct __attribute ((packed)) RuntimeInfo {
@@ -99,4 +224,37 @@ struct __attribute ((packed)) RuntimeInfo {
 
     float speed = 1;
     int32_t speed_steps = 0;
+
+    uint32_t coil_move_on_time = 0;
+    float coil_move_energy = 0;
+    float coil_total_on_time = 0;
+    float coil_total_energy = 0;
+
+    uint8_t scene = 0;
+
+    uint8_t sequence = 0;
+    uint8_t sequence_step = 0;
+};
+
+struct __attribute ((packed)) ConfigRevision {
+    uint32_t boot_id = 0;   // Random on every start, config could be changed before restart
+    uint32_t revision = 0;  // Incremented on every config change
+};
+
+struct __attribute ((packed)) CalibrationInfo {
+    CalibrationStage stage = CalibrationStage::IDLE;
+
+    int32_t bottom = 0;
+    float travel = 0;
+    float travel_deviation = 0;
+    int32_t release_distance = 0; // Steps from the endstop trigger until it resets, the largest of all attempts
+
+    uint16_t suggested_open_speed = 0;
+    uint16_t suggested_close_speed = 0;
+    uint16_t suggested_acceleration = 0;
+    int16_t suggested_offset = 0;
+    int32_t suggested_open_position = 0;
+
+    uint8_t travel_count = 0;
+    int32_t travel_samples[CALIBRATION_REPEAT_COUNT]{};
 };
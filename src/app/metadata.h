@@ -6,6 +6,13 @@
 #include "app/config.h"
 #include "cmd.h"
 #include "parameter.h"
+#include "misc/analog_endstop.h"
+#include "misc/drift_monitor.h"
+#include "misc/command_trace.h"
+#include "misc/group_sync.h"
+#include "misc/profiler.h"
+#include "misc/sequence.h"
+#include "misc/transaction.h"
 
 DECLARE_META_TYPE(AppMetaProperty, PacketType)
 
@@ -24,21 +31,68 @@ DECLARE_META(StepperConfigMeta, AppMetaProperty,
     MEMBER(Parameter<uint16_t>, homing_speed_second),
     MEMBER(Parameter<int32_t>, homing_steps),
     MEMBER(Parameter<int32_t>, homing_steps_max),
+    MEMBER(Parameter<bool>, fast_homing),
+    MEMBER(Parameter<int32_t>, fast_homing_margin),
+    MEMBER(Parameter<bool>, drift_check),
+    MEMBER(Parameter<uint16_t>, drift_correction_threshold),
+    MEMBER(Parameter<uint16_t>, drift_rehome_threshold),
+    MEMBER(Parameter<uint8_t>, drive_mode),
+)
+
+DECLARE_META(CoilPowerConfigMeta, AppMetaProperty,
+    MEMBER(Parameter<uint8_t>, hold_strategy),
+    MEMBER(Parameter<uint16_t>, hold_time),
+    MEMBER(Parameter<uint8_t>, hold_duty),
+    MEMBER(Parameter<uint16_t>, brake_time),
+    MEMBER(Parameter<uint16_t>, coil_current),
+    MEMBER(Parameter<uint16_t>, supply_voltage),
+)
+
+DECLARE_META(EndstopConfigMeta, AppMetaProperty,
+    MEMBER(Parameter<uint8_t>, mode),
+    MEMBER(Parameter<uint16_t>, slowdown_level),
+    MEMBER(Parameter<uint16_t>, trigger_level),
+    MEMBER(Parameter<uint16_t>, hysteresis),
+)
+
+DECLARE_META(SpeedProfileConfigMeta, AppMetaProperty,
+    MEMBER(Parameter<bool>, enabled),
+    MEMBER(Parameter<uint8_t>, min_factor),
+    MEMBER(Parameter<uint8_t>, max_factor),
 )
 
 DECLARE_META(NightModeConfigMeta, AppMetaProperty,
     MEMBER(Parameter<bool>, enabled),
     MEMBER(Parameter<uint32_t>, start_time),
     MEMBER(Parameter<uint32_t>, end_time),
+    MEMBER(Parameter<uint8_t>, start_scene),
+    MEMBER(Parameter<uint8_t>, end_scene),
+    MEMBER(Parameter<uint16_t>, sunrise_duration),
 )
 
-DECLARE_META(SysConfigMeta, AppMetaProperty,
-    MEMBER(FixedString, mdns_name),
-    MEMBER(Parameter<uint8_t>, wifi_mode),
-    MEMBER(FixedString, wifi_ssid),
-    MEMBER(FixedString, wifi_password),
-    MEMBER(Parameter<uint32_t>, wifi_connection_check_interval),
-    MEMBER(Parameter<uint32_t>, wifi_max_connection_attempt_interval),
+DECLARE_META(SceneConfigMeta, AppMetaProperty,
+    MEMBER(FixedString, name),
+    MEMBER(Parameter<uint8_t>, position),
+    MEMBER(Parameter<uint8_t>, speed),
+)
+
+DECLARE_META(SequenceScriptsMeta, AppMetaProperty,
+    MEMBER(FixedString, sequence_1),
+    MEMBER(FixedString, sequence_2),
+)
+
+static_assert(SEQUENCE_COUNT == 2, "SequenceScriptsMeta must declare every sequence");
+
+static_assert(SCENE_COUNT == 4, "ScenesConfigMeta must declare every scene");
+
+DECLARE_META(ScenesConfigMeta, AppMetaProperty,
+    SUB_TYPE(SceneConfigMeta, scene_1),
+    SUB_TYPE(SceneConfigMeta, scene_2),
+    SUB_TYPE(SceneConfigMeta, scene_3),
+    SUB_TYPE(SceneConfigMeta, scene_4),
+)
+
+DECLARE_META(AxisPinsConfigMeta, AppMetaProperty,
     MEMBER(Parameter<uint8_t>, stepper_pin_1),
     MEMBER(Parameter<uint8_t>, stepper_pin_2),
     MEMBER(Parameter<uint8_t>, stepper_pin_3),
@@ -46,6 +100,22 @@ DECLARE_META(SysConfigMeta, AppMetaProperty,
     MEMBER(Parameter<uint8_t>, stepper_pin_en),
     MEMBER(Parameter<uint8_t>, endstop_pin),
     MEMBER(Parameter<bool>, endstop_high_state),
+)
+
+DECLARE_META(GroupSyncConfigMeta, AppMetaProperty,
+    MEMBER(Parameter<bool>, enabled),
+    MEMBER(Parameter<uint8_t>, group),
+    MEMBER(Parameter<bool>, leader),
+    MEMBER(Parameter<uint16_t>, start_delay),
+)
+
+DECLARE_META(SysConfigMeta, AppMetaProperty,
+    MEMBER(FixedString, mdns_name),
+    MEMBER(Parameter<uint8_t>, wifi_mode),
+    MEMBER(FixedString, wifi_ssid),
+    MEMBER(FixedString, wifi_password),
+    MEMBER(Parameter<uint32_t>, wifi_connection_check_interval),
+    MEMBER(Parameter<uint32_t>, wifi_max_connection_attempt_interval),
     MEMBER(Parameter<float>, time_zone),
     MEMBER(Parameter<bool>, mqtt),
     MEMBER(FixedString, mqtt_host),
@@ -54,34 +124,112 @@ DECLARE_META(SysConfigMeta, AppMetaProperty,
     MEMBER(FixedString, mqtt_password),
 )
 
-DECLARE_META(DataConfigMeta, AppMetaProperty,
-    MEMBER(ComplexParameter<Config>, config),
+DECLARE_META(AxisDataMeta, AppMetaProperty,
     MEMBER(ComplexParameter<RuntimeInfo>, state),
+    MEMBER(ComplexParameter<DriftHistory>, drift),
+    MEMBER(ComplexParameter<CalibrationInfo>, calibration),
+    MEMBER(ComplexParameter<EndstopInfo>, endstop),
+    MEMBER(ComplexParameter<SpeedProfileState>, speed_profile),
 
     MEMBER(Parameter<bool>, homed),
     MEMBER(Parameter<bool>, moving),
     MEMBER(Parameter<int32_t>, position),
+    MEMBER(Parameter<uint8_t>, calibration_stage),
     MEMBER(TargetPositionParameter, position_target),
+    MEMBER(Parameter<uint8_t>, scene),
+    MEMBER(Parameter<uint8_t>, sequence),
+    MEMBER(Parameter<uint8_t>, sequence_step),
 
     MEMBER(GeneratedParameter<bool>, openned)
 )
 
-DECLARE_META(ConfigMetadata, AppMetaProperty,
+DECLARE_META(AxisMetadata, AppMetaProperty,
     MEMBER(Parameter<uint8_t>, speed),
 
     SUB_TYPE(StepperCalibrationConfigMeta, stepper_calibration),
     SUB_TYPE(StepperConfigMeta, stepper_config),
+    SUB_TYPE(CoilPowerConfigMeta, coil_power),
+    SUB_TYPE(EndstopConfigMeta, endstop),
+    SUB_TYPE(SpeedProfileConfigMeta, speed_profile),
+    SUB_TYPE(AxisPinsConfigMeta, pins),
+
+    SUB_TYPE(AxisDataMeta, data),
+)
+
+DECLARE_META(DataConfigMeta, AppMetaProperty,
+    MEMBER(ComplexParameter<Config>, config),
+    MEMBER(ComplexParameter<GroupSyncInfo>, group_sync),
+    MEMBER(ComplexParameter<ProfileInfo>, profile),
+    MEMBER(ComplexParameter<CommandTraceData>, trace),
+    MEMBER(ComplexParameter<ConfigRevision>, revision),
+    MEMBER(ComplexParameter<TransactionStatus>, transaction),
+
+    // Step with syntax error in the last compiled script, 0 if it's valid
+    MEMBER(Parameter<uint8_t>, sequence_1_error),
+    MEMBER(Parameter<uint8_t>, sequence_2_error),
+)
+
+DECLARE_META(TransactionMeta, AppMetaProperty,
+    MEMBER(ComplexParameter<TransactionBatch>, batch),
+)
+
+DECLARE_META(ConfigMetadata, AppMetaProperty,
     SUB_TYPE(NightModeConfigMeta, night_mode),
     SUB_TYPE(SysConfigMeta, sys_config),
+    SUB_TYPE(GroupSyncConfigMeta, group_sync),
+    SUB_TYPE(ScenesConfigMeta, scenes),
+    SUB_TYPE(SequenceScriptsMeta, sequence_scripts),
+    SUB_TYPE(TransactionMeta, transaction),
 
     SUB_TYPE(DataConfigMeta, data),
 )
 
-inline ConfigMetadata build_metadata(Config &config, RuntimeInfo &runtime_info) {
+struct AxisTopics {
+    String open;
+    String open_out;
+
+    String position;
+    String position_out;
+
+    String speed;
+    String speed_out;
+
+    String scene;
+    String scene_out;
+
+    String sequence;
+    String sequence_out;
+};
+
+inline String axis_topic(uint8_t index, const char *topic) {
+    if (index == 0) return topic;
+
+    // Additional axes replace common prefix with own one: /out/position -> /shade2/out/position
+    return String(MQTT_AXIS_PREFIX) + String(index + 1) + String(topic + strlen(MQTT_PREFIX));
+}
+
+inline AxisTopics build_axis_topics(uint8_t index) {
+    return {
+        .open = axis_topic(index, MQTT_TOPIC_OPEN),
+        .open_out = axis_topic(index, MQTT_OUT_TOPIC_OPEN),
+        .position = axis_topic(index, MQTT_TOPIC_POSITION),
+        .position_out = axis_topic(index, MQTT_OUT_TOPIC_POSITION),
+        .speed = axis_topic(index, MQTT_TOPIC_SPEED),
+        .speed_out = axis_topic(index, MQTT_OUT_TOPIC_SPEED),
+        .scene = axis_topic(index, MQTT_TOPIC_SCENE),
+        .scene_out = axis_topic(index, MQTT_OUT_TOPIC_SCENE),
+        .sequence = axis_topic(index, MQTT_TOPIC_SEQUENCE),
+        .sequence_out = axis_topic(index, MQTT_OUT_TOPIC_SEQUENCE),
+    };
+}
+
+inline AxisMetadata build_axis_metadata(AxisConfig &config, AxisPinsConfig &pins, const AxisTopics &topics,
+                                        RuntimeInfo &runtime_info, DriftHistory &drift_history,
+                                        CalibrationInfo &calibration_info, EndstopInfo &endstop_info) {
     return {
         .speed = {
             PacketType::SPEED,
-            MQTT_TOPIC_SPEED, MQTT_OUT_TOPIC_SPEED,
+            topics.speed.c_str(), topics.speed_out.c_str(),
             &config.speed
         },
         .stepper_calibration = {
@@ -130,8 +278,179 @@ inline ConfigMetadata build_metadata(Config &config, RuntimeInfo &runtime_info)
             .homing_steps_max = {
                 PacketType::STEPPER_CONFIG_HOMING_STEPS_MAX,
                 &config.stepper_config.homing_steps_max
+            },
+            .fast_homing = {
+                PacketType::STEPPER_CONFIG_FAST_HOMING,
+                &config.stepper_config.fast_homing
+            },
+            .fast_homing_margin = {
+                PacketType::STEPPER_CONFIG_FAST_HOMING_MARGIN,
+                &config.stepper_config.fast_homing_margin
+            },
+            .drift_check = {
+                PacketType::STEPPER_CONFIG_DRIFT_CHECK,
+                &config.stepper_config.drift_check
+            },
+            .drift_correction_threshold = {
+                PacketType::STEPPER_CONFIG_DRIFT_CORRECTION_THRESHOLD,
+                &config.stepper_config.drift_correction_threshold
+            },
+            .drift_rehome_threshold = {
+                PacketType::STEPPER_CONFIG_DRIFT_REHOME_THRESHOLD,
+                &config.stepper_config.drift_rehome_threshold
+            },
+            .drive_mode = {
+                PacketType::STEPPER_CONFIG_DRIVE_MODE,
+                (uint8_t *) &config.stepper_config.drive_mode
+            }
+        },
+        .coil_power = {
+            .hold_strategy = {
+                PacketType::COIL_POWER_HOLD_STRATEGY,
+                (uint8_t *) &config.coil_power.hold_strategy
+            },
+            .hold_time = {
+                PacketType::COIL_POWER_HOLD_TIME,
+                &config.coil_power.hold_time
+            },
+            .hold_duty = {
+                PacketType::COIL_POWER_HOLD_DUTY,
+                &config.coil_power.hold_duty
+            },
+            .brake_time = {
+                PacketType::COIL_POWER_BRAKE_TIME,
+                &config.coil_power.brake_time
+            },
+            .coil_current = {
+                PacketType::COIL_POWER_COIL_CURRENT,
+                &config.coil_power.coil_current
+            },
+            .supply_voltage = {
+                PacketType::COIL_POWER_SUPPLY_VOLTAGE,
+                &config.coil_power.supply_voltage
+            }
+        },
+        .endstop = {
+            .mode = {
+                PacketType::ENDSTOP_MODE,
+                (uint8_t *) &config.endstop.mode
+            },
+            .slowdown_level = {
+                PacketType::ENDSTOP_SLOWDOWN_LEVEL,
+                &config.endstop.slowdown_level
+            },
+            .trigger_level = {
+                PacketType::ENDSTOP_TRIGGER_LEVEL,
+                &config.endstop.trigger_level
+            },
+            .hysteresis = {
+                PacketType::ENDSTOP_HYSTERESIS,
+                &config.endstop.hysteresis
+            }
+        },
+        .speed_profile = {
+            .enabled = {
+                PacketType::SPEED_PROFILE_ENABLED,
+                &config.speed_profile.enabled
+            },
+            .min_factor = {
+                PacketType::SPEED_PROFILE_MIN_FACTOR,
+                &config.speed_profile.min_factor
+            },
+            .max_factor = {
+                PacketType::SPEED_PROFILE_MAX_FACTOR,
+                &config.speed_profile.max_factor
+            }
+        },
+        .pins = {
+            .stepper_pin_1 = {
+                PacketType::SYS_CONFIG_STEPPER_1_PIN,
+                &pins.stepper_pin_1
+            },
+            .stepper_pin_2 = {
+                PacketType::SYS_CONFIG_STEPPER_2_PIN,
+                &pins.stepper_pin_2
+            },
+            .stepper_pin_3 = {
+                PacketType::SYS_CONFIG_STEPPER_3_PIN,
+                &pins.stepper_pin_3
+            },
+            .stepper_pin_4 = {
+                PacketType::SYS_CONFIG_STEPPER_4_PIN,
+                &pins.stepper_pin_4
+            },
+            .stepper_pin_en = {
+                PacketType::SYS_CONFIG_STEPPER_EN_PIN,
+                &pins.stepper_pin_en
+            },
+            .endstop_pin = {
+                PacketType::SYS_CONFIG_ENDSTOP_PIN,
+                &pins.endstop_pin
+            },
+            .endstop_high_state = {
+                PacketType::SYS_CONFIG_ENDSTOP_HIGH_STATE,
+                &pins.endstop_high_state
+            }
+        },
+
+        .data{
+            .state = ComplexParameter(&runtime_info),
+            .drift = ComplexParameter(&drift_history),
+            .calibration = ComplexParameter(&calibration_info),
+            .endstop = ComplexParameter(&endstop_info),
+            .speed_profile = ComplexParameter(&config.speed_profile_state),
+
+            .homed = Parameter(&runtime_info.homed),
+            .moving = Parameter(&runtime_info.moving),
+            .position = Parameter(&runtime_info.position),
+            .calibration_stage = Parameter((uint8_t *) &calibration_info.stage),
+            .position_target = {
+                PacketType::POSITION_TARGET,
+                topics.position.c_str(), topics.position_out.c_str(),
+                &runtime_info.position_target
+            },
+            .scene = {
+                PacketType::APPLY_SCENE,
+                topics.scene.c_str(), topics.scene_out.c_str(),
+                &runtime_info.scene
+            },
+            .sequence = {
+                PacketType::RUN_SEQUENCE,
+                topics.sequence.c_str(), topics.sequence_out.c_str(),
+                &runtime_info.sequence
+            },
+            .sequence_step = Parameter(&runtime_info.sequence_step),
+
+            .openned = {
+                topics.open_out.c_str(),
+                {[&runtime_info] { return runtime_info.position <= 1; }}
             }
         },
+    };
+}
+
+inline SceneConfigMeta build_scene_metadata(SceneConfig &scene, PacketType name, PacketType position, PacketType speed) {
+    return {
+        .name = {
+            name,
+            {scene.name, SCENE_NAME_SIZE}
+        },
+        .position = {
+            position,
+            &scene.position
+        },
+        .speed = {
+            speed,
+            (uint8_t *) &scene.speed
+        }
+    };
+}
+
+inline ConfigMetadata build_metadata(Config &config, GroupSyncInfo &group_sync_info, ProfileInfo &profile_info,
+                                     CommandTraceData &trace_data, ConfigRevision &config_revision,
+                                     SequenceScript (&sequence_scripts)[SEQUENCE_COUNT], uint8_t (&sequence_errors)[SEQUENCE_COUNT],
+                                     TransactionBatch &transaction_batch, TransactionStatus &transaction_status) {
+    return {
         .night_mode = {
             .enabled = {
                 PacketType::NIGHT_MODE_ENABLED,
@@ -145,6 +464,18 @@ inline ConfigMetadata build_metadata(Config &config, RuntimeInfo &runtime_info)
             .end_time = {
                 PacketType::NIGHT_MODE_END,
                 &config.night_mode.end_time
+            },
+            .start_scene = {
+                PacketType::NIGHT_MODE_START_SCENE,
+                &config.night_mode.start_scene
+            },
+            .end_scene = {
+                PacketType::NIGHT_MODE_END_SCENE,
+                &config.night_mode.end_scene
+            },
+            .sunrise_duration = {
+                PacketType::NIGHT_MODE_SUNRISE_DURATION,
+                &config.night_mode.sunrise_duration
             }
         },
         .sys_config = {
@@ -172,34 +503,6 @@ inline ConfigMetadata build_metadata(Config &config, RuntimeInfo &runtime_info)
                 PacketType::SYS_CONFIG_WIFI_MAX_CONNECTION_ATTEMPT_INTERVAL,
                 &config.sys_config.wifi_max_connection_attempt_interval
             },
-            .stepper_pin_1 = {
-                PacketType::SYS_CONFIG_STEPPER_1_PIN,
-                &config.sys_config.stepper_pin_1
-            },
-            .stepper_pin_2 = {
-                PacketType::SYS_CONFIG_STEPPER_2_PIN,
-                &config.sys_config.stepper_pin_2
-            },
-            .stepper_pin_3 = {
-                PacketType::SYS_CONFIG_STEPPER_3_PIN,
-                &config.sys_config.stepper_pin_3
-            },
-            .stepper_pin_4 = {
-                PacketType::SYS_CONFIG_STEPPER_4_PIN,
-                &config.sys_config.stepper_pin_4
-            },
-            .stepper_pin_en = {
-                PacketType::SYS_CONFIG_STEPPER_EN_PIN,
-                &config.sys_config.stepper_pin_en
-            },
-            .endstop_pin = {
-                PacketType::SYS_CONFIG_ENDSTOP_PIN,
-                &config.sys_config.endstop_pin
-            },
-            .endstop_high_state = {
-                PacketType::SYS_CONFIG_ENDSTOP_HIGH_STATE,
-                &config.sys_config.endstop_high_state
-            },
             .time_zone = {
                 PacketType::SYS_CONFIG_TIME_ZONE,
                 &config.sys_config.time_zone
@@ -225,24 +528,60 @@ inline ConfigMetadata build_metadata(Config &config, RuntimeInfo &runtime_info)
                 {config.sys_config.mqtt_password, CONFIG_STRING_SIZE}
             },
         },
+        .group_sync = {
+            .enabled = {
+                PacketType::GROUP_SYNC_ENABLED,
+                &config.group_sync.enabled
+            },
+            .group = {
+                PacketType::GROUP_SYNC_GROUP,
+                &config.group_sync.group
+            },
+            .leader = {
+                PacketType::GROUP_SYNC_LEADER,
+                &config.group_sync.leader
+            },
+            .start_delay = {
+                PacketType::GROUP_SYNC_START_DELAY,
+                &config.group_sync.start_delay
+            }
+        },
+        .scenes = {
+            .scene_1 = build_scene_metadata(config.scenes[0], PacketType::SCENE_1_NAME,
+                                            PacketType::SCENE_1_POSITION, PacketType::SCENE_1_SPEED),
+            .scene_2 = build_scene_metadata(config.scenes[1], PacketType::SCENE_2_NAME,
+                                            PacketType::SCENE_2_POSITION, PacketType::SCENE_2_SPEED),
+            .scene_3 = build_scene_metadata(config.scenes[2], PacketType::SCENE_3_NAME,
+                                            PacketType::SCENE_3_POSITION, PacketType::SCENE_3_SPEED),
+            .scene_4 = build_scene_metadata(config.scenes[3], PacketType::SCENE_4_NAME,
+                                            PacketType::SCENE_4_POSITION, PacketType::SCENE_4_SPEED),
+        },
+        .sequence_scripts = {
+            .sequence_1 = {
+                PacketType::SEQUENCE_1_SCRIPT,
+                {sequence_scripts[0], SEQUENCE_SCRIPT_SIZE}
+            },
+            .sequence_2 = {
+                PacketType::SEQUENCE_2_SCRIPT,
+                {sequence_scripts[1], SEQUENCE_SCRIPT_SIZE}
+            }
+        },
+        .transaction = {
+            .batch = {
+                PacketType::TX_SET,
+                ComplexParameter(&transaction_batch)
+            }
+        },
 
         .data{
             .config = ComplexParameter(&config),
-            .state = ComplexParameter(&runtime_info),
-
-            .homed = Parameter(&runtime_info.homed),
-            .moving = Parameter(&runtime_info.moving),
-            .position = Parameter(&runtime_info.position),
-            .position_target = {
-                PacketType::POSITION_TARGET,
-                MQTT_TOPIC_POSITION, MQTT_OUT_TOPIC_POSITION,
-                &runtime_info.position_target
-            },
-
-            .openned = {
-                MQTT_OUT_TOPIC_OPEN,
-                {[&runtime_info] { return runtime_info.position <= 1; }}
-            }
+            .group_sync = ComplexParameter(&group_sync_info),
+            .profile = ComplexParameter(&profile_info),
+            .trace = ComplexParameter(&trace_data),
+            .revision = ComplexParameter(&config_revision),
+            .transaction = ComplexParameter(&transaction_status),
+            .sequence_1_error = Parameter(&sequence_errors[0]),
+            .sequence_2_error = Parameter(&sequence_errors[1]),
         },
     };
 }
@@ -0,0 +1,110 @@
+#include "sequence_runner.h"
+
+void SequenceRunner::run(uint8_t id, const SequenceConfig &sequence) {
+    cancel();
+
+    if (sequence.steps[0].op == SequenceOp::END) {
+        D_PRINTF("Sequence %u: Empty\r\n", id);
+        return;
+    }
+
+    D_PRINTF("Sequence %u: Started\r\n", id);
+
+    _sequence = sequence;
+    _id = id;
+
+    const auto generation = _generation;
+    _run_step_async(0, generation).finally([this, id, generation] {
+        if (generation != _generation) return;
+
+        D_PRINTF("Sequence %u: Finished\r\n", id);
+
+        _id = 0;
+        _axis.set_sequence_progress(0, 0);
+    });
+}
+
+void SequenceRunner::cancel() {
+    if (!running()) return;
+
+    D_PRINTF("Sequence %u: Cancelled\r\n", _id);
+
+    ++_generation;
+    _id = 0;
+
+    // Pending wait never resolves, the chain of the cancelled run is released with it
+    if (_wait_timer != -1ul) {
+        _timer.clear_timeout(_wait_timer);
+        _wait_timer = -1ul;
+    }
+
+    _axis.set_sequence_progress(0, 0);
+}
+
+Future<void> SequenceRunner::_run_step_async(uint8_t index, uint32_t generation) {
+    if (generation != _generation) return Future<void>::errored();
+
+    if (index >= SEQUENCE_MAX_STEPS || _sequence.steps[index].op == SequenceOp::END) {
+        return Future<void>::successful();
+    }
+
+    _axis.set_sequence_progress(_id, index + 1);
+
+    return _execute_async(_sequence.steps[index])
+        .then<void>([this, index, generation](auto &) {
+            return _run_step_async(index + 1, generation);
+        });
+}
+
+Future<void> SequenceRunner::_execute_async(const SequenceStep &step) {
+    const uint32_t arg = step.arg;
+
+    switch (step.op) {
+        case SequenceOp::MOVE:
+            return _axis.homing_if_needed().then<void>([this, arg](auto &) {
+                return _axis.move_async((float) arg);
+            });
+
+        case SequenceOp::WAIT:
+            // Compiled steps are stored in the config, ones saved before the compiler bounded waits are clamped here
+            return _wait_async((unsigned long) std::min<uint64_t>((uint64_t) arg * 1000, (uint64_t) SEQUENCE_MAX_WAIT * 1000));
+
+        case SequenceOp::SPEED:
+            _axis.set_speed((Speed) arg);
+            return Future<void>::successful();
+
+        case SequenceOp::WAIT_TIME:
+            return _wait_time_async(arg);
+
+        case SequenceOp::HOME:
+            return _axis.homing_async();
+
+        default:
+            return Future<void>::errored();
+    }
+}
+
+Future<void> SequenceRunner::_wait_async(unsigned long delay) {
+    auto promise = Promise<void>::create();
+
+    _wait_timer = _timer.add_timeout([this, promise](auto) {
+        _wait_timer = -1ul;
+        promise->set_success();
+    }, delay);
+
+    return Future{promise};
+}
+
+Future<void> SequenceRunner::_wait_time_async(uint32_t time_of_day) {
+    if (!_ntp_time.available()) {
+        D_PRINT("Sequence: Time not available");
+        return Future<void>::errored();
+    }
+
+    const auto now = _ntp_time.epoch_tz() - _ntp_time.today_tz();
+    const auto delay = (time_of_day + NtpTime::SECONDS_PER_DAY - now) % NtpTime::SECONDS_PER_DAY;
+
+    D_PRINTF("Sequence: Waiting %lu sec\r\n", delay);
+
+    return _wait_async((unsigned long) ((uint64_t) delay * 1000));
+}
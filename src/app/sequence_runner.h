@@ -0,0 +1,37 @@
+#pragma once
+
+#include "lib/misc/ntp_time.h"
+#include "lib/async/promise.h"
+
+#include "axis.h"
+#include "config.h"
+#include "misc/timer_wheel.h"
+
+class SequenceRunner {
+    TimerWheel &_timer;
+    NtpTime &_ntp_time;
+    ShadeAxis &_axis;
+
+    SequenceConfig _sequence{};
+    uint8_t _id = 0;
+
+    // Incremented on cancel, so continuations of the cancelled run stop at the next step
+    uint32_t _generation = 0;
+    unsigned long _wait_timer = -1ul;
+
+public:
+    SequenceRunner(TimerWheel &timer, NtpTime &ntp_time, ShadeAxis &axis) :
+        _timer(timer), _ntp_time(ntp_time), _axis(axis) {}
+
+    [[nodiscard]] bool running() const { return _id != 0; }
+
+    void run(uint8_t id, const SequenceConfig &sequence);
+    void cancel();
+
+private:
+    Future<void> _run_step_async(uint8_t index, uint32_t generation);
+    Future<void> _execute_async(const SequenceStep &step);
+
+    Future<void> _wait_async(unsigned long delay);
+    Future<void> _wait_time_async(uint32_t time_of_day);
+};
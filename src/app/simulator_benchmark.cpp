@@ -0,0 +1,69 @@
+#ifdef SHADE_SIMULATOR
+
+#include "simulator_benchmark.h"
+
+Future<void> SimulatorBenchmark::run_async() {
+    _report = {};
+    _completed = false;
+
+    _axis.simulator().reset_stats();
+    _axis.simulator().reset_noise();
+
+    D_PRINT("Benchmark: Homing");
+    _stage_start = millis();
+
+    return _axis.homing_async()
+        .then<void>([this](auto &) {
+            _report.homing_time = millis() - _stage_start;
+            _baseline_error = _position_error();
+
+            D_PRINT("Benchmark: Full close");
+            _stage_start = millis();
+
+            return _axis.move_async(100);
+        })
+        .then<void>([this](auto &) {
+            _report.close_time = millis() - _stage_start;
+
+            D_PRINT("Benchmark: Full open");
+            _stage_start = millis();
+
+            return _axis.move_async(0);
+        })
+        .then<void>([this](auto &) {
+            _report.open_time = millis() - _stage_start;
+            _report.position_error = _position_error() - _baseline_error;
+
+            _completed = true;
+        })
+        .finally([this] {
+            const auto &stats = _axis.simulator().stats();
+            _report.steps = stats.steps;
+            _report.lost_steps = stats.lost_steps;
+            _report.max_torque = stats.max_torque;
+
+            if (!_completed) D_PRINT("Benchmark failed!");
+
+            _print_report();
+        });
+}
+
+int32_t SimulatorBenchmark::_position_error() const {
+    return _axis.stepper().getCurrent() - _axis.simulator().position();
+}
+
+void SimulatorBenchmark::_print_report() const {
+    const auto &cfg = _axis.config().stepper_config;
+
+    D_PRINTF("Benchmark: Config open %u, close %u, acceleration %u, homing %u / %u\r\n",
+             cfg.open_speed, cfg.close_speed, cfg.acceleration, cfg.homing_speed, cfg.homing_speed_second);
+
+    D_PRINTF("Benchmark: Homing %lu ms, close %lu ms, open %lu ms\r\n",
+             (unsigned long) _report.homing_time, (unsigned long) _report.close_time, (unsigned long) _report.open_time);
+
+    D_PRINTF("Benchmark: Position error %ld steps, lost %lu of %lu steps, max torque %0.2f\r\n",
+             (long) _report.position_error, (unsigned long) _report.lost_steps, (unsigned long) _report.steps,
+             _report.max_torque);
+}
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef SHADE_SIMULATOR
+
+#include "lib/async/promise.h"
+
+#include "axis.h"
+
+struct SimulatorBenchmarkReport {
+    uint32_t homing_time = 0;   // ms
+    uint32_t close_time = 0;    // ms
+    uint32_t open_time = 0;     // ms
+
+    int32_t position_error = 0; // Steps between planned and simulated position after full travel
+    uint32_t steps = 0;
+    uint32_t lost_steps = 0;
+    float max_torque = 0;
+};
+
+/**
+ * Runs homing and a full close / open cycle on the simulated mechanism and reports timings and accuracy
+ * for the current StepperConfig.
+ */
+class SimulatorBenchmark {
+    ShadeAxis &_axis;
+
+    SimulatorBenchmarkReport _report{};
+
+    unsigned long _stage_start = 0;
+    int32_t _baseline_error = 0;
+    bool _completed = false;
+
+public:
+    explicit SimulatorBenchmark(ShadeAxis &axis) : _axis(axis) {}
+
+    [[nodiscard]] const SimulatorBenchmarkReport &report() const { return _report; }
+
+    Future<void> run_async();
+
+private:
+    [[nodiscard]] int32_t _position_error() const;
+
+    void _print_report() const;
+};
+
+#endif
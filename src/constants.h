@@ -12,6 +12,8 @@
 
 #define MDNS_NAME                               "esp_shades"
 
+#define AXIS_COUNT                              (1)                     // Number of shades driven by this controller
+
 #define STEPPER_PIN_1                           (10)
 #define STEPPER_PIN_2                           (6)
 #define STEPPER_PIN_3                           (7)
@@ -22,8 +24,15 @@
 #define ENDSTOP_PIN                             (20)
 #define ENDSTOP_HIGH_STATE                      (false)
 
+// Pins of each shade: stepper 1-4, stepper enable, endstop, endstop high state. One entry per axis
+#define AXIS_PINS                               { \
+    {STEPPER_PIN_1, STEPPER_PIN_2, STEPPER_PIN_3, STEPPER_PIN_4, STEPPER_PIN_EN, ENDSTOP_PIN, ENDSTOP_HIGH_STATE}, \
+}
+
 #define TIME_ZONE                               (5.f)                   // GMT +5:00
 
+#define GROUP_SYNC_DEFAULT_START_DELAY          (300u)                  // Lead time (ms) given to group members before synchronized move starts
+
 #define MQTT                                    (0)                     // Enable MQTT server
 
 #define MQTT_CONNECTION_TIMEOUT                 (15000u)                // Connection attempt timeout to MQTT server
@@ -36,9 +45,19 @@
 #define MQTT_TOPIC_POSITION                     MQTT_PREFIX "/position"
 #define MQTT_TOPIC_SPEED                        MQTT_PREFIX "/speed"
 #define MQTT_TOPIC_NIGHT_MODE                   MQTT_PREFIX "/night_mode"
+#define MQTT_TOPIC_SCENE                        MQTT_PREFIX "/scene"
+#define MQTT_TOPIC_SEQUENCE                     MQTT_PREFIX "/sequence"
+
+#define MQTT_AXIS_PREFIX                        MQTT_PREFIX "/shade"    // Additional shades use own prefix: /shade2/position, /shade2/out/position
 
 #define MQTT_OUT_PREFIX                         MQTT_PREFIX "/out"
 #define MQTT_OUT_TOPIC_OPEN                     MQTT_OUT_PREFIX "/open"
 #define MQTT_OUT_TOPIC_POSITION                 MQTT_OUT_PREFIX "/position"
 #define MQTT_OUT_TOPIC_SPEED                    MQTT_OUT_PREFIX "/speed"
 #define MQTT_OUT_TOPIC_NIGHT_MODE               MQTT_OUT_PREFIX "/night_mode"
+#define MQTT_OUT_TOPIC_SCENE                    MQTT_OUT_PREFIX "/scene"
+#define MQTT_OUT_TOPIC_SEQUENCE                 MQTT_OUT_PREFIX "/sequence"
+#define MQTT_OUT_TOPIC_AVAILABILITY             MQTT_OUT_PREFIX "/availability"   // "online" / "offline", published as last will
+
+#define MQTT_DISCOVERY                          (true)                  // Publish Home Assistant discovery config for every shade
+#define MQTT_DISCOVERY_PREFIX                   "homeassistant"
@@ -0,0 +1,131 @@
+#include "adc_sampler.h"
+
+#include "lib/debug.h"
+
+AdcSampler AdcSampler::_instance{};
+
+bool AdcSampler::add(uint8_t pin, AnalogEndstop &endstop) {
+    const auto channel = digitalPinToAnalogChannel(pin);
+
+    // Continuous mode reads ADC1 only, ADC2 is shared with Wi-Fi
+    if (channel < 0 || channel >= SOC_ADC_MAX_CHANNEL_NUM || _count >= _channels.size()) {
+        D_PRINTF("ADC Sampler: Pin %u can't be sampled\r\n", pin);
+        return false;
+    }
+
+    remove(pin);
+
+    _channels[_count++] = {.pin = pin, .channel = (uint8_t) channel, .endstop = &endstop};
+    _restart();
+
+    return true;
+}
+
+void AdcSampler::remove(uint8_t pin) {
+    for (uint8_t i = 0; i < _count; ++i) {
+        if (_channels[i].pin != pin) continue;
+
+        _channels[i] = _channels[--_count];
+        _channels[_count] = {};
+
+        _restart();
+
+        // Let the pin be used as digital input again
+        pinMode(pin, INPUT);
+        return;
+    }
+}
+
+void AdcSampler::handle() {
+    if (!_running) return;
+
+    uint8_t buffer[ENDSTOP_ADC_FRAME_SIZE * SOC_ADC_DIGI_RESULT_BYTES];
+    uint32_t length = 0;
+
+    while (true) {
+        const auto ret = adc_digi_read_bytes(buffer, sizeof(buffer), &length, 0);
+
+        // Overflow only means frames were lost while the loop was busy, remaining data is valid
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) break;
+        if (length == 0) break;
+
+        for (uint32_t offset = 0; offset + SOC_ADC_DIGI_RESULT_BYTES <= length; offset += SOC_ADC_DIGI_RESULT_BYTES) {
+            const auto *result = (const adc_digi_output_data_t *) &buffer[offset];
+
+            for (uint8_t i = 0; i < _count; ++i) {
+                auto &ch = _channels[i];
+                if (ch.channel != result->type2.channel) continue;
+
+                ch.samples[ch.count++] = (uint16_t) esp_adc_cal_raw_to_voltage(result->type2.data, &_characteristics);
+                if (ch.count == ch.samples.size()) {
+                    ch.endstop->add_frame(ch.samples.data(), ch.count);
+                    ch.count = 0;
+                }
+
+                break;
+            }
+        }
+    }
+}
+
+void AdcSampler::_restart() {
+    _stop();
+
+    if (_count == 0) return;
+
+    adc_digi_pattern_config_t patterns[AXIS_MAX_COUNT]{};
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < _count; ++i) {
+        mask |= 1u << _channels[i].channel;
+
+        patterns[i] = {
+            .atten = ADC_ATTEN_DB_11,
+            .channel = _channels[i].channel,
+            .unit = 0,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+
+    // DMA interrupt fires once per frame of every channel, driver buffer holds a few of them
+    const uint32_t frame_bytes = ENDSTOP_ADC_FRAME_SIZE * SOC_ADC_DIGI_RESULT_BYTES * _count;
+
+    adc_digi_init_config_t init_config{
+        .max_store_buf_size = frame_bytes * 4,
+        .conv_num_each_intr = frame_bytes,
+        .adc1_chan_mask = mask,
+        .adc2_chan_mask = 0,
+    };
+
+    adc_digi_configuration_t config{
+        .conv_limit_en = false,
+        .conv_limit_num = 250,
+        .pattern_num = _count,
+        .adc_pattern = patterns,
+        .sample_freq_hz = ENDSTOP_ADC_SAMPLE_RATE,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+
+    if (adc_digi_initialize(&init_config) != ESP_OK
+        || adc_digi_controller_configure(&config) != ESP_OK
+        || adc_digi_start() != ESP_OK) {
+        D_PRINT("ADC Sampler: Unable to start continuous mode");
+        adc_digi_deinitialize();
+        return;
+    }
+
+    esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 0, &_characteristics);
+
+    for (uint8_t i = 0; i < _count; ++i) _channels[i].count = 0;
+    _running = true;
+}
+
+void AdcSampler::_stop() {
+    if (!_running) return;
+
+    adc_digi_stop();
+    adc_digi_deinitialize();
+
+    _running = false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+#include <array>
+#include <cstdint>
+
+#include "analog_endstop.h"
+
+#include "sys_constants.h"
+
+/**
+ * Samples analog endstops continuously with ADC DMA (ADC1, all channels in one pattern).
+ * Frames are drained from the event loop by handle(), so sampling never waits for the loop and nothing is read in ISR.
+ */
+class AdcSampler {
+    struct Channel {
+        uint8_t pin = 0;
+        uint8_t channel = 0;
+        AnalogEndstop *endstop = nullptr;
+
+        uint16_t count = 0;
+        std::array<uint16_t, ENDSTOP_ADC_FRAME_SIZE> samples{};
+    };
+
+    std::array<Channel, AXIS_MAX_COUNT> _channels{};
+    uint8_t _count = 0;
+
+    esp_adc_cal_characteristics_t _characteristics{};
+    bool _running = false;
+
+    static AdcSampler _instance;
+
+public:
+    static AdcSampler &get() { return _instance; }
+
+    bool add(uint8_t pin, AnalogEndstop &endstop);
+    void remove(uint8_t pin);
+
+    void handle();
+
+private:
+    void _restart();
+    void _stop();
+};
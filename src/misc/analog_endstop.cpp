@@ -0,0 +1,65 @@
+#include "analog_endstop.h"
+
+#include <algorithm>
+#include <cmath>
+
+AnalogEndstop::AnalogEndstop(const EndstopConfig &config, bool rising, EndstopInfo &info) :
+    _config(config), _rising(rising), _info(info) {
+    // Calibration results are kept, live values start over
+    _info.proximity = EndstopProximity::FAR;
+    _info.level = 0;
+    _info.noise = 0;
+    _info.frames = 0;
+}
+
+void AnalogEndstop::add_frame(uint16_t *samples, size_t count) {
+    if (count == 0) return;
+
+    auto middle = samples + count / 2;
+    std::nth_element(samples, middle, samples + count);
+
+    float median = *middle;
+    if (!_rising) median = (float) ENDSTOP_ADC_MAX_VOLTAGE - std::min(median, (float) ENDSTOP_ADC_MAX_VOLTAGE);
+
+    if (_level < 0) {
+        _level = median;
+    } else {
+        _noise += (std::abs(median - _level) - _noise) * ENDSTOP_FILTER_FACTOR;
+        _level += (median - _level) * ENDSTOP_FILTER_FACTOR;
+    }
+
+    _info.level = (uint16_t) _level;
+    _info.noise = (uint16_t) std::ceil(_noise);
+    _info.frames++;
+
+    _update_proximity();
+}
+
+void AnalogEndstop::_update_proximity() {
+    const int32_t level = _info.level;
+    const int32_t trigger_level = _config.trigger_level;
+    const int32_t slowdown_level = _config.slowdown_level;
+    const int32_t hysteresis = _config.hysteresis;
+
+    const auto release_level = trigger_level - hysteresis;
+    const auto far_level = slowdown_level - hysteresis;
+
+    // Both thresholds have hysteresis, so noise around them doesn't toggle state
+    switch (_info.proximity) {
+        case EndstopProximity::TRIGGERED:
+            if (level < far_level) _info.proximity = EndstopProximity::FAR;
+            else if (level < release_level) _info.proximity = EndstopProximity::NEAR;
+            break;
+
+        case EndstopProximity::NEAR:
+            if (level >= trigger_level) _info.proximity = EndstopProximity::TRIGGERED;
+            else if (level < far_level) _info.proximity = EndstopProximity::FAR;
+            break;
+
+        case EndstopProximity::FAR:
+        default:
+            if (level >= trigger_level) _info.proximity = EndstopProximity::TRIGGERED;
+            else if (level >= slowdown_level) _info.proximity = EndstopProximity::NEAR;
+            break;
+    }
+}
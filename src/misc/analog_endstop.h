@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "endstop_config.h"
+#include "sys_constants.h"
+
+MAKE_ENUM(EndstopProximity, uint8_t,
+    FAR, 0,
+    NEAR, 1,
+    TRIGGERED, 2,
+)
+
+struct __attribute ((packed)) EndstopInfo {
+    EndstopProximity proximity = EndstopProximity::FAR;
+
+    uint16_t level = 0;         // Filtered output, mV
+    uint16_t noise = 0;         // Mean deviation of frame medians from the filtered level, mV
+    uint32_t frames = 0;
+
+    // Last endstop calibration, mV
+    uint16_t baseline = 0;
+    uint16_t slowdown_level = 0;
+    uint16_t trigger_level = 0;
+};
+
+/**
+ * Turns analog Hall sensor samples into a filtered field level and endstop proximity.
+ * Every frame is reduced to its median, which drops single-sample spikes, and the medians are smoothed with EMA.
+ * Doesn't access hardware: frames come from AdcSampler or from the simulator's synthetic trace.
+ */
+class AnalogEndstop {
+    const EndstopConfig &_config;
+    const bool _rising;
+
+    EndstopInfo &_info;
+
+    float _level = -1;
+    float _noise = 0;
+
+public:
+    AnalogEndstop(const EndstopConfig &config, bool rising, EndstopInfo &info);
+
+    [[nodiscard]] EndstopInfo &info() { return _info; }
+    [[nodiscard]] EndstopProximity proximity() const { return _info.proximity; }
+    [[nodiscard]] uint16_t level() const { return _info.level; }
+    [[nodiscard]] uint16_t noise() const { return _info.noise; }
+
+    /**
+     * @param samples Sensor output, mV. Buffer is reordered.
+     */
+    void add_frame(uint16_t *samples, size_t count);
+
+private:
+    void _update_proximity();
+};
@@ -0,0 +1,147 @@
+#include "coil_power.h"
+
+void CoilPowerManager::begin(uint8_t en_pin, uint8_t pwm_channel, CoilPowerFn power_fn) {
+    _en_pin = en_pin;
+    _pwm_channel = pwm_channel;
+    _power_fn = std::move(power_fn);
+
+    ledcSetup(_pwm_channel, COIL_PWM_FREQUENCY, COIL_PWM_RESOLUTION);
+
+    _last_account_time = millis();
+    _power_fn(false);
+}
+
+void CoilPowerManager::activate() {
+    if (_state == CoilPowerState::ACTIVE) return;
+
+    _clear_hold_timer();
+    _detach_pwm();
+
+    if (_state == CoilPowerState::OFF) _power_fn(true);
+
+    _set_state(CoilPowerState::ACTIVE);
+
+    _runtime_info.coil_move_on_time = 0;
+    _runtime_info.coil_move_energy = 0;
+}
+
+void CoilPowerManager::settle(bool release_coils) {
+    if (_state != CoilPowerState::ACTIVE) return;
+
+    const auto brake_time = _config.coil_power.brake_time;
+    if (brake_time == 0) {
+        if (release_coils) release();
+        else _apply_hold_strategy();
+
+        return;
+    }
+
+    // Keep full current for a moment, so the rotor settles before current is reduced
+    _set_state(CoilPowerState::BRAKE);
+    _hold_timer = _timer.add_timeout([this, release_coils](auto) {
+        _hold_timer = -1ul;
+
+        if (release_coils) release();
+        else _apply_hold_strategy();
+    }, brake_time);
+}
+
+void CoilPowerManager::release() {
+    _clear_hold_timer();
+    _detach_pwm();
+
+    _power_fn(false);
+    _set_state(CoilPowerState::OFF);
+}
+
+void CoilPowerManager::update() {
+    const auto now = millis();
+    const auto elapsed = now - _last_account_time;
+    _last_account_time = now;
+
+    const float power = _power_mw(_state);
+    if (power <= 0) return;
+
+    const float energy = power * (float) elapsed / 1e6f;
+
+    _runtime_info.coil_move_on_time += elapsed;
+    _runtime_info.coil_move_energy += energy;
+    _runtime_info.coil_total_on_time += (float) elapsed / 1000.f;
+    _runtime_info.coil_total_energy += energy;
+}
+
+void CoilPowerManager::_set_state(CoilPowerState state) {
+    if (_state == state) return;
+
+    update();
+    _state = state;
+
+    VERBOSE(D_PRINTF("Coil power: %s\r\n", __debug_enum_str(state)));
+}
+
+void CoilPowerManager::_apply_hold_strategy() {
+    const auto &cfg = _config.coil_power;
+
+    switch (cfg.hold_strategy) {
+        case CoilHoldStrategy::HOLD:
+            _set_state(CoilPowerState::HOLD);
+            break;
+
+        case CoilHoldStrategy::TIMED:
+            _set_state(CoilPowerState::HOLD);
+            _hold_timer = _timer.add_timeout([this](auto) {
+                _hold_timer = -1ul;
+                release();
+            }, cfg.hold_time);
+            break;
+
+        case CoilHoldStrategy::PWM:
+            _attach_pwm(cfg.hold_duty);
+            _set_state(CoilPowerState::PWM_HOLD);
+            break;
+
+        case CoilHoldStrategy::RELEASE:
+        default:
+            release();
+            break;
+    }
+}
+
+void CoilPowerManager::_clear_hold_timer() {
+    if (_hold_timer == -1ul) return;
+
+    _timer.clear_timeout(_hold_timer);
+    _hold_timer = -1ul;
+}
+
+void CoilPowerManager::_attach_pwm(uint8_t duty) {
+    const uint32_t max_duty = (1ul << COIL_PWM_RESOLUTION) - 1;
+
+    ledcAttachPin(_en_pin, _pwm_channel);
+    ledcWrite(_pwm_channel, max_duty * std::min<uint8_t>(duty, 100) / 100);
+}
+
+void CoilPowerManager::_detach_pwm() {
+    if (_state != CoilPowerState::PWM_HOLD) return;
+
+    ledcDetachPin(_en_pin);
+
+    pinMode(_en_pin, OUTPUT);
+    digitalWrite(_en_pin, PIN_ENABLED);
+}
+
+float CoilPowerManager::_power_mw(CoilPowerState state) const {
+    if (state == CoilPowerState::OFF) return 0;
+
+    float coils;
+    if (auto mode = _config.stepper_config.drive_mode; mode == StepperDriveMode::WAVE) coils = 1.f;
+    else if (mode == StepperDriveMode::HALF) coils = 1.5f;
+    else coils = 2.f;
+
+    const auto &cfg = _config.coil_power;
+    float power = (float) cfg.supply_voltage * (float) cfg.coil_current * coils / 1000.f;
+
+    if (state == CoilPowerState::PWM_HOLD) power *= (float) std::min<uint8_t>(cfg.hold_duty, 100) / 100.f;
+
+    return power;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+
+#include "lib/debug.h"
+#include "lib/utils/enum.h"
+
+#include "app/config.h"
+#include "misc/timer_wheel.h"
+
+MAKE_ENUM(CoilPowerState, uint8_t,
+    OFF, 0,
+    ACTIVE, 1,
+    BRAKE, 2,
+    HOLD, 3,
+    PWM_HOLD, 4,
+)
+
+typedef std::function<void(bool enabled)> CoilPowerFn;
+
+class CoilPowerManager {
+    TimerWheel &_timer;
+    const AxisConfig &_config;
+    RuntimeInfo &_runtime_info;
+
+    uint8_t _en_pin = 0;
+    uint8_t _pwm_channel = COIL_PWM_CHANNEL;
+    CoilPowerFn _power_fn;
+
+    CoilPowerState _state = CoilPowerState::OFF;
+    unsigned long _hold_timer = -1ul;
+    unsigned long _last_account_time = 0;
+
+public:
+    CoilPowerManager(TimerWheel &timer, const AxisConfig &config, RuntimeInfo &runtime_info) :
+        _timer(timer), _config(config), _runtime_info(runtime_info) {}
+
+    void begin(uint8_t en_pin, uint8_t pwm_channel, CoilPowerFn power_fn);
+
+    [[nodiscard]] CoilPowerState state() const { return _state; }
+
+    void activate();
+    /**
+     * Keeps full current for brake_time, then applies hold strategy or, with release_coils, powers coils off.
+     */
+    void settle(bool release_coils = false);
+    void release();
+
+    void update();
+
+private:
+    void _set_state(CoilPowerState state);
+    void _apply_hold_strategy();
+    void _clear_hold_timer();
+
+    void _attach_pwm(uint8_t duty);
+    void _detach_pwm();
+
+    [[nodiscard]] float _power_mw(CoilPowerState state) const;
+};
@@ -0,0 +1,49 @@
+#include "command_trace.h"
+
+#include "lib/debug.h"
+
+void CommandTrace::start() {
+    _data.recording = true;
+    _data.overflow = false;
+    _data.length = 0;
+
+    _start_time = millis();
+
+    D_PRINT("Trace: Recording started");
+}
+
+void CommandTrace::stop() {
+    if (!_data.recording) return;
+
+    _data.recording = false;
+    D_PRINTF("Trace: Recording stopped, %u bytes\r\n", _data.length);
+}
+
+void CommandTrace::record(TraceSource source, PacketType type, const void *payload, size_t size) {
+    if (!_data.recording) return;
+
+    if (payload == nullptr) size = 0;
+
+    const bool truncated = size > TRACE_MAX_PAYLOAD_SIZE;
+    size = std::min<size_t>(size, TRACE_MAX_PAYLOAD_SIZE);
+
+    const size_t record_size = sizeof(TraceRecordHeader) + size;
+    if (_data.length + record_size > TRACE_BUFFER_SIZE) {
+        _data.overflow = true;
+        stop();
+        return;
+    }
+
+    const TraceRecordHeader header{
+        .time = (uint32_t) (millis() - _start_time),
+        .source = source,
+        .type = type,
+        .size = (uint8_t) size,
+        .truncated = truncated,
+    };
+
+    memcpy(_data.buffer + _data.length, &header, sizeof(header));
+    if (size) memcpy(_data.buffer + _data.length + sizeof(header), payload, size);
+
+    _data.length += record_size;
+}
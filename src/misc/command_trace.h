@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "cmd.h"
+#include "sys_constants.h"
+
+MAKE_ENUM(TraceSource, uint8_t,
+    OTHER, 0,
+    WEB_SOCKET, 1,
+    MQTT_CLIENT, 2,
+)
+
+struct __attribute ((packed)) TraceRecordHeader {
+    uint32_t time = 0;          // ms since recording start
+    TraceSource source = TraceSource::OTHER;
+    PacketType type = PacketType::POWER;
+    uint8_t size = 0;           // Payload bytes following the header
+    bool truncated = false;     // Payload was longer than TRACE_MAX_PAYLOAD_SIZE, record can't be replayed
+};
+
+struct __attribute ((packed)) CommandTraceData {
+    bool recording = false;
+    bool overflow = false;
+
+    uint16_t length = 0;
+    uint8_t buffer[TRACE_BUFFER_SIZE]{};
+};
+
+/**
+ * Records inbound commands and parameter changes as a sequence of TraceRecordHeader + payload.
+ * Recording stops when the buffer is full, so the trace is always a contiguous prefix that can be replayed.
+ * Oversized payloads are cut to TRACE_MAX_PAYLOAD_SIZE and marked, so replay skips them instead of sending partial packets.
+ */
+class CommandTrace {
+    CommandTraceData _data{};
+    unsigned long _start_time = 0;
+
+public:
+    [[nodiscard]] bool recording() const { return _data.recording; }
+    [[nodiscard]] CommandTraceData &data() { return _data; }
+
+    void start();
+    void stop();
+
+    void record(TraceSource source, PacketType type, const void *payload = nullptr, size_t size = 0);
+};
@@ -0,0 +1,181 @@
+#include "config_log.h"
+
+#include <esp_rom_crc.h>
+
+#include "lib/debug.h"
+
+#include "metrics.h"
+
+void ConfigLog::add(uint16_t key, void *data, uint8_t size) {
+    _fields.push_back({
+        .key = key,
+        .data = (uint8_t *) data,
+        .size = size,
+        .shadow = (uint16_t) _shadow.size(),
+    });
+
+    _shadow.resize(_shadow.size() + size);
+}
+
+void ConfigLog::load() {
+    const auto start = micros();
+
+    // Temporary file is left only if compaction was interrupted, the log itself is still intact then
+    if (_fs.exists(CONFIG_LOG_TMP_PATH)) _fs.remove(CONFIG_LOG_TMP_PATH);
+
+    std::vector<uint8_t> data;
+    if (_fs.exists(CONFIG_LOG_PATH)) {
+        auto file = _fs.open(CONFIG_LOG_PATH, "r");
+        data.resize(file.size());
+        data.resize(file.read(data.data(), data.size()));
+        file.close();
+    }
+
+    ConfigLogHeader header{};
+    if (data.size() >= sizeof(header)) memcpy(&header, data.data(), sizeof(header));
+
+    const bool valid = data.size() >= sizeof(header)
+                       && header.signature == CONFIG_LOG_SIGNATURE
+                       && header.version == CONFIG_LOG_VERSION;
+
+    size_t offset = sizeof(header), loaded = 0, skipped = 0;
+    while (valid && offset + sizeof(ConfigLogRecord) <= data.size()) {
+        ConfigLogRecord record;
+        memcpy(&record, data.data() + offset, sizeof(record));
+
+        const uint8_t *value = data.data() + offset + sizeof(record);
+        if (offset + sizeof(record) + record.size > data.size() || _crc(record, value) != record.crc) break;
+
+        offset += sizeof(record) + record.size;
+
+        // Later records override earlier ones, fields removed or resized since the record was written keep defaults
+        if (auto *field = _find(record.key); field && field->size == record.size) {
+            memcpy(field->data, value, record.size);
+            loaded++;
+        } else {
+            skipped++;
+        }
+    }
+
+    const bool torn = valid && offset != data.size();
+    _size = valid ? offset : 0;
+
+    for (auto &field: _fields) memcpy(_shadow.data() + field.shadow, field.data, field.size);
+
+    if (!valid) {
+        D_PRINT("Config Log: Log not found, current config is used");
+    } else if (torn) {
+        D_PRINTF("Config Log: Damaged record at %u, %u bytes dropped\r\n", offset, data.size() - offset);
+    }
+
+    // Rewritten log contains only valid records of known fields.
+    // If it can't be written, next flush retries instead of appending to the damaged log
+    if ((!valid || torn || skipped > 0 || _size > CONFIG_LOG_COMPACT_SIZE) && !_compact()) _size = 0;
+
+    auto &metrics = Metrics::get();
+    metrics.config_load_time = micros() - start;
+    metrics.config_log_size = _size;
+
+    D_PRINTF("Config Log: Loaded %u records (%u skipped) in %lu us\r\n",
+             loaded, skipped, (unsigned long) metrics.config_load_time);
+}
+
+size_t ConfigLog::flush() {
+    // Restored if nothing is written, so changes are retried with the next flush
+    auto persisted = _shadow;
+
+    std::vector<uint8_t> buffer;
+    for (auto &field: _fields) {
+        if (memcmp(field.data, _shadow.data() + field.shadow, field.size) == 0) continue;
+        _append_record(buffer, field);
+    }
+
+    if (buffer.empty()) return 0;
+
+    auto &metrics = Metrics::get();
+    if (_size == 0 || _size + buffer.size() > CONFIG_LOG_COMPACT_SIZE) {
+        if (_compact()) return metrics.config_log_last_write;
+
+        _shadow = std::move(persisted);
+        return 0;
+    }
+
+    auto file = _fs.open(CONFIG_LOG_PATH, "a");
+    const size_t written = file ? file.write(buffer.data(), buffer.size()) : 0;
+    file.close();
+
+    // Partially written record would hide all following ones, so the log is rewritten instead
+    if (written != buffer.size()) {
+        D_PRINTF("Config Log: Append failed, %u of %u bytes written\r\n", written, buffer.size());
+        if (_compact()) return metrics.config_log_last_write;
+
+        _shadow = std::move(persisted);
+        _size = 0;
+        return 0;
+    }
+
+    _size += written;
+
+    metrics.config_log_size = _size;
+    metrics.config_log_writes++;
+    metrics.config_log_bytes_written += written;
+    metrics.config_log_last_write = written;
+
+    return written;
+}
+
+ConfigLog::Field *ConfigLog::_find(uint16_t key) {
+    for (auto &field: _fields) {
+        if (field.key == key) return &field;
+    }
+
+    return nullptr;
+}
+
+void ConfigLog::_append_record(std::vector<uint8_t> &out, const Field &field) {
+    ConfigLogRecord record{.key = field.key, .size = field.size};
+    record.crc = _crc(record, field.data);
+
+    out.insert(out.end(), (const uint8_t *) &record, (const uint8_t *) &record + sizeof(record));
+    out.insert(out.end(), field.data, field.data + field.size);
+
+    memcpy(_shadow.data() + field.shadow, field.data, field.size);
+}
+
+bool ConfigLog::_compact() {
+    const ConfigLogHeader header{};
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(sizeof(header) + _fields.size() * sizeof(ConfigLogRecord) + _shadow.size());
+    buffer.insert(buffer.end(), (const uint8_t *) &header, (const uint8_t *) &header + sizeof(header));
+
+    for (auto &field: _fields) _append_record(buffer, field);
+
+    auto file = _fs.open(CONFIG_LOG_TMP_PATH, "w", true);
+    const size_t written = file ? file.write(buffer.data(), buffer.size()) : 0;
+    file.close();
+
+    // LittleFS rename replaces the target atomically: either the old or the new log is seen after power loss
+    if (written != buffer.size() || !_fs.rename(CONFIG_LOG_TMP_PATH, CONFIG_LOG_PATH)) {
+        D_PRINT("Config Log: Unable to write log");
+        _fs.remove(CONFIG_LOG_TMP_PATH);
+        return false;
+    }
+
+    _size = written;
+
+    auto &metrics = Metrics::get();
+    metrics.config_log_size = _size;
+    metrics.config_log_writes++;
+    metrics.config_log_bytes_written += written;
+    metrics.config_log_last_write = written;
+    metrics.config_log_compactions++;
+
+    D_PRINTF("Config Log: Compacted, %u bytes\r\n", written);
+    return true;
+}
+
+uint16_t ConfigLog::_crc(const ConfigLogRecord &record, const uint8_t *value) {
+    const uint16_t crc = esp_rom_crc16_le(0, (const uint8_t *) &record, offsetof(ConfigLogRecord, crc));
+    return esp_rom_crc16_le(crc, value, record.size);
+}
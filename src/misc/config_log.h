@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+
+// Persisted fields without own packet type, IDs are above PacketType range
+MAKE_ENUM(ConfigLogField, uint8_t,
+    STEPPER_STATE, 0xf0,
+    SPEED_PROFILE, 0xf1,
+    SEQUENCE_1, 0xf8,
+    SEQUENCE_2, 0xf9,
+)
+
+struct __attribute ((packed)) ConfigLogHeader {
+    uint32_t signature = CONFIG_LOG_SIGNATURE;
+    uint8_t version = CONFIG_LOG_VERSION;
+};
+
+struct __attribute ((packed)) ConfigLogRecord {
+    uint16_t key = 0;           // Scope (0 - global, 1.. - axis) << 8 | packet type
+    uint8_t size = 0;           // Value bytes following the record
+    uint16_t crc = 0;           // CRC-16 of key, size and value
+};
+
+/**
+ * Append-only config store. Every changed field is written as a separate CRC protected record keyed by its packet type,
+ * so a save costs only the changed fields and Config layout changes don't reset settings: records are applied field by field.
+ * Replay stops at the first damaged record, so a write interrupted by power loss drops only the last change.
+ * When the log grows too large it is rewritten with current values into a temporary file, which atomically replaces the log.
+ */
+class ConfigLog {
+    struct Field {
+        uint16_t key;
+        uint8_t *data;
+        uint8_t size;
+        uint16_t shadow;        // Offset of the last persisted value in _shadow
+    };
+
+    fs::FS &_fs;
+
+    std::vector<Field> _fields{};
+    std::vector<uint8_t> _shadow{};
+
+    size_t _size = 0;
+
+public:
+    explicit ConfigLog(fs::FS &fs) : _fs(fs) {}
+
+    static constexpr uint16_t key(uint8_t scope, uint8_t id) { return (uint16_t) scope << 8 | id; }
+
+    void add(uint16_t key, void *data, uint8_t size);
+
+    void load();
+    size_t flush();
+
+private:
+    Field *_find(uint16_t key);
+
+    void _append_record(std::vector<uint8_t> &out, const Field &field);
+    bool _compact();
+
+    static uint16_t _crc(const ConfigLogRecord &record, const uint8_t *value);
+};
@@ -0,0 +1,58 @@
+#include "drift_monitor.h"
+
+#include "lib/debug.h"
+
+DriftAction DriftMonitor::add(int32_t drift) {
+    _history.samples[_history.head] = drift;
+    _history.head = (_history.head + 1) % DRIFT_HISTORY_SIZE;
+    if (_history.count < DRIFT_HISTORY_SIZE) ++_history.count;
+
+    ++_history.probes;
+    _update_statistic();
+
+    auto abs_drift = std::abs(drift);
+    D_PRINTF("Drift: %d steps (mean: %0.2f, deviation: %0.2f)\r\n", drift, _history.mean, _history.deviation);
+
+    if (abs_drift >= _config.drift_rehome_threshold) {
+        ++_history.rehomes;
+        return DriftAction::REHOME;
+    }
+
+    if (abs_drift >= _config.drift_correction_threshold) {
+        ++_history.corrections;
+        return DriftAction::CORRECT;
+    }
+
+    return DriftAction::NONE;
+}
+
+DriftAction DriftMonitor::add_missed() {
+    D_PRINT("Drift: endstop not found");
+
+    ++_history.probes;
+    ++_history.missed;
+    ++_history.rehomes;
+
+    return DriftAction::REHOME;
+}
+
+void DriftMonitor::_update_statistic() {
+    float sum = 0;
+    int32_t max = 0;
+    for (uint8_t i = 0; i < _history.count; ++i) {
+        sum += (float) _history.samples[i];
+        max = std::max(max, std::abs(_history.samples[i]));
+    }
+
+    const float mean = sum / (float) _history.count;
+
+    float sq_sum = 0;
+    for (uint8_t i = 0; i < _history.count; ++i) {
+        const float diff = (float) _history.samples[i] - mean;
+        sq_sum += diff * diff;
+    }
+
+    _history.mean = mean;
+    _history.deviation = std::sqrt(sq_sum / (float) _history.count);
+    _history.max = max;
+}
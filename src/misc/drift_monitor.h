@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "app/config.h"
+
+MAKE_ENUM(DriftAction, uint8_t,
+    NONE, 0,
+    CORRECT, 1,
+    REHOME, 2,
+)
+
+struct __attribute ((packed)) DriftHistory {
+    uint32_t probes = 0;
+    uint32_t corrections = 0;
+    uint32_t rehomes = 0;
+    // Probes that didn't reach the endstop, they have no drift value and aren't part of the samples
+    uint32_t missed = 0;
+
+    float mean = 0;
+    float deviation = 0;
+    int32_t max = 0;
+
+    uint8_t count = 0;
+    uint8_t head = 0;
+    int32_t samples[DRIFT_HISTORY_SIZE]{};
+};
+
+class DriftMonitor {
+    const StepperConfig &_config;
+
+    DriftHistory _history{};
+
+public:
+    explicit DriftMonitor(const StepperConfig &config) : _config(config) {}
+
+    [[nodiscard]] DriftHistory &history() { return _history; }
+
+    DriftAction add(int32_t drift);
+    DriftAction add_missed();
+
+private:
+    void _update_statistic();
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+enum class EndstopMode: uint8_t {
+    DIGITAL = 0,
+    ANALOG  = 1
+};
+
+// Kept apart from app/config.h, so AnalogEndstop builds without the network stack
+struct __attribute ((packed)) EndstopConfig {
+    EndstopMode mode = EndstopMode::DIGITAL;
+
+    // Filtered sensor output in mV, falling sensors (endstop_high_state off) are inverted
+    uint16_t slowdown_level = 1850;
+    uint16_t trigger_level = 2400;
+    uint16_t hysteresis = 50;
+};
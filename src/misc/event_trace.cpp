@@ -0,0 +1,46 @@
+#include "event_trace.h"
+
+#include <atomic>
+
+EventTrace EventTrace::_instance{};
+
+void EventTrace::_write(uint8_t level, TraceEvent event, uint8_t axis, uint8_t arg, int32_t value, int32_t extra) {
+    const uint32_t index = _written;
+
+    auto &record = _records[index & (EVENT_TRACE_SIZE - 1)];
+    record.time = micros();
+    record.event = event;
+    record.level = level;
+    record.axis = axis;
+    record.arg = arg;
+    record.value = value;
+    record.extra = extra;
+
+    std::atomic_signal_fence(std::memory_order_release);
+    _written = index + 1;
+}
+
+TraceDumpHeader EventTrace::snapshot(std::vector<TraceRecord> &out) const {
+    const uint32_t before = _written;
+    std::atomic_signal_fence(std::memory_order_acquire);
+
+    const uint32_t count = std::min<uint32_t>(before, EVENT_TRACE_SIZE);
+    out.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        out[i] = _records[(before - count + i) & (EVENT_TRACE_SIZE - 1)];
+    }
+
+    std::atomic_signal_fence(std::memory_order_acquire);
+    const uint32_t after = _written;
+
+    // Oldest slots may be rewritten while copying, including one record that is being written right now
+    const uint32_t overwritten = std::min<uint32_t>(count, std::max<int32_t>(0, (int32_t) (count + after - before + 1 - EVENT_TRACE_SIZE)));
+    out.erase(out.begin(), out.begin() + overwritten);
+
+    TraceDumpHeader header;
+    header.count = out.size();
+    header.time = micros();
+    header.dropped = after - out.size();
+
+    return header;
+}
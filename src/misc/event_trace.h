@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+
+MAKE_ENUM(TraceEvent, uint8_t,
+    STATE_CHANGED, 0,       // arg: AppState
+    MOVE_STARTED, 1,        // value: target step, extra: current step
+    MOVE_REJECTED, 2,       // arg: MoveRejectReason, value: target step
+    SCENE_APPLIED, 3,       // arg: scene, value: position, extra: speed
+    ENDSTOP_TRIGGERED, 4,   // arg: AppState, value: current step
+    ENDSTOP_RELEASED, 5,    // value: current step
+    HOMING_STAGE, 6,        // arg: HomingStage, value: current step, extra: expected endstop distance
+    HOMING_FAILED, 7,       // arg: HomingFailure, value: current step
+    DRIFT_PROBE, 8,         // arg: DriftProbeStage, value: current step, extra: expected endstop step
+    FORBIDDEN, 9,           // arg: TraceOperation, extra: AppState
+    SUNRISE_BURST, 10,      // arg: burst index (low byte), value: target step, extra: current step
+    ENDSTOP_NEAR, 11,       // arg: AppState, value: current step, extra: analog level
+    SPEED_PROFILE, 12,      // arg: 1 - lowered on step loss, 0 - raised, value: drift
+)
+
+MAKE_ENUM(MoveRejectReason, uint8_t,
+    NOT_HOMED, 0,
+    IN_POSITION, 1,
+)
+
+MAKE_ENUM(HomingStage, uint8_t,
+    PREPARING, 0,
+    FIRST_STEP, 1,
+    REWIND, 2,
+    SECOND_STEP, 3,
+    APPLY_OFFSET, 4,
+    SUCCESS, 5,
+    FAST_APPROACH, 6,
+    EARLY_ENDSTOP, 7,
+    SLOW_APPROACH, 8,
+    FALLBACK, 9,
+    ANALOG_APPROACH, 10,
+)
+
+MAKE_ENUM(HomingFailure, uint8_t,
+    LIMIT_EXCEEDED, 0,
+    ENDSTOP_NOT_RESET, 1,
+    SECOND_LIMIT_EXCEEDED, 2,
+)
+
+MAKE_ENUM(DriftProbeStage, uint8_t,
+    APPROACH, 0,
+    REHOME, 1,
+    CORRECT, 2,
+)
+
+MAKE_ENUM(TraceOperation, uint8_t,
+    HOMING, 0,
+    DRIFT_PROBE, 1,
+    CALIBRATION, 2,
+    SUNRISE, 3,
+    ENDSTOP_CALIBRATION, 4,
+)
+
+struct __attribute ((packed)) TraceRecord {
+    uint32_t time = 0;          // us since boot
+    TraceEvent event = TraceEvent::STATE_CHANGED;
+    uint8_t level = 0;
+    uint8_t axis = 0;
+    uint8_t arg = 0;
+    int32_t value = 0;
+    int32_t extra = 0;
+};
+
+static_assert(sizeof(TraceRecord) == 16);
+static_assert((EVENT_TRACE_SIZE & (EVENT_TRACE_SIZE - 1)) == 0);
+
+struct __attribute ((packed)) TraceDumpHeader {
+    uint32_t signature = 0x43525445;    // "ETRC"
+    uint8_t version = 1;
+    uint8_t record_size = sizeof(TraceRecord);
+    uint16_t count = 0;
+    uint32_t time = 0;                  // us, time of dump
+    uint32_t dropped = 0;               // Records overwritten since boot
+};
+
+/**
+ * Fixed-size binary event records in a RAM ring, decoded on the host (tools/trace_decode.mjs).
+ * Writing costs a timestamp and a 16-byte store, so tracing stays enabled in release builds.
+ * Events above EVENT_TRACE_LEVEL are removed at compile time together with argument evaluation.
+ */
+class EventTrace {
+    TraceRecord _records[EVENT_TRACE_SIZE]{};
+    volatile uint32_t _written = 0;
+
+    static EventTrace _instance;
+
+public:
+    static EventTrace &get() { return _instance; }
+
+    template<typename T = uint8_t>
+    void write(uint8_t level, TraceEvent event, uint8_t axis, T arg = {}, int32_t value = 0, int32_t extra = 0) {
+        _write(level, event, axis, (uint8_t) arg, value, extra);
+    }
+
+    /**
+     * Copies records oldest first. Can be called from other task: records overwritten during copy are dropped.
+     */
+    TraceDumpHeader snapshot(std::vector<TraceRecord> &out) const;
+
+private:
+    void _write(uint8_t level, TraceEvent event, uint8_t axis, uint8_t arg, int32_t value, int32_t extra);
+};
+
+#if EVENT_TRACE_LEVEL >= 1
+#define TRACE_ERROR(...) EventTrace::get().write(1, __VA_ARGS__)
+#else
+#define TRACE_ERROR(...) ((void) 0)
+#endif
+
+#if EVENT_TRACE_LEVEL >= 2
+#define TRACE_EVENT(...) EventTrace::get().write(2, __VA_ARGS__)
+#else
+#define TRACE_EVENT(...) ((void) 0)
+#endif
+
+#if EVENT_TRACE_LEVEL >= 3
+#define TRACE_DETAIL(...) EventTrace::get().write(3, __VA_ARGS__)
+#else
+#define TRACE_DETAIL(...) ((void) 0)
+#endif
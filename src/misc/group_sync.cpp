@@ -0,0 +1,204 @@
+#include "group_sync.h"
+
+void GroupSync::begin() {
+    if (!_config.enabled || _listening) return;
+
+    _id = (uint32_t) ESP.getEfuseMac();
+
+    if (!_udp.listenMulticast(GROUP_SYNC_ADDRESS, GROUP_SYNC_PORT)) {
+        D_PRINT("GroupSync: Unable to join multicast group");
+        return;
+    }
+
+    _udp.onPacket([this](AsyncUDPPacket &packet) { _receive(packet); });
+    _listening = true;
+
+    D_PRINTF("GroupSync: Joined group %u as %s\r\n", _config.group, _config.leader ? "leader" : "member");
+}
+
+void GroupSync::handle() {
+    if (!_listening) return;
+
+    while (_queue_tail != _queue_head) {
+        std::atomic_signal_fence(std::memory_order_acquire);
+
+        const auto received = _queue[_queue_tail];
+        _queue_tail = (_queue_tail + 1) % GROUP_SYNC_QUEUE_SIZE;
+
+        if (_config.enabled) _process(received);
+    }
+
+    if (!_config.enabled || _config.leader) return;
+
+    const auto now = _clock();
+    if (_info.synced && now - _last_sample_time > GROUP_SYNC_TIMEOUT) {
+        D_PRINT("GroupSync: Clock sync lost");
+
+        _info.synced = false;
+        _sample_count = 0;
+    }
+
+    if (now - _last_request_time >= GROUP_SYNC_INTERVAL) {
+        _last_request_time = now;
+
+        GroupSyncMessage message{
+            .type = GroupSyncMessageType::SYNC_REQUEST,
+            .origin_time = (uint32_t) now,
+        };
+
+        _send(message);
+    }
+}
+
+void GroupSync::move(float position) {
+    const uint32_t start_time = _clock() + _config.start_delay;
+
+    GroupSyncMessage message{
+        .type = GroupSyncMessageType::MOVE,
+        .start_time = start_time,
+        .position = position,
+    };
+
+    // Multicast over Wi-Fi is lossy, repeated MOVE just reschedules the same start
+    _send(message);
+    _send(message);
+
+    D_PRINTF("GroupSync: Move to %0.2f%% scheduled in %u ms\r\n", position, _config.start_delay);
+
+    _schedule_move(start_time, position);
+}
+
+void GroupSync::_receive(AsyncUDPPacket &packet) {
+    const uint32_t receive_time = _clock();
+    if (packet.length() != sizeof(GroupSyncMessage)) return;
+
+    const uint8_t next = (_queue_head + 1) % GROUP_SYNC_QUEUE_SIZE;
+    if (next == _queue_tail) return; // Queue is full, message dropped
+
+    auto &slot = _queue[_queue_head];
+    memcpy(&slot.message, packet.data(), sizeof(GroupSyncMessage));
+    slot.receive_time = receive_time;
+
+    std::atomic_signal_fence(std::memory_order_release);
+    _queue_head = next;
+}
+
+void GroupSync::_send(GroupSyncMessage &message) {
+    message.group = _config.group;
+    message.sender = _id;
+
+    _udp.writeTo((const uint8_t *) &message, sizeof(message), GROUP_SYNC_ADDRESS, GROUP_SYNC_PORT);
+}
+
+void GroupSync::_process(const ReceivedMessage &received) {
+    const auto &message = received.message;
+
+    if (message.signature != GROUP_SYNC_SIGNATURE) return;
+    if (message.group != _config.group || message.sender == _id) return;
+
+    switch (message.type) {
+        case GroupSyncMessageType::SYNC_REQUEST:
+            _on_sync_request(message, received.receive_time);
+            break;
+
+        case GroupSyncMessageType::SYNC_RESPONSE:
+            _on_sync_response(message, received.receive_time);
+            break;
+
+        case GroupSyncMessageType::MOVE:
+            _on_move(message);
+            break;
+    }
+}
+
+void GroupSync::_on_sync_request(const GroupSyncMessage &message, uint32_t receive_time) {
+    if (!_config.leader) return;
+
+    GroupSyncMessage response{
+        .type = GroupSyncMessageType::SYNC_RESPONSE,
+        .target = message.sender,
+        .origin_time = message.origin_time,
+        .receive_time = receive_time,
+        .transmit_time = (uint32_t) _clock(),
+    };
+
+    _send(response);
+}
+
+void GroupSync::_on_sync_response(const GroupSyncMessage &message, uint32_t receive_time) {
+    if (_config.leader || message.target != _id) return;
+
+    // Round trip without time spent by leader before response
+    const auto rtt = (int32_t) (receive_time - message.origin_time) - (int32_t) (message.transmit_time - message.receive_time);
+    if (rtt < 0) return;
+
+    const auto offset = ((int32_t) (message.receive_time - message.origin_time)
+                         + (int32_t) (message.transmit_time - receive_time)) / 2;
+
+    _info.leader = message.sender;
+    _add_sample(offset, rtt);
+}
+
+void GroupSync::_on_move(const GroupSyncMessage &message) {
+    // Repeated MOVE is already scheduled or done, unsynced member would move twice otherwise
+    if (message.sender == _last_move_sender && message.start_time == _last_move_start) return;
+
+    _last_move_sender = message.sender;
+    _last_move_start = message.start_time;
+
+    if (!_info.synced) {
+        D_PRINT("GroupSync: Clock isn't synced, moving immediately");
+
+        _schedule_move(_clock(), message.position);
+        return;
+    }
+
+    _schedule_move(message.start_time - _info.offset, message.position);
+}
+
+void GroupSync::_add_sample(int32_t offset, uint32_t rtt) {
+    _samples[_sample_head] = {.offset = offset, .rtt = rtt};
+    _sample_head = (_sample_head + 1) % GROUP_SYNC_FILTER_SIZE;
+    if (_sample_count < GROUP_SYNC_FILTER_SIZE) ++_sample_count;
+
+    // Sample with the shortest round trip has the least asymmetric delay
+    auto *best = &_samples[0];
+    for (uint8_t i = 1; i < _sample_count; ++i) {
+        if (_samples[i].rtt < best->rtt) best = &_samples[i];
+    }
+
+    _info.offset = best->offset;
+    _info.rtt = best->rtt;
+    _info.synced = true;
+    _info.sync_count++;
+
+    _last_sample_time = _clock();
+
+    VERBOSE(D_PRINTF("GroupSync: Clock offset %d ms, rtt %u ms\r\n", _info.offset, _info.rtt));
+}
+
+void GroupSync::_schedule_move(uint32_t local_time, float position) {
+    _clear_move_timer();
+    _info.move_count++;
+
+    const auto delay = (int32_t) (local_time - _clock());
+    if (delay <= 0) {
+        _info.last_move_lateness = -delay;
+        _move_fn(position);
+        return;
+    }
+
+    _move_timer = _timer.add_timeout([this, local_time, position](auto) {
+        _move_timer = -1ul;
+        _info.last_move_lateness = (int32_t) (_clock() - local_time);
+
+        _move_fn(position);
+    }, delay);
+}
+
+void GroupSync::_clear_move_timer() {
+    if (_move_timer == -1ul) return;
+
+    _timer.clear_timeout(_move_timer);
+    _move_timer = -1ul;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <AsyncUDP.h>
+#include <atomic>
+#include <functional>
+
+#include "lib/debug.h"
+#include "lib/utils/enum.h"
+
+#include "misc/group_sync_config.h"
+#include "misc/timer_wheel.h"
+
+MAKE_ENUM(GroupSyncMessageType, uint8_t,
+    SYNC_REQUEST, 0,
+    SYNC_RESPONSE, 1,
+    MOVE, 2,
+)
+
+struct __attribute ((packed)) GroupSyncMessage {
+    uint16_t signature = GROUP_SYNC_SIGNATURE;
+    GroupSyncMessageType type = GroupSyncMessageType::SYNC_REQUEST;
+    uint8_t group = 0;
+
+    uint32_t sender = 0;
+    uint32_t target = 0;        // Receiver of SYNC_RESPONSE, 0 - whole group
+
+    uint32_t origin_time = 0;   // Requester clock when SYNC_REQUEST was sent
+    uint32_t receive_time = 0;  // Leader clock when SYNC_REQUEST was received
+    uint32_t transmit_time = 0; // Leader clock when SYNC_RESPONSE was sent
+
+    uint32_t start_time = 0;    // Leader clock when MOVE should start
+
+    float position = 0;
+};
+
+struct __attribute ((packed)) GroupSyncInfo {
+    bool synced = false;
+    uint32_t leader = 0;
+
+    int32_t offset = 0;
+    uint32_t rtt = 0;
+
+    uint32_t sync_count = 0;
+    uint32_t move_count = 0;
+    int32_t last_move_lateness = 0;
+};
+
+typedef std::function<void(float position)> GroupMoveFn;
+typedef unsigned long (*GroupSyncClockFn)();
+
+class GroupSync {
+    struct ReceivedMessage {
+        GroupSyncMessage message;
+        uint32_t receive_time;
+    };
+
+    struct SyncSample {
+        int32_t offset;
+        uint32_t rtt;
+    };
+
+    TimerWheel &_timer;
+    const GroupSyncConfig &_config;
+    GroupMoveFn _move_fn;
+    GroupSyncClockFn _clock;
+
+    AsyncUDP _udp;
+    uint32_t _id = 0;
+    bool _listening = false;
+
+    // Filled from the UDP task, drained from the service loop
+    ReceivedMessage _queue[GROUP_SYNC_QUEUE_SIZE]{};
+    volatile uint8_t _queue_head = 0;
+    volatile uint8_t _queue_tail = 0;
+
+    SyncSample _samples[GROUP_SYNC_FILTER_SIZE]{};
+    uint8_t _sample_count = 0;
+    uint8_t _sample_head = 0;
+
+    GroupSyncInfo _info{};
+
+    unsigned long _last_sample_time = 0;
+    unsigned long _last_request_time = 0;
+    unsigned long _move_timer = -1ul;
+
+    uint32_t _last_move_sender = 0;
+    uint32_t _last_move_start = 0;
+
+public:
+    /**
+     * @param clock Local clock, ms. Replaced in host tests to run several skewed instances in one process.
+     */
+    GroupSync(TimerWheel &timer, const GroupSyncConfig &config, GroupMoveFn move_fn, GroupSyncClockFn clock = millis) :
+        _timer(timer), _config(config), _move_fn(std::move(move_fn)), _clock(clock) {}
+
+    void begin();
+    void handle();
+
+    [[nodiscard]] bool leader() const { return _listening && _config.enabled && _config.leader; }
+    [[nodiscard]] GroupSyncInfo &info() { return _info; }
+
+    void move(float position);
+
+private:
+    void _receive(AsyncUDPPacket &packet);
+    void _send(GroupSyncMessage &message);
+
+    void _process(const ReceivedMessage &received);
+    void _on_sync_request(const GroupSyncMessage &message, uint32_t receive_time);
+    void _on_sync_response(const GroupSyncMessage &message, uint32_t receive_time);
+    void _on_move(const GroupSyncMessage &message);
+
+    void _clear_move_timer();
+
+    void _add_sample(int32_t offset, uint32_t rtt);
+    void _schedule_move(uint32_t local_time, float position);
+};
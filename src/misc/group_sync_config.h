@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+#include "constants.h"
+
+// Kept apart from app/config.h, so GroupSync builds without the network stack
+struct __attribute ((packed)) GroupSyncConfig {
+    bool enabled = false;
+    uint8_t group = 1;
+    bool leader = false;
+
+    uint16_t start_delay = GROUP_SYNC_DEFAULT_START_DELAY;
+};
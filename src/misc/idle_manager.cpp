@@ -0,0 +1,149 @@
+#include "idle_manager.h"
+
+#include <algorithm>
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+#include "lib/debug.h"
+
+#include "metrics.h"
+
+void IdleManager::begin() {
+    _task = xTaskGetCurrentTaskHandle();
+    _active_frequency = getCpuFrequencyMhz();
+    _last_activity = _last_update = millis();
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32c3_t pm_config{
+        .max_freq_mhz = (int) _active_frequency,
+        .min_freq_mhz = IDLE_CPU_FREQUENCY,
+        .light_sleep_enable = true,
+    };
+
+    if (esp_pm_configure(&pm_config) == ESP_OK
+        && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "app_active", &_pm_lock) == ESP_OK) {
+        // Keep full speed until idle mode is entered
+        esp_pm_lock_acquire(_pm_lock);
+        _light_sleep = true;
+    }
+#endif
+
+    D_PRINTF("Idle: Using %s\r\n", _light_sleep ? "automatic light sleep" : "frequency scaling");
+}
+
+void IdleManager::add_wake_pin(uint8_t pin) {
+    if (std::any_of(_wake_pins.begin(), _wake_pins.end(), [pin](auto &wake_pin) { return wake_pin.pin == pin; })) return;
+
+    // Pins added while idle take effect on the next idle mode enter
+    _wake_pins.push_back({pin, (bool) digitalRead(pin)});
+}
+
+void IdleManager::remove_wake_pin(uint8_t pin) {
+    auto it = std::find_if(_wake_pins.begin(), _wake_pins.end(), [pin](auto &wake_pin) { return wake_pin.pin == pin; });
+    if (it == _wake_pins.end()) return;
+
+    if (_idle && _light_sleep) gpio_wakeup_disable((gpio_num_t) pin);
+    _wake_pins.erase(it);
+}
+
+void IdleManager::activity() {
+    _activity = true;
+    if (_idle && _task) xTaskNotifyGive(_task);
+}
+
+bool IdleManager::update(bool can_idle) {
+    const auto now = millis();
+
+    if (_idle) Metrics::get().idle_time += now - _last_update;
+    _last_update = now;
+
+    if (_activity || !can_idle) {
+        _activity = false;
+        _last_activity = now;
+    }
+
+    const bool idle = can_idle && now - _last_activity >= IDLE_ENTER_DELAY;
+    if (idle == _idle) return false;
+
+    if (idle) {
+        _enter();
+    } else {
+        _leave();
+    }
+
+    return true;
+}
+
+void IdleManager::wait(unsigned long timeout) {
+    const auto start = esp_timer_get_time();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(std::min<unsigned long>(timeout, IDLE_MAX_SLEEP_INTERVAL)));
+    const auto elapsed = (uint64_t) (esp_timer_get_time() - start);
+
+    _check_wake_pins();
+
+    _stats.asleep += elapsed;
+    _stats.wakeups++;
+
+    _asleep_total += elapsed;
+
+    auto &metrics = Metrics::get();
+    metrics.asleep_time = _asleep_total / 1000;
+    metrics.idle_wakeups++;
+}
+
+void IdleManager::_enter() {
+    _idle = true;
+
+    // Wake on level opposite to current: pin may rest in any state, e.g. endstop stays pressed at the top.
+    // Only the wakeup source is configured, pin interrupt handler is left to its owner
+    for (auto &wake_pin: _wake_pins) {
+        wake_pin.level = digitalRead(wake_pin.pin);
+        if (_light_sleep) {
+            gpio_wakeup_enable((gpio_num_t) wake_pin.pin, wake_pin.level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        }
+    }
+
+    if (WiFi.getMode() & WIFI_MODE_STA) {
+        _active_wifi_ps = WiFi.getSleep();
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+    }
+
+    if (_light_sleep) {
+        esp_sleep_enable_gpio_wakeup();
+        esp_pm_lock_release(_pm_lock);
+    } else {
+        setCpuFrequencyMhz(IDLE_CPU_FREQUENCY);
+    }
+
+    D_PRINT("Idle: Enter idle mode");
+}
+
+void IdleManager::_leave() {
+    if (_light_sleep) {
+        esp_pm_lock_acquire(_pm_lock);
+    } else {
+        setCpuFrequencyMhz(_active_frequency);
+    }
+
+    if (WiFi.getMode() & WIFI_MODE_STA) WiFi.setSleep(_active_wifi_ps);
+
+    if (_light_sleep) {
+        for (auto &wake_pin: _wake_pins) gpio_wakeup_disable((gpio_num_t) wake_pin.pin);
+    }
+
+    _idle = false;
+    D_PRINT("Idle: Leave idle mode");
+}
+
+void IdleManager::_check_wake_pins() {
+    if (!_idle) return;
+
+    for (auto &wake_pin: _wake_pins) {
+        // Level wakeup keeps firing while the level holds, so idle mode has to be left to disable it
+        if (digitalRead(wake_pin.pin) != wake_pin.level) {
+            _activity = true;
+            return;
+        }
+    }
+}
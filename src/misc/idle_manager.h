@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "sys_constants.h"
+
+struct __attribute ((packed)) IdleStats {
+    uint64_t asleep = 0;        // Time spent blocked in idle wait, us
+    uint32_t wakeups = 0;
+};
+
+/**
+ * Lets the event loop block instead of spinning while nothing moves.
+ * With automatic light sleep available (CONFIG_PM_ENABLE + tickless idle) the chip sleeps between Wi-Fi beacons,
+ * otherwise CPU frequency is lowered and the core is clock-gated by the FreeRTOS idle task.
+ * Wait ends on deadline or activity(). Wake pins keep own interrupt handlers (e.g. Button), they only wake the chip
+ * from light sleep and are polled after each wait, so IDLE_MAX_SLEEP_INTERVAL bounds their latency.
+ */
+class IdleManager {
+    TaskHandle_t _task = nullptr;
+    esp_pm_lock_handle_t _pm_lock = nullptr;
+    bool _light_sleep = false;
+
+    struct WakePin {
+        uint8_t pin;
+        bool level;             // Level at idle mode enter, any other level is a wake up
+    };
+
+    std::vector<WakePin> _wake_pins{};
+
+    volatile bool _activity = false;
+    bool _idle = false;
+
+    unsigned long _last_activity = 0;
+    unsigned long _last_update = 0;
+
+    uint32_t _active_frequency = 0;
+    wifi_ps_type_t _active_wifi_ps = WIFI_PS_NONE;
+
+    uint64_t _asleep_total = 0;
+    IdleStats _stats{};
+
+public:
+    void begin();
+    void add_wake_pin(uint8_t pin);
+    void remove_wake_pin(uint8_t pin);
+
+    [[nodiscard]] bool idle() const { return _idle; }
+    [[nodiscard]] bool light_sleep() const { return _light_sleep; }
+
+    /**
+     * Resets idle delay and interrupts current wait. Safe to call from other tasks.
+     */
+    void activity();
+
+    /**
+     * @return true when idle mode was entered or left.
+     */
+    bool update(bool can_idle);
+
+    void wait(unsigned long timeout);
+
+    [[nodiscard]] const IdleStats &stats() const { return _stats; }
+    void reset_stats() { _stats = {}; }
+
+private:
+    void _enter();
+    void _leave();
+
+    void _check_wake_pins();
+};
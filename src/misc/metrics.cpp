@@ -0,0 +1,94 @@
+#include "metrics.h"
+
+Metrics Metrics::_instance{};
+
+static void append_header(String &out, const char *name, const char *type, const char *help) {
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    out += buffer;
+}
+
+static void append_value(String &out, const char *name, uint32_t value) {
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "%s %lu\n", name, (unsigned long) value);
+    out += buffer;
+}
+
+static void append_metric(String &out, const char *name, const char *type, const char *help, uint32_t value) {
+    append_header(out, name, type, help);
+    append_value(out, name, value);
+}
+
+template<typename Fn>
+static void append_axis_metric(String &out, const char *name, const char *type, const char *help,
+                               const Metrics::Axis *axes, uint8_t axis_count, Fn &&fn) {
+    append_header(out, name, type, help);
+
+    char buffer[128];
+    for (uint8_t i = 0; i < axis_count; ++i) {
+        snprintf(buffer, sizeof(buffer), "%s{axis=\"%u\"} %lu\n", name, i + 1, (unsigned long) fn(axes[i]));
+        out += buffer;
+    }
+}
+
+String Metrics::format(uint8_t axis_count) const {
+    String out;
+    out.reserve(METRICS_RESPONSE_RESERVE);
+
+    append_header(out, "shades_steps_total", "counter", "Steps performed by direction");
+    char buffer[128];
+    for (uint8_t i = 0; i < axis_count; ++i) {
+        snprintf(buffer, sizeof(buffer), "shades_steps_total{axis=\"%u\",direction=\"close\"} %lu\n"
+                                         "shades_steps_total{axis=\"%u\",direction=\"open\"} %lu\n",
+                 i + 1, (unsigned long) axes[i].steps_close, i + 1, (unsigned long) axes[i].steps_open);
+        out += buffer;
+    }
+
+    append_axis_metric(out, "shades_moves_total", "counter", "Requested moves",
+                       axes, axis_count, [](const Axis &a) { return a.moves; });
+    append_axis_metric(out, "shades_emergency_stops_total", "counter", "Emergency stops",
+                       axes, axis_count, [](const Axis &a) { return a.emergency_stops; });
+
+    append_axis_metric(out, "shades_homings_total", "counter", "Homing attempts",
+                       axes, axis_count, [](const Axis &a) { return a.homings; });
+    append_axis_metric(out, "shades_homing_duration_ms_total", "counter", "Total homing duration",
+                       axes, axis_count, [](const Axis &a) { return a.homing_duration_total; });
+    append_axis_metric(out, "shades_homing_duration_ms", "gauge", "Last homing duration",
+                       axes, axis_count, [](const Axis &a) { return a.homing_duration_last; });
+
+    append_header(out, "shades_homing_failures_total", "counter", "Homing failures by reason");
+    for (uint8_t i = 0; i < axis_count; ++i) {
+        snprintf(buffer, sizeof(buffer), "shades_homing_failures_total{axis=\"%u\",reason=\"limit\"} %lu\n"
+                                         "shades_homing_failures_total{axis=\"%u\",reason=\"endstop\"} %lu\n",
+                 i + 1, (unsigned long) axes[i].homing_limit_failures,
+                 i + 1, (unsigned long) axes[i].homing_endstop_failures);
+        out += buffer;
+    }
+
+    append_metric(out, "shades_config_saves_total", "counter", "Config saves committed to flash", config_saves);
+    append_metric(out, "shades_config_load_us", "gauge", "Config log replay time at boot", config_load_time);
+    append_metric(out, "shades_config_log_bytes", "gauge", "Config log size", config_log_size);
+    append_metric(out, "shades_config_log_writes_total", "counter", "Config log appends", config_log_writes);
+    append_metric(out, "shades_config_log_written_bytes_total", "counter", "Bytes written to config log", config_log_bytes_written);
+    append_metric(out, "shades_config_log_last_write_bytes", "gauge", "Bytes written by the last config change", config_log_last_write);
+    append_metric(out, "shades_config_log_compactions_total", "counter", "Config log compactions", config_log_compactions);
+    append_metric(out, "shades_notifications_total", "counter", "Parameter change notifications", notifications);
+
+    append_metric(out, "shades_mqtt_connected", "gauge", "MQTT broker connection state", mqtt_connected);
+    append_metric(out, "shades_mqtt_connections_total", "counter", "MQTT broker connections", mqtt_connections);
+    append_metric(out, "shades_mqtt_published_total", "counter", "MQTT messages published", mqtt_published);
+    append_metric(out, "shades_mqtt_dropped_total", "counter", "MQTT messages dropped, outbox full", mqtt_dropped);
+    append_metric(out, "shades_mqtt_inbox_dropped_total", "counter", "MQTT messages dropped, inbox full", mqtt_inbox_dropped);
+    append_metric(out, "shades_mqtt_sync_ms", "gauge", "Time from last connection until retained state is acknowledged", mqtt_sync_time);
+
+    append_metric(out, "shades_idle_ms_total", "counter", "Time spent in idle mode", idle_time);
+    append_metric(out, "shades_asleep_ms_total", "counter", "Time spent blocked in idle wait", asleep_time);
+    append_metric(out, "shades_idle_wakeups_total", "counter", "Idle wait wake-ups", idle_wakeups);
+    append_metric(out, "shades_cpu_frequency_mhz", "gauge", "Current CPU frequency", getCpuFrequencyMhz());
+
+    append_metric(out, "shades_heap_free_bytes", "gauge", "Free heap", ESP.getFreeHeap());
+    append_metric(out, "shades_heap_min_free_bytes", "gauge", "Minimum free heap ever", ESP.getMinFreeHeap());
+    append_metric(out, "shades_uptime_seconds", "counter", "Uptime", millis() / 1000);
+
+    return out;
+}
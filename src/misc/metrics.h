@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "sys_constants.h"
+
+/**
+ * Operational counters scraped over HTTP.
+ * Every counter has a single writer and is updated with a plain word increment.
+ * Aligned 32-bit loads are atomic on the target, so scraping from the web task needs no locking.
+ */
+struct Metrics {
+    struct Axis {
+        uint32_t steps_close = 0;
+        uint32_t steps_open = 0;
+
+        uint32_t moves = 0;
+        uint32_t emergency_stops = 0;
+
+        uint32_t homings = 0;
+        uint32_t homing_duration_total = 0;    // ms
+        uint32_t homing_duration_last = 0;     // ms
+        uint32_t homing_limit_failures = 0;
+        uint32_t homing_endstop_failures = 0;
+    };
+
+    Axis axes[AXIS_MAX_COUNT]{};
+
+    uint32_t config_saves = 0;
+    uint32_t config_load_time = 0;             // us
+    uint32_t config_log_size = 0;              // bytes
+    uint32_t config_log_writes = 0;
+    uint32_t config_log_bytes_written = 0;
+    uint32_t config_log_last_write = 0;        // bytes
+    uint32_t config_log_compactions = 0;
+    uint32_t notifications = 0;
+
+    uint32_t mqtt_connected = 0;
+    uint32_t mqtt_connections = 0;
+    uint32_t mqtt_published = 0;
+    uint32_t mqtt_dropped = 0;
+    uint32_t mqtt_inbox_dropped = 0;
+    uint32_t mqtt_sync_time = 0;               // ms from connection to acknowledged state
+
+    uint32_t idle_time = 0;                    // ms
+    uint32_t asleep_time = 0;                  // ms
+    uint32_t idle_wakeups = 0;
+
+    static Metrics &get() { return _instance; }
+
+    [[nodiscard]] String format(uint8_t axis_count) const;
+
+private:
+    static Metrics _instance;
+};
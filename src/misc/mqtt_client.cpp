@@ -0,0 +1,240 @@
+#include "mqtt_client.h"
+
+#include <WiFi.h>
+
+#include "lib/debug.h"
+
+#include "metrics.h"
+
+void MqttClient::begin(const MqttClientConfig &config, std::function<void()> on_message) {
+    _enabled = true;
+    _client_id = config.client_id;
+    _on_message = std::move(on_message);
+
+    _client.setServer(config.host, config.port);
+    _client.setCredentials(config.user, config.password);
+    _client.setClientId(_client_id.c_str());
+    _client.setKeepAlive(MQTT_KEEP_ALIVE);
+    _client.setWill(MQTT_OUT_TOPIC_AVAILABILITY, 1, true, "offline");
+
+    _client.onConnect([this](bool) { _connect_event = true; });
+    _client.onDisconnect([this](auto) { _disconnect_event = true; });
+    _client.onPublish([this](auto) { _acknowledged = _acknowledged + 1; });
+    _client.onMessage([this](char *topic, char *payload, auto, size_t length, size_t index, size_t total) {
+        _receive(topic, payload, length, index, total);
+    });
+
+    publish(MQTT_OUT_TOPIC_AVAILABILITY, "online");
+}
+
+void MqttClient::register_parameter(const char *topic_in, const char *topic_out, AbstractParameter *parameter) {
+    _subscriptions.push_back({.topic = topic_in, .parameter = parameter, .command = nullptr});
+    register_notification(topic_out, parameter);
+}
+
+void MqttClient::register_notification(const char *topic_out, AbstractParameter *parameter) {
+    if (_outbox.size() >= MQTT_OUTBOX_SIZE) {
+        D_PRINTF("MQTT: Outbox is full, %s is not published\r\n", topic_out);
+        return;
+    }
+
+    _outbox.push_back({
+        .topic = topic_out,
+        .parameter = parameter,
+        .payload = parameter->to_string(),
+        .pending = true,
+        .once = false,
+    });
+}
+
+void MqttClient::register_command(const char *topic_in, MqttCommandFn fn) {
+    _subscriptions.push_back({.topic = topic_in, .parameter = nullptr, .command = std::move(fn)});
+}
+
+void MqttClient::publish(const String &topic, const String &payload, bool once) {
+    if (auto *publication = _publication(topic)) {
+        _enqueue(*publication, payload);
+    } else if (_outbox.size() < MQTT_OUTBOX_SIZE) {
+        _outbox.push_back({.topic = topic, .parameter = nullptr, .payload = payload, .pending = true, .once = once});
+    } else {
+        Metrics::get().mqtt_dropped++;
+        D_PRINTF("MQTT: Outbox is full, %s is dropped\r\n", topic.c_str());
+    }
+}
+
+void MqttClient::notify(const AbstractParameter *parameter) {
+    for (auto &publication: _outbox) {
+        if (publication.parameter == parameter) _enqueue(publication, parameter->to_string());
+    }
+}
+
+void MqttClient::republish(bool all) {
+    for (auto &publication: _outbox) {
+        if (all || !publication.once) publication.pending = true;
+    }
+}
+
+void MqttClient::handle() {
+    if (!_enabled) return;
+
+    if (_disconnect_event) {
+        _disconnect_event = false;
+        _on_disconnected();
+    }
+
+    if (_connect_event) {
+        _connect_event = false;
+        if (_client.connected()) _on_connected();
+    }
+
+    _process_inbox();
+
+    if (_connected) _flush();
+    else _connect();
+}
+
+MqttClient::Publication *MqttClient::_publication(const String &topic) {
+    for (auto &publication: _outbox) {
+        if (publication.topic == topic) return &publication;
+    }
+
+    return nullptr;
+}
+
+void MqttClient::_enqueue(Publication &publication, String payload) {
+    // Retained value on the broker is already actual
+    if (!publication.pending && publication.payload == payload) return;
+
+    publication.payload = std::move(payload);
+    publication.pending = true;
+}
+
+void MqttClient::_connect() {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    const auto now = millis();
+    if (_connecting) {
+        if (now - _connect_time < MQTT_CONNECTION_TIMEOUT) return;
+
+        D_PRINT("MQTT: Connection timeout");
+        _client.disconnect(true);
+        _connecting = false;
+    }
+
+    if (_connect_time != 0 && now - _connect_time < MQTT_RECONNECT_TIMEOUT) return;
+
+    _connecting = true;
+    _connect_time = now;
+    _client.connect();
+}
+
+void MqttClient::_on_connected() {
+    D_PRINT("MQTT: Connected");
+
+    _connected = true;
+    _connecting = false;
+
+    for (auto &subscription: _subscriptions) _client.subscribe(subscription.topic, 1);
+
+    // Broker may have lost retained values, and changes made while offline are pending anyway
+    republish(false);
+
+    // Acknowledgements of the previous session never arrive
+    _sent = _acknowledged;
+    _syncing = true;
+    _connected_at = millis();
+
+    auto &metrics = Metrics::get();
+    metrics.mqtt_connected = 1;
+    metrics.mqtt_connections++;
+}
+
+void MqttClient::_on_disconnected() {
+    // Next connection attempt is scheduled by _connect() after MQTT_RECONNECT_TIMEOUT
+    if (_connected) D_PRINT("MQTT: Disconnected");
+
+    _connected = false;
+    _connecting = false;
+    _syncing = false;
+
+    Metrics::get().mqtt_connected = 0;
+}
+
+void MqttClient::_process_inbox() {
+    if (!_inbox_pending) return;
+
+    std::vector<Message> messages;
+    {
+        std::lock_guard lock(_inbox_mutex);
+        std::swap(messages, _inbox);
+        _inbox_pending = false;
+    }
+
+    for (auto &message: messages) {
+        for (auto &subscription: _subscriptions) {
+            if (message.topic != subscription.topic) continue;
+
+            if (subscription.command) {
+                subscription.command(message.payload);
+            } else if (subscription.parameter->parse(message.payload)) {
+                NotificationBus::get().notify_parameter_changed(this, subscription.parameter);
+            } else {
+                D_PRINTF("MQTT: Unable to parse %s: %s\r\n", message.topic.c_str(), message.payload.c_str());
+            }
+        }
+    }
+}
+
+void MqttClient::_flush() {
+    bool pending = false;
+    for (auto &publication: _outbox) {
+        if (!publication.pending) continue;
+
+        // Limits client buffer usage, the rest is sent as acknowledgements arrive
+        if (_sent - _acknowledged >= MQTT_MAX_INFLIGHT) {
+            pending = true;
+            break;
+        }
+
+        if (!_client.publish(publication.topic.c_str(), 1, true, publication.payload.c_str(), publication.payload.length())) {
+            pending = true;
+            break;
+        }
+
+        publication.pending = false;
+        _sent++;
+
+        Metrics::get().mqtt_published++;
+    }
+
+    // Subscribers see the actual state once every pending value is acknowledged by the broker
+    if (_syncing && !pending && _sent == _acknowledged) {
+        _syncing = false;
+
+        const uint32_t sync_time = millis() - _connected_at;
+        Metrics::get().mqtt_sync_time = sync_time;
+
+        D_PRINTF("MQTT: State synchronized in %lu ms\r\n", (unsigned long) sync_time);
+    }
+}
+
+void MqttClient::_receive(const char *topic, const char *payload, size_t length, size_t index, size_t total) {
+    // Commands and parameters are short, fragmented payloads are not expected
+    if (index != 0 || length != total) return;
+
+    {
+        std::lock_guard lock(_inbox_mutex);
+        if (_inbox.size() >= MQTT_INBOX_SIZE) {
+            Metrics::get().mqtt_inbox_dropped++;
+            return;
+        }
+
+        String value;
+        value.concat(payload, length);
+
+        _inbox.push_back({.topic = topic, .payload = std::move(value)});
+        _inbox_pending = true;
+    }
+
+    if (_on_message) _on_message();
+}
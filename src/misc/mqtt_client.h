@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "lib/base/parameter.h"
+
+#include "constants.h"
+#include "sys_constants.h"
+
+typedef std::function<void(const String &payload)> MqttCommandFn;
+
+struct MqttClientConfig {
+    const char *client_id;
+    const char *host;
+    uint16_t port;
+    const char *user;
+    const char *password;
+};
+
+/**
+ * MQTT transport with the same registration API as the framework server.
+ * Outbound values are kept in an outbox with one entry per topic: a newer value replaces the pending one,
+ * so nothing but stale intermediate values is lost while the broker is unreachable.
+ * Values are published retained with QoS 1 and the outbox is re-sent after every reconnect.
+ * Messages are received on the network task and handled from the event loop in handle().
+ */
+class MqttClient {
+    struct Subscription {
+        const char *topic;
+        AbstractParameter *parameter;
+        MqttCommandFn command;
+    };
+
+    struct Publication {
+        String topic;
+        const AbstractParameter *parameter;
+        String payload;
+        bool pending;
+        bool once;              // Not re-sent after reconnect, broker keeps it retained
+    };
+
+    struct Message {
+        String topic;
+        String payload;
+    };
+
+    AsyncMqttClient _client{};
+    String _client_id{};
+
+    std::vector<Subscription> _subscriptions{};
+    std::vector<Publication> _outbox{};
+
+    std::mutex _inbox_mutex{};
+    std::vector<Message> _inbox{};
+    volatile bool _inbox_pending = false;   // Lets the event loop skip locking while nothing is received
+
+    std::function<void()> _on_message = nullptr;
+
+    bool _enabled = false;
+    bool _connected = false;
+    bool _connecting = false;
+    bool _syncing = false;
+
+    volatile bool _connect_event = false;
+    volatile bool _disconnect_event = false;
+
+    // Single writer each: _sent by the event loop, _acknowledged by the network task
+    uint32_t _sent = 0;
+    volatile uint32_t _acknowledged = 0;
+
+    unsigned long _connect_time = 0;
+    unsigned long _connected_at = 0;
+
+public:
+    void begin(const MqttClientConfig &config, std::function<void()> on_message);
+
+    [[nodiscard]] bool connected() const { return _connected; }
+
+    void register_parameter(const char *topic_in, const char *topic_out, AbstractParameter *parameter);
+    void register_notification(const char *topic_out, AbstractParameter *parameter);
+    void register_command(const char *topic_in, MqttCommandFn fn);
+
+    void publish(const String &topic, const String &payload, bool once = false);
+    void notify(const AbstractParameter *parameter);
+    void republish(bool all);
+
+    void handle();
+
+private:
+    Publication *_publication(const String &topic);
+    void _enqueue(Publication &publication, String payload);
+
+    void _connect();
+    void _on_connected();
+    void _on_disconnected();
+
+    void _process_inbox();
+    void _flush();
+
+    void _receive(const char *topic, const char *payload, size_t length, size_t index, size_t total);
+};
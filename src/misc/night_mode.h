@@ -4,10 +4,10 @@
 
 #include "lib/misc/event_topic.h"
 #include "lib/misc/ntp_time.h"
-#include "lib/misc/timer.h"
 #include "lib/utils/enum.h"
 
 #include "app/config.h"
+#include "misc/timer_wheel.h"
 
 MAKE_ENUM(NightModeState, uint8_t,
     KILLED, 0,
@@ -18,7 +18,7 @@ MAKE_ENUM(NightModeState, uint8_t,
 
 class NightModeManager {
     NtpTime &_ntp_time;
-    Timer &_timer;
+    TimerWheel &_timer;
     const Config &_config;
 
     unsigned long _next_start_night_time = 0;
@@ -30,7 +30,7 @@ class NightModeManager {
     EventTopic<NightModeState> _e_night_mode_state{};
 
 public:
-    NightModeManager(NtpTime &ntp_time, Timer &timer, const Config &config) :
+    NightModeManager(NtpTime &ntp_time, TimerWheel &timer, const Config &config) :
         _ntp_time(ntp_time), _timer(timer), _config(config) {}
 
     auto &event_night_mode() { return _e_night_mode_state; }
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <Arduino.h>
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
+
+#include "lib/debug.h"
+
+#include "app/config.h"
+#include "misc/metrics.h"
+
+#define PHASE_DRIVER_PIN_COUNT (4u)
+
+// Coil order matches GyverStepper 4-wire tables, so existing pin configuration keeps working
+
+template<StepperDriveMode Mode>
+struct PhaseTable;
+
+template<>
+struct PhaseTable<StepperDriveMode::WAVE> {
+    static constexpr uint8_t COUNT = 4;
+    static constexpr uint8_t PHASES[COUNT] = {0b0010, 0b0100, 0b0001, 0b1000};
+};
+
+template<>
+struct PhaseTable<StepperDriveMode::FULL> {
+    static constexpr uint8_t COUNT = 4;
+    static constexpr uint8_t PHASES[COUNT] = {0b1010, 0b0110, 0b0101, 0b1001};
+};
+
+template<>
+struct PhaseTable<StepperDriveMode::HALF> {
+    static constexpr uint8_t COUNT = 8;
+    static constexpr uint8_t PHASES[COUNT] = {0b1010, 0b0010, 0b0110, 0b0100, 0b0101, 0b0001, 0b1001, 0b1000};
+};
+
+struct PhaseDriverState {
+    uint32_t coils_mask = 0;
+    uint32_t set_masks[8]{};
+    uint32_t clear_masks[8]{};
+
+    uint8_t en_pin = 0;
+    uint8_t phase = 0;
+    bool reverse = false;
+};
+
+/**
+ * Drives 4-wire stepper coils directly through GPIO set/clear registers.
+ * GStepper2 works as a virtual 2-wire driver and reports only step direction.
+ * All state is static, so handlers can be attached to GStepper2 as plain function pointers.
+ */
+template<StepperDriveMode Mode, uint8_t Index = 0>
+class PhaseDriver {
+    typedef PhaseTable<Mode> Table;
+    static_assert((Table::COUNT & (Table::COUNT - 1)) == 0, "Phase count must be power of 2");
+
+    static inline PhaseDriverState _state{};
+
+public:
+    static bool begin(const uint8_t (&pins)[PHASE_DRIVER_PIN_COUNT], uint8_t en_pin, bool reverse) {
+        _state = {};
+        _state.en_pin = en_pin;
+        _state.reverse = reverse;
+
+        for (auto pin: pins) {
+            if (pin >= 32) {
+                D_PRINTF("Phase driver: unsupported pin %u\r\n", pin);
+                return false;
+            }
+
+            pinMode(pin, OUTPUT);
+            _state.coils_mask |= 1ul << pin;
+        }
+
+        for (uint8_t phase = 0; phase < Table::COUNT; ++phase) {
+            uint32_t mask = 0;
+            for (uint8_t i = 0; i < PHASE_DRIVER_PIN_COUNT; ++i) {
+                if (Table::PHASES[phase] & (1u << i)) mask |= 1ul << pins[i];
+            }
+
+            _state.set_masks[phase] = mask;
+            _state.clear_masks[phase] = _state.coils_mask & ~mask;
+        }
+
+        pinMode(en_pin, OUTPUT);
+        power(false);
+
+        return true;
+    }
+
+    static void step(uint8_t dir) {
+        auto &metrics = Metrics::get().axes[Index];
+        if (dir) metrics.steps_close++;
+        else metrics.steps_open++;
+
+        const bool forward = (dir != 0) != _state.reverse;
+        _state.phase = (_state.phase + (forward ? 1 : Table::COUNT - 1)) & (Table::COUNT - 1);
+
+        _write(_state.phase);
+    }
+
+    static void power(bool enabled) {
+        if (enabled) {
+            _write(_state.phase);
+            digitalWrite(_state.en_pin, PIN_ENABLED);
+        } else {
+            REG_WRITE(GPIO_OUT_W1TC_REG, _state.coils_mask);
+            digitalWrite(_state.en_pin, PIN_DISABLED);
+        }
+    }
+
+private:
+    static void _write(uint8_t phase) {
+        // Energize next coils before releasing previous, so the rotor is never left unheld
+        REG_WRITE(GPIO_OUT_W1TS_REG, _state.set_masks[phase]);
+        REG_WRITE(GPIO_OUT_W1TC_REG, _state.clear_masks[phase]);
+    }
+};
+
+template<uint8_t Index = 0, typename StepperT>
+bool attach_phase_driver(StepperT &stepper, StepperDriveMode mode,
+                         const uint8_t (&pins)[PHASE_DRIVER_PIN_COUNT], uint8_t en_pin, bool reverse) {
+    switch (mode) {
+        case StepperDriveMode::WAVE:
+            stepper.attachStep(PhaseDriver<StepperDriveMode::WAVE, Index>::step);
+            stepper.attachPower(PhaseDriver<StepperDriveMode::WAVE, Index>::power);
+            return PhaseDriver<StepperDriveMode::WAVE, Index>::begin(pins, en_pin, reverse);
+
+        case StepperDriveMode::HALF:
+            stepper.attachStep(PhaseDriver<StepperDriveMode::HALF, Index>::step);
+            stepper.attachPower(PhaseDriver<StepperDriveMode::HALF, Index>::power);
+            return PhaseDriver<StepperDriveMode::HALF, Index>::begin(pins, en_pin, reverse);
+
+        case StepperDriveMode::FULL:
+        default:
+            stepper.attachStep(PhaseDriver<StepperDriveMode::FULL, Index>::step);
+            stepper.attachPower(PhaseDriver<StepperDriveMode::FULL, Index>::power);
+            return PhaseDriver<StepperDriveMode::FULL, Index>::begin(pins, en_pin, reverse);
+    }
+}
+
+template<uint8_t Index = 0, typename StepperT>
+bool attach_axis_phase_driver(uint8_t axis, StepperT &stepper, StepperDriveMode mode,
+                              const uint8_t (&pins)[PHASE_DRIVER_PIN_COUNT], uint8_t en_pin, bool reverse) {
+    // Each axis needs its own driver instance, so runtime index is mapped to the template one
+    if (axis == Index) return attach_phase_driver<Index>(stepper, mode, pins, en_pin, reverse);
+
+    if constexpr (Index + 1 < AXIS_MAX_COUNT) {
+        return attach_axis_phase_driver<Index + 1>(axis, stepper, mode, pins, en_pin, reverse);
+    } else {
+        return false;
+    }
+}
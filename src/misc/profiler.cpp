@@ -0,0 +1,71 @@
+#include "profiler.h"
+
+#include "lib/debug.h"
+
+void Profiler::begin() {
+    update_frequency();
+    reset();
+}
+
+void Profiler::update_frequency() {
+    _cycles_per_us = std::max<uint32_t>(1, ESP.getCpuFreqMHz());
+}
+
+void Profiler::reset() {
+    _sections = {};
+
+    _stall_section = ProfileSection::LOOP;
+    _stall_cycles = 0;
+
+    _reset_time = millis();
+
+    D_PRINT("Profiler: Reset");
+}
+
+void Profiler::_record(ProfileSection section, uint32_t start, uint32_t parent_child_cycles) {
+    const uint32_t total = _cycles() - start;
+
+    // LOOP is an aggregate, other sections keep exclusive time
+    const uint32_t duration = section == ProfileSection::LOOP ? total : total - std::min(total, _child_cycles);
+    _child_cycles = parent_child_cycles + total;
+
+    auto &entry = _sections[(uint8_t) section];
+    entry.count++;
+    entry.total += duration;
+    entry.max = std::max(entry.max, duration);
+
+    // Buckets are powers of two: [0, 8) us, [8, 16) us, ... [8 << (SIZE - 2), inf)
+    const uint32_t duration_us = duration / _cycles_per_us;
+    const uint8_t bucket = duration_us < 8 ? 0 : std::min<uint8_t>(PROFILE_HISTOGRAM_SIZE - 1, 29 - __builtin_clz(duration_us));
+    entry.histogram[bucket]++;
+
+    if (section != ProfileSection::LOOP && duration > _stall_cycles) {
+        _stall_cycles = duration;
+        _stall_section = section;
+    }
+}
+
+void Profiler::snapshot(const StepTimingStats &step_timing, const IdleStats &idle_stats) {
+    _info.window = millis() - _reset_time;
+
+    for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+        const auto &entry = _sections[i];
+        auto &info = _info.sections[i];
+
+        info.count = entry.count;
+        info.total = entry.total / _cycles_per_us;
+        info.max = entry.max / _cycles_per_us;
+        memcpy(info.histogram, entry.histogram, sizeof(info.histogram));
+    }
+
+    _info.stall_section = _stall_section;
+    _info.stall = _stall_cycles / _cycles_per_us;
+
+    _info.step_count = step_timing.count;
+    _info.step_requested = step_timing.count ? (float) step_timing.requested / step_timing.count : 0;
+    _info.step_achieved = step_timing.count ? (float) step_timing.achieved / step_timing.count : 0;
+    _info.step_max_lateness = step_timing.max_lateness;
+
+    _info.asleep = idle_stats.asleep / 1000;
+    _info.wakeups = idle_stats.wakeups;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "sys_constants.h"
+
+#include "idle_manager.h"
+#include "step_scheduler.h"
+
+MAKE_ENUM(ProfileSection, uint8_t,
+    LOOP, 0,                // Whole event loop iteration, inclusive
+    STEP_TICK, 1,
+    BOOTSTRAP, 2,           // WS / MQTT handling and timer callbacks not listed below
+    SERVICE_LOOP, 3,
+    BOOTSTRAP_SERVICE, 4,
+    MOVE_NOTIFICATION, 5,
+    PERIODIC_STATUS, 6,
+)
+
+constexpr uint8_t PROFILE_SECTION_COUNT = 7;
+
+struct __attribute ((packed)) ProfileSectionInfo {
+    uint32_t count = 0;
+    uint32_t total = 0;         // us, exclusive of nested sections
+    uint32_t max = 0;           // us
+    uint32_t histogram[PROFILE_HISTOGRAM_SIZE]{};
+};
+
+struct __attribute ((packed)) ProfileInfo {
+    uint32_t window = 0;        // ms since last reset
+
+    ProfileSectionInfo sections[PROFILE_SECTION_COUNT]{};
+
+    ProfileSection stall_section = ProfileSection::LOOP;
+    uint32_t stall = 0;         // us
+
+    uint32_t step_count = 0;
+    float step_requested = 0;   // Average step interval, us
+    float step_achieved = 0;
+    uint32_t step_max_lateness = 0;
+
+    uint32_t asleep = 0;        // ms spent in idle wait
+    uint32_t wakeups = 0;
+};
+
+/**
+ * Collects duration histograms using the CPU cycle counter.
+ * Nested sections are subtracted from the parent, so the stall is attributed to the innermost callback.
+ */
+class Profiler {
+    struct Section {
+        uint32_t count = 0;
+        uint64_t total = 0;
+        uint32_t max = 0;
+        uint32_t histogram[PROFILE_HISTOGRAM_SIZE]{};
+    };
+
+    std::array<Section, PROFILE_SECTION_COUNT> _sections{};
+
+    uint32_t _child_cycles = 0;
+    uint32_t _cycles_per_us = 1;
+
+    ProfileSection _stall_section = ProfileSection::LOOP;
+    uint32_t _stall_cycles = 0;
+
+    unsigned long _reset_time = 0;
+
+    ProfileInfo _info{};
+
+    friend class ProfileScope;
+
+public:
+    void begin();
+    void reset();
+
+    /**
+     * Cycle counter follows CPU frequency, call after frequency change.
+     */
+    void update_frequency();
+
+    void snapshot(const StepTimingStats &step_timing, const IdleStats &idle_stats);
+
+    [[nodiscard]] ProfileInfo &info() { return _info; }
+
+private:
+    static inline uint32_t _cycles() { return ESP.getCycleCount(); }
+
+    void _record(ProfileSection section, uint32_t start, uint32_t parent_child_cycles);
+};
+
+class ProfileScope {
+    Profiler &_profiler;
+    const ProfileSection _section;
+    const uint32_t _parent_child_cycles;
+    const uint32_t _start;
+
+public:
+    ProfileScope(Profiler &profiler, ProfileSection section) :
+        _profiler(profiler), _section(section), _parent_child_cycles(profiler._child_cycles), _start(Profiler::_cycles()) {
+        _profiler._child_cycles = 0;
+    }
+
+    ~ProfileScope() { _profiler._record(_section, _start, _parent_child_cycles); }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
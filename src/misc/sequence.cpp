@@ -0,0 +1,129 @@
+#include "sequence.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+static const char *_skip_spaces(const char *str) {
+    while (*str && isspace(*str)) ++str;
+    return str;
+}
+
+static bool _match_word(const char *&str, const char *word) {
+    const auto length = strlen(word);
+    if (strncasecmp(str, word, length) != 0) return false;
+    if (isalpha(str[length])) return false;
+
+    str = _skip_spaces(str + length);
+    return true;
+}
+
+static bool _parse_uint(const char *&str, uint32_t &value) {
+    if (!isdigit(*str)) return false;
+
+    char *end;
+    value = strtoul(str, &end, 10);
+    str = end;
+
+    return true;
+}
+
+static bool _parse_duration(const char *&str, uint32_t &seconds) {
+    uint32_t value;
+    if (!_parse_uint(str, value)) return false;
+
+    uint32_t unit = 1;
+    if (*str == 'h') unit = 3600;
+    else if (*str == 'm') unit = 60;
+
+    if (*str == 'h' || *str == 'm' || *str == 's') ++str;
+
+    // Checked before multiplying, so a large count can't wrap around into a short wait
+    if (value > SEQUENCE_MAX_WAIT / unit) {
+        D_PRINTF("Sequence: Wait is longer than %u sec\r\n", SEQUENCE_MAX_WAIT);
+        return false;
+    }
+
+    seconds = value * unit;
+    return true;
+}
+
+static bool _parse_time_of_day(const char *&str, uint32_t &seconds) {
+    uint32_t hours, minutes = 0;
+    if (!_parse_uint(str, hours) || hours > 23) return false;
+
+    if (*str == ':') {
+        ++str;
+        if (!_parse_uint(str, minutes) || minutes > 59) return false;
+    }
+
+    seconds = hours * 3600 + minutes * 60;
+    return true;
+}
+
+static bool _parse_speed(const char *&str, uint32_t &speed) {
+    if (_match_word(str, "slow")) speed = (uint32_t) Speed::SLOW;
+    else if (_match_word(str, "medium") || _match_word(str, "normal")) speed = (uint32_t) Speed::NORMAL;
+    else if (_match_word(str, "fast")) speed = (uint32_t) Speed::FAST;
+    else return _parse_uint(str, speed) && speed <= (uint32_t) Speed::FAST;
+
+    return true;
+}
+
+static bool _parse_step(const char *&str, SequenceStep &step) {
+    bool ok;
+    uint32_t arg = 0;
+
+    if (_match_word(str, "move")) {
+        step.op = SequenceOp::MOVE;
+        ok = _parse_uint(str, arg) && arg <= 100;
+    } else if (_match_word(str, "wait")) {
+        step.op = SequenceOp::WAIT;
+        ok = _parse_duration(str, arg);
+    } else if (_match_word(str, "speed")) {
+        step.op = SequenceOp::SPEED;
+        ok = _parse_speed(str, arg);
+    } else if (_match_word(str, "at")) {
+        step.op = SequenceOp::WAIT_TIME;
+        ok = _parse_time_of_day(str, arg);
+    } else if (_match_word(str, "home")) {
+        step.op = SequenceOp::HOME;
+        ok = true;
+    } else {
+        ok = false;
+    }
+
+    step.arg = arg;
+    str = _skip_spaces(str);
+    return ok && (*str == ';' || *str == '\0');
+}
+
+bool sequence_compile(const char *script, SequenceConfig &out, uint8_t *error_step) {
+    SequenceConfig result{};
+    uint8_t count = 0;
+
+    if (error_step) *error_step = 0;
+
+    const char *str = _skip_spaces(script);
+    while (*str) {
+        if (*str == ';') {
+            str = _skip_spaces(str + 1);
+            continue;
+        }
+
+        if (count >= SEQUENCE_MAX_STEPS) {
+            D_PRINTF("Sequence: Too many steps, max %u\r\n", SEQUENCE_MAX_STEPS);
+            if (error_step) *error_step = SEQUENCE_MAX_STEPS + 1;
+            return false;
+        }
+
+        if (!_parse_step(str, result.steps[count++])) {
+            D_PRINTF("Sequence: Syntax error in step %u\r\n", count);
+            if (error_step) *error_step = count;
+            return false;
+        }
+    }
+
+    out = result;
+    return true;
+}
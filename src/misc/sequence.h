@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/debug.h"
+
+#include "app/config.h"
+
+typedef char SequenceScript[SEQUENCE_SCRIPT_SIZE];
+
+/**
+ * Compiles text script into sequence steps. Steps are separated by ';':
+ *   move 60; wait 2m; speed slow; move 100; at 7:30; home
+ * Wait accepts seconds with optional 's', 'm' or 'h' suffix.
+ * @param error_step Set to 1-based number of the invalid step, SEQUENCE_MAX_STEPS + 1 if there are too many steps; 0 on success
+ * @return false on syntax error, in that case output is left untouched
+ */
+bool sequence_compile(const char *script, SequenceConfig &out, uint8_t *error_step = nullptr);
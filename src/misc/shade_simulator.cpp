@@ -0,0 +1,92 @@
+#include "shade_simulator.h"
+
+#include <cmath>
+
+ShadeSimulator::ShadeSimulator(const SimulatorConfig &config) : _config(config), _position(config.start_position) {
+    reset_noise();
+    _update_endstop();
+}
+
+void ShadeSimulator::power(bool enabled) {
+    _powered = enabled;
+    if (!enabled) _speed = 0;
+}
+
+void ShadeSimulator::step(bool close, uint32_t interval_us) {
+    _stats.steps++;
+
+    // Long period means the roller was at rest before this step
+    const bool rest = interval_us == 0 || interval_us > SIMULATOR_REST_INTERVAL;
+    const float direction = close ? 1.f : -1.f;
+    const float previous_speed = rest ? 0.f : _speed;
+    const float speed = rest ? 0.f : direction * 1e6f / (float) interval_us;
+    const float acceleration = rest ? 0.f : (speed - previous_speed) * 1e6f / (float) interval_us;
+
+    const float required = _required_torque(speed != 0 ? speed : direction, acceleration);
+    _stats.max_torque = std::max(_stats.max_torque, required);
+
+    const int32_t next_position = _position + (close ? 1 : -1);
+    const bool blocked = next_position < _config.top_limit || next_position > _config.fabric_length;
+
+    if (!_powered || blocked || required > _available_torque(speed)) {
+        // Rotor doesn't follow the field, it stays in place and loses momentum
+        _stats.lost_steps++;
+        _speed = 0;
+        return;
+    }
+
+    _speed = speed;
+    _position = next_position;
+
+    _update_endstop();
+}
+
+void ShadeSimulator::hall_frame(uint16_t *samples, size_t count) const {
+    const float scale = (float) (_config.endstop_position - _config.top_limit);
+    const float x = (float) (_position - _config.top_limit) / scale;
+    const float level = SIMULATOR_HALL_BASELINE + SIMULATOR_HALL_AMPLITUDE / (1.f + x * x * x);
+
+    for (size_t i = 0; i < count; ++i) {
+        if (_random(SIMULATOR_HALL_SPIKE_RATE) == 0) {
+            samples[i] = _random(2) ? ENDSTOP_ADC_MAX_VOLTAGE : 0;
+            continue;
+        }
+
+        // Sum of four uniform values is close to normal, scaled to SIMULATOR_HALL_NOISE deviation
+        float noise = 0;
+        for (uint8_t k = 0; k < 4; ++k) noise += ((float) _random(2001) - 1000.f) / 1000.f;
+        noise *= SIMULATOR_HALL_NOISE * std::sqrt(3.f) / 2.f;
+
+        samples[i] = (uint16_t) std::clamp(level + noise, 0.f, (float) ENDSTOP_ADC_MAX_VOLTAGE);
+    }
+}
+
+float ShadeSimulator::_required_torque(float speed, float acceleration) const {
+    const float hanging = (float) std::clamp<int32_t>(_position, 0, _config.fabric_length) / (float) _config.fabric_length;
+    const float direction = speed > 0 ? 1.f : -1.f;
+
+    // Gravity helps closing and resists opening, friction always resists
+    const float load = _config.friction - direction * _config.gravity * hanging;
+    return std::abs(_config.inertia * acceleration * direction + load);
+}
+
+float ShadeSimulator::_available_torque(float speed) const {
+    return std::max(0.f, 1.f - std::abs(speed) / _config.max_speed);
+}
+
+void ShadeSimulator::_update_endstop() {
+    if (_position <= _config.endstop_position) {
+        _endstop = true;
+    } else if (_position > _config.endstop_position + _config.endstop_hysteresis) {
+        _endstop = false;
+    }
+}
+
+uint32_t ShadeSimulator::_random(uint32_t max) const {
+    // Own xorshift generator, so noise doesn't depend on other random() users
+    _random_state ^= _random_state << 13;
+    _random_state ^= _random_state >> 17;
+    _random_state ^= _random_state << 5;
+
+    return _random_state % max;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+
+#include "sys_constants.h"
+
+struct SimulatorConfig {
+    float inertia = SIMULATOR_INERTIA;          // Torque per step/s², roller with fabric
+    float friction = SIMULATOR_FRICTION;        // Torque, opposes any movement
+    float gravity = SIMULATOR_GRAVITY;          // Torque of fully unrolled fabric, pulls down
+
+    float max_speed = SIMULATOR_MAX_SPEED;      // Steps/s where available torque drops to zero
+
+    int32_t fabric_length = SIMULATOR_FABRIC_LENGTH;
+    int32_t start_position = SIMULATOR_START_POSITION;
+
+    int32_t endstop_position = 0;               // Endstop triggers at or above this position
+    int32_t endstop_hysteresis = SIMULATOR_ENDSTOP_HYSTERESIS;
+    int32_t top_limit = -SIMULATOR_TOP_OVERTRAVEL; // Mechanical stop beyond the endstop
+
+    uint32_t seed = SIMULATOR_SEED;             // Sensor noise sequence, same seed gives the same run
+};
+
+struct SimulatorStats {
+    uint32_t steps = 0;
+    uint32_t lost_steps = 0;
+    float max_torque = 0;
+};
+
+/**
+ * Physical model of the roller shade, position is in motor steps from the endstop, positive is closing.
+ * Torque units are relative to the motor holding torque, steps are lost once the load exceeds the torque curve.
+ */
+class ShadeSimulator {
+    SimulatorConfig _config;
+    SimulatorStats _stats{};
+
+    int32_t _position;
+    float _speed = 0;
+
+    mutable uint32_t _random_state;
+
+    bool _powered = false;
+    bool _endstop = false;
+
+public:
+    explicit ShadeSimulator(const SimulatorConfig &config = {});
+
+    [[nodiscard]] const SimulatorConfig &config() const { return _config; }
+    [[nodiscard]] const SimulatorStats &stats() const { return _stats; }
+
+    [[nodiscard]] int32_t position() const { return _position; }
+    [[nodiscard]] bool endstop() const { return _endstop; }
+
+    /**
+     * Performs one step, interval is the planned step period in us. Speed is derived from the planner rather than
+     * from the wall clock, so the outcome doesn't depend on loop timing.
+     */
+    void step(bool close, uint32_t interval_us);
+    void power(bool enabled);
+
+    /**
+     * Synthetic Hall sensor frame for the current position, mV. Magnet is at the mechanical stop, field falls with
+     * the cube of distance and half of the amplitude is reached at the endstop position. Noise and rare spikes are added.
+     */
+    void hall_frame(uint16_t *samples, size_t count) const;
+
+    void reset_stats() { _stats = {}; }
+    void reset_noise() { _random_state = _config.seed ? _config.seed : 1; }
+
+private:
+    [[nodiscard]] float _required_torque(float speed, float acceleration) const;
+    [[nodiscard]] float _available_torque(float speed) const;
+
+    void _update_endstop();
+
+    [[nodiscard]] uint32_t _random(uint32_t max) const;
+};
+
+/**
+ * Static step and power handlers, so the simulator can be attached to GStepper2 instead of PhaseDriver.
+ */
+template<uint8_t Index, typename StepperT>
+class SimulatorDriver {
+    static inline ShadeSimulator *_simulator = nullptr;
+    static inline StepperT *_stepper = nullptr;
+
+public:
+    static void begin(ShadeSimulator &simulator, StepperT &stepper) {
+        _simulator = &simulator;
+        _stepper = &stepper;
+    }
+
+    static void step(uint8_t dir) { _simulator->step(dir != 0, _stepper->getPeriod()); }
+    static void power(bool enabled) { _simulator->power(enabled); }
+};
+
+template<uint8_t Index = 0, typename StepperT>
+bool attach_axis_simulator(uint8_t axis, StepperT &stepper, ShadeSimulator &simulator) {
+    if (axis == Index) {
+        SimulatorDriver<Index, StepperT>::begin(simulator, stepper);
+        stepper.attachStep(SimulatorDriver<Index, StepperT>::step);
+        stepper.attachPower(SimulatorDriver<Index, StepperT>::power);
+
+        return true;
+    }
+
+    if constexpr (Index + 1 < AXIS_MAX_COUNT) {
+        return attach_axis_simulator<Index + 1>(axis, stepper, simulator);
+    } else {
+        return false;
+    }
+}
@@ -0,0 +1,189 @@
+#include "speed_profile.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "lib/debug.h"
+
+uint8_t SpeedProfile::band(int32_t position) const {
+    const int32_t open_position = _config.stepper_calibration.open_position;
+    if (open_position <= 0) return 0;
+
+    position = std::clamp<int32_t>(position, 0, open_position - 1);
+    return (uint8_t) ((int64_t) position * SPEED_PROFILE_BANDS / open_position);
+}
+
+float SpeedProfile::speed_factor(int32_t position, int32_t target, int32_t lookahead) const {
+    if (!enabled()) return 1.f;
+
+    const auto direction = target < position ? MoveDirection::OPEN : MoveDirection::CLOSE;
+    const int32_t distance = std::min(std::abs(target - position), std::max<int32_t>(lookahead, 0));
+    const int32_t end = direction == MoveDirection::OPEN ? position - distance : position + distance;
+
+    const auto from = std::min(band(position), band(end));
+    const auto to = std::max(band(position), band(end));
+
+    const auto &speed = _config.speed_profile_state.speed[(uint8_t) direction];
+
+    uint8_t factor = UINT8_MAX;
+    for (uint8_t i = from; i <= to; ++i) factor = std::min(factor, _factor(speed[i]));
+
+    return (float) factor / 100.f;
+}
+
+float SpeedProfile::acceleration_factor(int32_t from, int32_t to) const {
+    if (!enabled()) return 1.f;
+
+    const auto direction = to < from ? MoveDirection::OPEN : MoveDirection::CLOSE;
+    const auto &acceleration = _config.speed_profile_state.acceleration[(uint8_t) direction];
+
+    // Acceleration matters where the move starts and stops
+    return (float) std::min(_factor(acceleration[band(from)]), _factor(acceleration[band(to)])) / 100.f;
+}
+
+void SpeedProfile::begin_move(int32_t from, int32_t to, bool from_rest) {
+    if (!enabled()) return;
+
+    const auto direction = to < from ? MoveDirection::OPEN : MoveDirection::CLOSE;
+
+    // Retargeted move keeps accounting from the current position
+    if (!_tracking) _last_position = from;
+    _tracking = true;
+
+    auto &stops = _exposure.stops[(uint8_t) direction];
+    if (from_rest && stops[band(from)] < UINT16_MAX) ++stops[band(from)];
+    if (stops[band(to)] < UINT16_MAX) ++stops[band(to)];
+}
+
+void SpeedProfile::track(int32_t position) {
+    if (!_tracking || !enabled()) return;
+
+    const int32_t delta = position - _last_position;
+    if (delta == 0) return;
+
+    const auto direction = delta < 0 ? MoveDirection::OPEN : MoveDirection::CLOSE;
+    _exposure.steps[(uint8_t) direction][band(position)] += std::abs(delta);
+
+    _last_position = position;
+}
+
+void SpeedProfile::end_move(int32_t position) {
+    track(position);
+    _tracking = false;
+}
+
+bool SpeedProfile::observe(int32_t drift) {
+    bool changed = false;
+
+    if (enabled()) {
+        if (std::abs(drift) < _config.stepper_config.drift_correction_threshold) {
+            changed |= _increase(MoveDirection::OPEN);
+            changed |= _increase(MoveDirection::CLOSE);
+        } else {
+            changed = _decrease(drift < 0 ? MoveDirection::OPEN : MoveDirection::CLOSE);
+        }
+    }
+
+    reset_exposure();
+    return changed;
+}
+
+bool SpeedProfile::observe_loss(MoveDirection direction) {
+    const bool changed = enabled() && _decrease(direction);
+
+    reset_exposure();
+    return changed;
+}
+
+bool SpeedProfile::observe_missed() {
+    bool changed = false;
+
+    if (enabled()) {
+        // Endstop wasn't reached at all, so it's unknown which direction lost steps
+        changed |= _decrease(MoveDirection::OPEN);
+        changed |= _decrease(MoveDirection::CLOSE);
+    }
+
+    reset_exposure();
+    return changed;
+}
+
+void SpeedProfile::reset_exposure() {
+    _exposure = {};
+}
+
+void SpeedProfile::reset() {
+    _config.speed_profile_state = {};
+    reset_exposure();
+}
+
+uint8_t SpeedProfile::_factor(uint8_t value) const {
+    const auto &cfg = _config.speed_profile;
+    if (value == 0) value = SPEED_PROFILE_DEFAULT_FACTOR;
+
+    return std::min(std::max(value, cfg.min_factor), cfg.max_factor);
+}
+
+bool SpeedProfile::_increase(MoveDirection direction) {
+    const auto max_factor = _config.speed_profile.max_factor;
+
+    auto &state = _config.speed_profile_state;
+    auto &speed = state.speed[(uint8_t) direction];
+    auto &acceleration = state.acceleration[(uint8_t) direction];
+
+    const auto &steps = _exposure.steps[(uint8_t) direction];
+    const auto &stops = _exposure.stops[(uint8_t) direction];
+
+    bool changed = false;
+    for (uint8_t i = 0; i < SPEED_PROFILE_BANDS; ++i) {
+        if (steps[i] >= SPEED_PROFILE_MIN_EXPOSURE) {
+            const auto value = (uint8_t) std::min<uint32_t>(_factor(speed[i]) + SPEED_PROFILE_INCREASE, max_factor);
+            changed |= value != speed[i];
+            speed[i] = value;
+        }
+
+        if (stops[i] > 0) {
+            const auto value = (uint8_t) std::min<uint32_t>(_factor(acceleration[i]) + SPEED_PROFILE_INCREASE, max_factor);
+            changed |= value != acceleration[i];
+            acceleration[i] = value;
+        }
+    }
+
+    return changed;
+}
+
+bool SpeedProfile::_decrease(MoveDirection direction) {
+    // Zero is reserved for bands without history
+    const auto min_factor = std::max<uint8_t>(_config.speed_profile.min_factor, 1);
+
+    auto &state = _config.speed_profile_state;
+    auto &speed = state.speed[(uint8_t) direction];
+    auto &acceleration = state.acceleration[(uint8_t) direction];
+
+    const auto &steps = _exposure.steps[(uint8_t) direction];
+    const auto &stops = _exposure.stops[(uint8_t) direction];
+
+    const auto max_steps = *std::max_element(std::begin(steps), std::end(steps));
+    const auto max_stops = *std::max_element(std::begin(stops), std::end(stops));
+
+    bool changed = false;
+    for (uint8_t i = 0; i < SPEED_PROFILE_BANDS; ++i) {
+        // Bands are blamed in proportion to their usage, the most used one loses the whole SPEED_PROFILE_DECREASE
+        if (steps[i] > 0) {
+            const float share = (float) steps[i] / (float) max_steps;
+            const auto value = (uint8_t) std::max<float>(min_factor, (float) _factor(speed[i]) * (1.f - SPEED_PROFILE_DECREASE * share));
+            changed |= value != speed[i];
+            speed[i] = value;
+        }
+
+        if (stops[i] > 0) {
+            const float share = (float) stops[i] / (float) max_stops;
+            const auto value = (uint8_t) std::max<float>(min_factor, (float) _factor(acceleration[i]) * (1.f - SPEED_PROFILE_DECREASE * share));
+            changed |= value != acceleration[i];
+            acceleration[i] = value;
+        }
+    }
+
+    if (changed) D_PRINTF("Speed Profile: Step loss while %s, factors lowered\r\n", __debug_enum_str(direction));
+    return changed;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lib/utils/enum.h"
+
+#include "app/config.h"
+
+MAKE_ENUM(MoveDirection, uint8_t,
+    OPEN, 0,
+    CLOSE, 1,
+)
+
+struct SpeedProfileExposure {
+    uint32_t steps[2][SPEED_PROFILE_BANDS]{};   // Steps made in band since the last observation
+    uint16_t stops[2][SPEED_PROFILE_BANDS]{};   // Moves started or finished in band since the last observation
+};
+
+/**
+ * Learns speed and acceleration factors per direction and travel band from step loss observed at the endstop.
+ * Steps are accounted to bands while moving; a probe without drift raises factors of every used band,
+ * drift lowers them in the direction it points to, proportionally to the band usage (additive increase, multiplicative decrease).
+ * Drift sign tells the direction: steps lost while opening make the endstop found late, while closing - early.
+ */
+class SpeedProfile {
+    AxisConfig &_config;
+
+    SpeedProfileExposure _exposure{};
+    int32_t _last_position = 0;
+    bool _tracking = false;
+
+public:
+    explicit SpeedProfile(AxisConfig &config) : _config(config) {}
+
+    [[nodiscard]] bool enabled() const { return _config.speed_profile.enabled; }
+    [[nodiscard]] uint8_t band(int32_t position) const;
+
+    /**
+     * @param lookahead Distance in direction of travel, slower bands within it limit the speed.
+     * @return Lowest speed factor between position and target
+     */
+    [[nodiscard]] float speed_factor(int32_t position, int32_t target, int32_t lookahead) const;
+    [[nodiscard]] float acceleration_factor(int32_t from, int32_t to) const;
+
+    /**
+     * Starts accounting steps to bands, only regular moves are accounted: homing, probes and sunrise run at homing speeds.
+     */
+    void begin_move(int32_t from, int32_t to, bool from_rest);
+    void track(int32_t position);
+    void end_move(int32_t position);
+
+    /**
+     * @return true if learned factors were changed
+     */
+    bool observe(int32_t drift);
+    bool observe_loss(MoveDirection direction);
+    bool observe_missed();
+
+    void reset_exposure();
+    void reset();
+
+private:
+    [[nodiscard]] uint8_t _factor(uint8_t value) const;
+
+    bool _increase(MoveDirection direction);
+    bool _decrease(MoveDirection direction);
+};
@@ -0,0 +1,66 @@
+#include "static_assets.h"
+
+#include "lib/debug.h"
+
+void StaticAssets::handle(AsyncWebServerRequest *request) {
+    const String name = request->url().substring(strlen(STATIC_ASSETS_URL));
+    if (name.length() == 0 || name.indexOf('/') >= 0) {
+        request->send(404);
+        return;
+    }
+
+    const String etag = _etag(name);
+    if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag) {
+        auto *response = request->beginResponse(304);
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", STATIC_ASSETS_CACHE_CONTROL);
+        request->send(response);
+        return;
+    }
+
+    const String path = String(STATIC_ASSETS_DIR "/") + name;
+    const bool accept_brotli = request->hasHeader("Accept-Encoding")
+                               && request->getHeader("Accept-Encoding")->value().indexOf("br") >= 0;
+
+    String file_path;
+    const char *encoding;
+    if (accept_brotli && _fs.exists(path + ".br")) {
+        file_path = path + ".br";
+        encoding = "br";
+    } else if (_fs.exists(path + ".gz")) {
+        file_path = path + ".gz";
+        encoding = "gzip";
+    } else {
+        D_PRINTF("Static: Asset not found: %s\r\n", name.c_str());
+        request->send(404);
+        return;
+    }
+
+    auto *response = request->beginResponse(_fs, file_path, _content_type(name));
+    response->addHeader("Content-Encoding", encoding);
+    response->addHeader("Cache-Control", STATIC_ASSETS_CACHE_CONTROL);
+    response->addHeader("ETag", etag);
+    response->addHeader("Vary", "Accept-Encoding");
+
+    request->send(response);
+}
+
+String StaticAssets::_etag(const String &name) {
+    // Hash is the last dash-separated part before the extension
+    const int ext_index = name.lastIndexOf('.');
+    const int hash_index = name.lastIndexOf('-');
+
+    if (hash_index < 0 || ext_index <= hash_index) return "\"" + name + "\"";
+    return "\"" + name.substring(hash_index + 1, ext_index) + "\"";
+}
+
+const char *StaticAssets::_content_type(const String &name) {
+    if (name.endsWith(".js")) return "application/javascript";
+    if (name.endsWith(".css")) return "text/css";
+    if (name.endsWith(".png")) return "image/png";
+    if (name.endsWith(".svg")) return "image/svg+xml";
+    if (name.endsWith(".ico")) return "image/x-icon";
+    if (name.endsWith(".webmanifest")) return "application/manifest+json";
+
+    return "application/octet-stream";
+}
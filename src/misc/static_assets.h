@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+
+#include "sys_constants.h"
+
+/**
+ * Serves fingerprinted web assets produced by the web build: STATIC_ASSETS_URL/<name>-<hash>.<ext>
+ * is mapped to precompressed STATIC_ASSETS_DIR/<name>-<hash>.<ext>.br or .gz file.
+ * Content never changes for the same name, so responses are immutable and the hash is used as ETag.
+ */
+class StaticAssets {
+    fs::FS &_fs;
+
+public:
+    explicit StaticAssets(fs::FS &fs) : _fs(fs) {}
+
+    void handle(AsyncWebServerRequest *request);
+
+private:
+    static String _etag(const String &name);
+    static const char *_content_type(const String &name);
+};
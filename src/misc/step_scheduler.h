@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <array>
+#include <cstdint>
+
+struct __attribute ((packed)) StepTimingStats {
+    uint32_t count = 0;
+    uint64_t requested = 0;     // Sum of planned step periods, us
+    uint64_t achieved = 0;      // Sum of actual intervals between steps, us
+    uint32_t max_lateness = 0;  // us
+};
+
+typedef unsigned long (*StepClockFn)();
+
+/**
+ * Steps several planners from one loop, always serving the earliest deadline first.
+ * Each stepper is ticked with tickManual() when its own period elapses, so idle loop iterations
+ * cost a single time comparison regardless of axis count.
+ * Achieved step intervals are accumulated in timing() to compare them with requested ones.
+ * Clock is a template parameter, so host tests can drive time without a call overhead on the device.
+ */
+template<typename StepperT, uint8_t Capacity, StepClockFn Clock = micros>
+class StepScheduler {
+    struct Entry {
+        StepperT *stepper = nullptr;
+        uint32_t deadline = 0;
+        uint32_t period = 0;
+        uint32_t last_step = 0;
+        bool active = false;
+    };
+
+    std::array<Entry, Capacity> _entries{};
+    uint8_t _count = 0;
+
+    uint32_t _next_deadline = 0;
+    bool _active = false;
+
+    StepTimingStats _timing{};
+
+public:
+    bool add(StepperT *stepper) {
+        if (_count >= Capacity) return false;
+
+        _entries[_count++] = {.stepper = stepper};
+        return true;
+    }
+
+    [[nodiscard]] bool active() const { return _active; }
+    [[nodiscard]] uint32_t next_deadline() const { return _next_deadline; }
+
+    [[nodiscard]] const StepTimingStats &timing() const { return _timing; }
+    void reset_timing() { _timing = {}; }
+
+    bool tick() {
+        const uint32_t now = Clock();
+
+        // Planners don't report new targets, so idle axes are checked for movement start
+        for (uint8_t i = 0; i < _count; ++i) {
+            auto &entry = _entries[i];
+            if (entry.active || entry.stepper->getStatus() == 0) continue;
+
+            entry.active = true;
+            entry.deadline = now;
+            entry.period = 0;
+
+            _next_deadline = now;
+            _active = true;
+        }
+
+        if (!_active || (int32_t) (now - _next_deadline) < 0) return _active;
+
+        bool active = false;
+        uint32_t next_delay = UINT32_MAX;
+
+        for (uint8_t i = 0; i < _count; ++i) {
+            auto &entry = _entries[i];
+            if (!entry.active) continue;
+
+            if ((int32_t) (now - entry.deadline) >= 0) {
+                if (entry.period) _record_timing(entry, now);
+
+                entry.stepper->tickManual();
+                entry.last_step = now;
+
+                if (entry.stepper->getStatus() == 0) {
+                    entry.active = false;
+                    continue;
+                }
+
+                const uint32_t period = entry.stepper->getPeriod();
+                entry.period = period;
+                entry.deadline += period;
+
+                // Late axis restarts from now, catching up would produce a burst of steps
+                if ((int32_t) (now - entry.deadline) >= 0) entry.deadline = now + period;
+            }
+
+            active = true;
+            next_delay = std::min(next_delay, entry.deadline - now);
+        }
+
+        _active = active;
+        _next_deadline = now + next_delay;
+
+        return _active;
+    }
+
+private:
+    void _record_timing(const Entry &entry, uint32_t now) {
+        const uint32_t lateness = now - entry.deadline;
+
+        _timing.count++;
+        _timing.requested += entry.period;
+        _timing.achieved += now - entry.last_step;
+        _timing.max_lateness = std::max(_timing.max_lateness, lateness);
+    }
+};
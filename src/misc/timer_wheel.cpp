@@ -0,0 +1,255 @@
+#include "timer_wheel.h"
+
+#include "lib/debug.h"
+
+static inline uint64_t rotate_right(uint64_t value, uint32_t shift) {
+    shift &= 63;
+    return shift ? (value >> shift) | (value << (64 - shift)) : value;
+}
+
+TimerWheel::TimerWheel() {
+    std::fill(std::begin(_heads), std::end(_heads), NONE);
+}
+
+void TimerWheel::begin() {
+    _current = millis();
+}
+
+unsigned long TimerWheel::add_timeout(TimerWheelFn fn, unsigned long timeout, void *parameter) {
+    return _add(std::move(fn), timeout, parameter, false);
+}
+
+unsigned long TimerWheel::add_interval(TimerWheelFn fn, unsigned long interval, void *parameter) {
+    return _add(std::move(fn), interval, parameter, true);
+}
+
+unsigned long TimerWheel::_add(TimerWheelFn &&fn, unsigned long delay, void *parameter, bool repeat) {
+    const auto index = _allocate();
+    if (index == NONE) {
+        D_PRINT("TimerWheel: Unable to allocate timer");
+        return -1ul;
+    }
+
+    auto &entry = _entries[index];
+    entry.fn = std::move(fn);
+    entry.parameter = parameter;
+    entry.interval = delay;
+    entry.expires = millis() + delay;
+    entry.repeat = repeat;
+
+    _schedule(index);
+
+    // Index never reaches NONE, so id is never equal to -1ul
+    return ((unsigned long) entry.generation << 16) | index;
+}
+
+void TimerWheel::_clear(unsigned long id) {
+    const uint16_t index = id & 0xffff;
+    if (index >= _entries.size()) return;
+
+    auto &entry = _entries[index];
+    if (entry.list == NONE || entry.generation != (uint16_t) (id >> 16)) return;
+
+    _unlink(index);
+    _release(index);
+}
+
+void TimerWheel::handle_timers() {
+    const uint32_t now = millis();
+
+    if (_size == 0) {
+        _set_current(now + 1);
+        return;
+    }
+
+    while ((int32_t) (now - _current) >= 0) {
+        const uint64_t pending = _occupied[0] >> (_current & SLOT_MASK);
+
+        // Nothing left in this revolution of level 0, skip to the next cascade
+        if (pending == 0) {
+            const uint32_t boundary = (_current | SLOT_MASK) + 1;
+            _set_current((int32_t) (now - boundary) < 0 ? now + 1 : boundary);
+            continue;
+        }
+
+        const uint32_t due = _current + __builtin_ctzll(pending);
+        if ((int32_t) (now - due) < 0) {
+            _set_current(now + 1);
+            break;
+        }
+
+        const uint16_t list = due & SLOT_MASK;
+        _heads[DUE_LIST] = _heads[list];
+        for (auto index = _heads[DUE_LIST]; index != NONE; index = _entries[index].next) {
+            _entries[index].list = DUE_LIST;
+        }
+
+        _heads[list] = NONE;
+        _occupied[0] &= ~(1ull << list);
+
+        // Advance before firing, so timers added from callbacks are never scheduled into the fired slot
+        _set_current(due + 1);
+        _fire_due(now);
+    }
+}
+
+unsigned long TimerWheel::next_deadline() const {
+    if (_size == 0) return -1ul;
+
+    uint32_t min_delta = UINT32_MAX;
+    for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        if (_occupied[level] == 0) continue;
+
+        const uint32_t shift = level * TIMER_WHEEL_LEVEL_BITS;
+        const uint32_t current = _current >> shift;
+
+        uint32_t delta;
+        if (level == 0) {
+            delta = __builtin_ctzll(rotate_right(_occupied[0], current & SLOT_MASK));
+        } else {
+            // Current slot of the upper level is already cascaded, so it holds timers for the next revolution
+            const uint32_t offset = __builtin_ctzll(rotate_right(_occupied[level], (current + 1) & SLOT_MASK)) + 1;
+            delta = ((current + offset) << shift) - _current;
+        }
+
+        min_delta = std::min(min_delta, delta);
+    }
+
+    const int32_t remaining = (int32_t) (_current + min_delta - millis());
+    return remaining > 0 ? remaining : 0;
+}
+
+uint16_t TimerWheel::_allocate() {
+    if (_free == NONE) {
+        const auto size = _entries.size();
+        const auto new_size = std::min<size_t>(size + TIMER_GROW_AMOUNT, NONE);
+        if (new_size == size) return NONE;
+
+        _entries.resize(new_size);
+        for (auto i = new_size; i > size; --i) {
+            _entries[i - 1].next = _free;
+            _free = i - 1;
+        }
+    }
+
+    const auto index = _free;
+    _free = _entries[index].next;
+    _size++;
+
+    return index;
+}
+
+void TimerWheel::_release(uint16_t index) {
+    auto &entry = _entries[index];
+    entry.fn = nullptr;
+    entry.parameter = nullptr;
+    entry.generation++;
+
+    entry.list = NONE;
+    entry.prev = NONE;
+    entry.next = _free;
+    _free = index;
+
+    _size--;
+}
+
+void TimerWheel::_schedule(uint16_t index) {
+    auto &entry = _entries[index];
+
+    uint32_t delta = entry.expires - _current;
+    if ((int32_t) delta < 0) {
+        entry.expires = _current;
+        delta = 0;
+    }
+
+    uint8_t level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1u << ((level + 1) * TIMER_WHEEL_LEVEL_BITS))) ++level;
+
+    const uint32_t slot = (entry.expires >> (level * TIMER_WHEEL_LEVEL_BITS)) & SLOT_MASK;
+    _link(level * SLOT_COUNT + slot, index);
+}
+
+void TimerWheel::_link(uint16_t list, uint16_t index) {
+    auto &entry = _entries[index];
+    entry.list = list;
+    entry.prev = NONE;
+    entry.next = _heads[list];
+
+    if (entry.next != NONE) _entries[entry.next].prev = index;
+    _heads[list] = index;
+
+    if (list != DUE_LIST) _occupied[list / SLOT_COUNT] |= 1ull << (list & SLOT_MASK);
+}
+
+void TimerWheel::_unlink(uint16_t index) {
+    auto &entry = _entries[index];
+    const auto list = entry.list;
+
+    if (entry.prev != NONE) {
+        _entries[entry.prev].next = entry.next;
+    } else {
+        _heads[list] = entry.next;
+    }
+
+    if (entry.next != NONE) _entries[entry.next].prev = entry.prev;
+
+    entry.list = NONE;
+    entry.prev = entry.next = NONE;
+
+    if (list != DUE_LIST && _heads[list] == NONE) {
+        _occupied[list / SLOT_COUNT] &= ~(1ull << (list & SLOT_MASK));
+    }
+}
+
+void TimerWheel::_set_current(uint32_t time) {
+    _current = time;
+    if ((_current & SLOT_MASK) != 0) return;
+
+    // Level 0 wrapped around: move timers of the next upper slot down, continue while upper levels wrap as well
+    for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+        const uint32_t slot = (_current >> (level * TIMER_WHEEL_LEVEL_BITS)) & SLOT_MASK;
+        _cascade(level, slot);
+
+        if (slot != 0) break;
+    }
+}
+
+void TimerWheel::_cascade(uint8_t level, uint32_t slot) {
+    const uint16_t list = level * SLOT_COUNT + slot;
+
+    auto index = _heads[list];
+    _heads[list] = NONE;
+    _occupied[level] &= ~(1ull << slot);
+
+    while (index != NONE) {
+        const auto next = _entries[index].next;
+        _schedule(index);
+        index = next;
+    }
+}
+
+void TimerWheel::_fire_due(uint32_t now) {
+    while (_heads[DUE_LIST] != NONE) {
+        const auto index = _heads[DUE_LIST];
+        _unlink(index);
+
+        auto &entry = _entries[index];
+        void *parameter = entry.parameter;
+
+        if (entry.repeat) {
+            // Callback may clear own interval, so it is called from a copy
+            auto fn = entry.fn;
+
+            // Zero interval still waits for the next tick, otherwise it fires again within this call
+            entry.expires = now + std::max<uint32_t>(entry.interval, 1);
+            _schedule(index);
+
+            fn(parameter);
+        } else {
+            auto fn = std::move(entry.fn);
+            _release(index);
+
+            fn(parameter);
+        }
+    }
+}
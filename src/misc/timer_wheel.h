@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "sys_constants.h"
+
+typedef std::function<void(void *parameter)> TimerWheelFn;
+
+/**
+ * Hierarchical timing wheel with 1 ms resolution and the same interface as Timer.
+ * Add and clear are O(1); timers are kept in per-slot intrusive lists, so a tick only visits due slots.
+ * Far timers are stored on coarse levels and cascaded down when the lower level wraps around.
+ */
+class TimerWheel {
+    static constexpr uint32_t SLOT_COUNT = 1u << TIMER_WHEEL_LEVEL_BITS;
+    static constexpr uint32_t SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr uint16_t LIST_COUNT = TIMER_WHEEL_LEVELS * SLOT_COUNT + 1;
+    static constexpr uint16_t DUE_LIST = LIST_COUNT - 1;   // Timers detached from slot and being fired
+    static constexpr uint16_t NONE = 0xffff;
+
+    struct Entry {
+        TimerWheelFn fn;
+        void *parameter = nullptr;
+
+        uint32_t interval = 0;
+        uint32_t expires = 0;
+        bool repeat = false;
+
+        uint16_t list = NONE;
+        uint16_t prev = NONE;
+        uint16_t next = NONE;
+        uint16_t generation = 0;
+    };
+
+    std::vector<Entry> _entries{};
+    uint16_t _free = NONE;
+    uint16_t _size = 0;
+
+    uint16_t _heads[LIST_COUNT]{};
+    uint64_t _occupied[TIMER_WHEEL_LEVELS]{};
+
+    uint32_t _current = 0;
+
+public:
+    TimerWheel();
+
+    void begin();
+
+    unsigned long add_timeout(TimerWheelFn fn, unsigned long timeout, void *parameter = nullptr);
+    unsigned long add_interval(TimerWheelFn fn, unsigned long interval, void *parameter = nullptr);
+
+    void clear_timeout(unsigned long id) { _clear(id); }
+    void clear_interval(unsigned long id) { _clear(id); }
+
+    void handle_timers();
+
+    [[nodiscard]] uint16_t size() const { return _size; }
+
+    /**
+     * @return ms until the next timer may fire, 0 if overdue, -1ul if there are no timers.
+     * Timers on coarse levels are reported at their cascade time, so the value is never later than actual deadline.
+     */
+    [[nodiscard]] unsigned long next_deadline() const;
+
+private:
+    unsigned long _add(TimerWheelFn &&fn, unsigned long delay, void *parameter, bool repeat);
+    void _clear(unsigned long id);
+
+    uint16_t _allocate();
+    void _release(uint16_t index);
+
+    void _schedule(uint16_t index);
+    void _link(uint16_t list, uint16_t index);
+    void _unlink(uint16_t index);
+
+    void _set_current(uint32_t time);
+    void _cascade(uint8_t level, uint32_t slot);
+    void _fire_due(uint32_t now);
+};
@@ -0,0 +1,83 @@
+#include "transaction.h"
+
+#include "lib/debug.h"
+
+void Transaction::begin() {
+    if (open()) D_PRINTF("Transaction: #%u discarded\r\n", _status.id);
+
+    _staging.clear();
+    _staging.reserve(TX_STAGING_SIZE);
+
+    _status = {
+        .id = (uint16_t) (_status.id + 1),
+        .state = TransactionState::OPEN,
+        .revision = _status.revision,
+    };
+
+    D_PRINTF("Transaction: #%u started\r\n", _status.id);
+}
+
+void Transaction::append() {
+    if (!open()) {
+        D_PRINT("Transaction: Batch received without TX_BEGIN");
+        return;
+    }
+
+    // First error is kept until commit, remaining batches are ignored
+    if (_status.error != TransactionError::NONE) return;
+
+    const size_t length = std::min<size_t>(_batch.length, TX_BATCH_SIZE);
+    if (_staging.size() + length > TX_STAGING_SIZE) {
+        _status.error = TransactionError::TOO_LARGE;
+        _status.failed_type = PacketType::TX_SET;
+        return;
+    }
+
+    _staging.insert(_staging.end(), _batch.data, _batch.data + length);
+    _status.staged = _staging.size();
+}
+
+TransactionError Transaction::visit(const TransactionEntryFn &fn, PacketType &failed_type) const {
+    if (_status.error != TransactionError::NONE) {
+        failed_type = _status.failed_type;
+        return _status.error;
+    }
+
+    size_t offset = 0;
+    while (offset < _staging.size()) {
+        if (offset + 2 > _staging.size()) {
+            failed_type = PacketType::TX_SET;
+            return TransactionError::MALFORMED;
+        }
+
+        const auto type = (PacketType) _staging[offset];
+        const uint8_t size = _staging[offset + 1];
+
+        failed_type = type;
+        if (offset + 2 + size > _staging.size()) return TransactionError::MALFORMED;
+
+        if (auto error = fn(type, _staging.data() + offset + 2, size); error != TransactionError::NONE) return error;
+
+        offset += 2 + size;
+    }
+
+    return TransactionError::NONE;
+}
+
+void Transaction::finish(TransactionError error, PacketType failed_type, uint16_t count, uint32_t revision) {
+    _staging.clear();
+    _staging.shrink_to_fit();
+
+    _status.state = error == TransactionError::NONE ? TransactionState::COMMITTED : TransactionState::FAILED;
+    _status.error = error;
+    _status.failed_type = error == TransactionError::NONE ? PacketType::POWER : failed_type;
+    _status.count = count;
+    _status.staged = 0;
+    _status.revision = revision;
+
+    if (error == TransactionError::NONE) {
+        D_PRINTF("Transaction: #%u committed, %u parameters\r\n", _status.id, count);
+    } else {
+        D_PRINTF("Transaction: #%u failed: %s (%s)\r\n", _status.id, __debug_enum_str(error), __debug_enum_str(failed_type));
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "lib/utils/enum.h"
+
+#include "cmd.h"
+#include "sys_constants.h"
+
+MAKE_ENUM(TransactionState, uint8_t,
+    IDLE, 0,
+    OPEN, 1,
+    COMMITTED, 2,
+    FAILED, 3,
+)
+
+MAKE_ENUM(TransactionError, uint8_t,
+    NONE, 0,
+    NOT_STARTED, 1,
+    TOO_LARGE, 2,
+    MALFORMED, 3,
+    UNKNOWN_PARAMETER, 4,
+    NOT_ALLOWED, 5,
+    SIZE_MISMATCH, 6,
+    REJECTED, 7,
+)
+
+struct __attribute ((packed)) TransactionBatch {
+    uint8_t length = 0;                 // Used bytes of data
+    uint8_t data[TX_BATCH_SIZE]{};      // Entries: type (1), size (1), value (size)
+};
+
+struct __attribute ((packed)) TransactionStatus {
+    uint16_t id = 0;                    // Incremented on every TX_BEGIN
+    TransactionState state = TransactionState::IDLE;
+    TransactionError error = TransactionError::NONE;
+    PacketType failed_type = PacketType::POWER;
+    uint16_t count = 0;                 // Parameters applied by the last commit
+    uint16_t staged = 0;                // Bytes staged by TX_SET since TX_BEGIN
+    uint32_t revision = 0;              // Config revision after the last commit
+};
+
+typedef std::function<TransactionError(PacketType type, const uint8_t *value, uint8_t size)> TransactionEntryFn;
+
+/**
+ * Stages parameter values received in TX_SET batches between TX_BEGIN and TX_COMMIT.
+ * Application validates and applies all staged entries at once, see Application::_commit_transaction.
+ */
+class Transaction {
+    TransactionBatch _batch{};
+    TransactionStatus _status{};
+
+    std::vector<uint8_t> _staging{};
+
+public:
+    [[nodiscard]] bool open() const { return _status.state == TransactionState::OPEN; }
+
+    [[nodiscard]] TransactionBatch &batch() { return _batch; }
+    [[nodiscard]] TransactionStatus &status() { return _status; }
+
+    void begin();
+    void append();
+
+    TransactionError visit(const TransactionEntryFn &fn, PacketType &failed_type) const;
+
+    void finish(TransactionError error, PacketType failed_type, uint16_t count, uint32_t revision);
+};
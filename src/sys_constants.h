@@ -12,10 +12,19 @@
 
 #define STORAGE_PATH                            ("/__storage/")
 #define STORAGE_HEADER                          ((uint32_t) 0xd0b2c453)
-#define STORAGE_CONFIG_VERSION                  ((uint8_t) 1)
+#define STORAGE_CONFIG_VERSION                  ((uint8_t) 9)
 #define STORAGE_SAVE_INTERVAL                   (60000u)                // Wait before commit settings to FLASH
 
+#define CONFIG_LOG_PATH                         "/__storage/config.log"
+#define CONFIG_LOG_TMP_PATH                     "/__storage/config.log.tmp"
+#define CONFIG_LOG_SIGNATURE                    ((uint32_t) 0x474c4643)
+#define CONFIG_LOG_VERSION                      ((uint8_t) 1)
+#define CONFIG_LOG_COMPACT_SIZE                 (4096u)                 // Log is rewritten with current values above this size
+#define CONFIG_LOG_SAVE_DELAY                   (1000u)                 // Coalesces bursts of changes into one append
+
 #define TIMER_GROW_AMOUNT                       (8u)
+#define TIMER_WHEEL_LEVEL_BITS                  (6u)                    // 64 slots per level
+#define TIMER_WHEEL_LEVELS                      (6u)                    // 6 * 6 bits cover whole 32-bit ms range
 
 #define PIN_DISABLED                            (LOW)
 #define PIN_ENABLED                             (HIGH)
@@ -28,10 +37,109 @@
 #define APP_STATE_NOTIFICATION_INTERVAL         (10000u)
 #define APP_STATE_MOVE_NOTIFICATION_INTERVAL    (700u)
 
+#define IDLE_ENTER_DELAY                        (5000u)                 // Time (ms) without activity before idle mode
+#define IDLE_MAX_SLEEP_INTERVAL                 (50u)                   // Bounds latency of queued network packets and framework timers
+#define IDLE_CPU_FREQUENCY                      (80u)                   // Minimal frequency (MHz) supported with Wi-Fi
+
+#define PROFILE_HISTOGRAM_SIZE                  (12u)                   // Power of two buckets starting from 8 us
+#define PROFILE_SNAPSHOT_INTERVAL               (1000u)
+
+#define TRACE_BUFFER_SIZE                       (2048u)
+#define TRACE_MAX_PAYLOAD_SIZE                  (64u)
+
+#ifndef EVENT_TRACE_LEVEL
+#define EVENT_TRACE_LEVEL                       (2u)                    // 0 - disabled, 1 - errors, 2 - events, 3 - details
+#endif
+
+#define EVENT_TRACE_SIZE                        (256u)                  // Records in ring, must be power of two
+#define EVENT_TRACE_PATH                        "/events"
+
+#define TX_BATCH_SIZE                           (240u)                  // Entries payload of a single TX_SET packet
+#define TX_STAGING_SIZE                         (1024u)                 // Entries staged until commit
+
+#define STATIC_ASSETS_URL                       "/static/"
+#define STATIC_ASSETS_DIR                       "/assets"
+#define STATIC_ASSETS_CACHE_CONTROL             "public, max-age=31536000, immutable"
+
+#define MQTT_OUTBOX_SIZE                        (32u)                   // Published topics, only the latest value of each is kept
+#define MQTT_INBOX_SIZE                         (8u)                    // Received messages waiting for the event loop
+#define MQTT_MAX_INFLIGHT                       (8u)                    // Unacknowledged QoS 1 publishes
+#define MQTT_KEEP_ALIVE                         (15u)                   // s
+
+#define METRICS_PATH                            "/metrics"
+#define METRICS_RESPONSE_RESERVE                (4096u)
+
 #define CONFIG_STRING_SIZE                      (32u)
 
 #define BTN_HOLD_CALL_INTERVAL                  (20u)
 
-#define STEPPER_TYPE                            (STEPPER4WIRE)
+#define AXIS_MAX_COUNT                          (4u)
+
+#define STEPPER_TYPE                            (STEPPER2WIRE)          // Coils are driven by PhaseDriver, GStepper2 only plans steps
+#define STEPPER_MODE                            (STEPPER_VIRTUAL)
 #define STEPPER_RESOLUTION                      (4096)
 #define STEPPER_MIN_SPEED                       ((int32_t)(STEPPER_RESOLUTION / 90))
+
+#define SUNRISE_MIN_BURST_INTERVAL              (2000u)                 // ms, coils are released between bursts
+#define SUNRISE_MIN_BURST_STEPS                 (8)
+
+#define COIL_PWM_CHANNEL                        (0u)
+#define COIL_PWM_FREQUENCY                      (20000u)
+#define COIL_PWM_RESOLUTION                     (8u)
+
+#define SCENE_COUNT                             (4u)                    // Each scene has own packet types, see cmd.h
+#define SCENE_NAME_SIZE                         (16u)
+
+#define SEQUENCE_COUNT                          (2u)                    // Each sequence has own packet type, see cmd.h
+#define SEQUENCE_MAX_STEPS                      (8u)
+#define SEQUENCE_SCRIPT_SIZE                    (64u)
+#define SEQUENCE_MAX_WAIT                       (24u * 3600u)           // s, longer waits are rejected by the compiler
+
+#define DRIFT_HISTORY_SIZE                      (16u)
+
+#define SPEED_PROFILE_BANDS                     (8u)                    // Open travel is split into this many bands per direction
+#define SPEED_PROFILE_DEFAULT_FACTOR            (100u)                  // %, bands without history run at configured speed
+#define SPEED_PROFILE_INCREASE                  (2u)                    // %, added to every used band after probe without step loss
+#define SPEED_PROFILE_DECREASE                  (0.2f)                  // Share removed from the most used band on step loss
+#define SPEED_PROFILE_MIN_EXPOSURE              ((uint32_t) STEPPER_RESOLUTION / 4)   // Steps in band required to speed it up
+
+#define ENDSTOP_ADC_SAMPLE_RATE                 (20000u)                // Hz, shared by all analog endstop channels
+#define ENDSTOP_ADC_FRAME_SIZE                  (64u)                   // Samples per channel reduced to one median
+#define ENDSTOP_ADC_MAX_VOLTAGE                 (3300u)                 // mV, falling sensors are inverted against it
+#define ENDSTOP_FILTER_FACTOR                   (0.25f)                 // EMA weight of a new frame median
+#define ENDSTOP_MIN_HYSTERESIS                  (20u)                   // mV
+#define ENDSTOP_CALIBRATION_SETTLE_TIME         (500u)                  // ms, level is averaged at every calibration point
+#define ENDSTOP_CALIBRATION_MIN_SPAN            (100u)                  // mV between baseline and trigger level
+#define ENDSTOP_CALIBRATION_NOISE_FACTOR        (4u)                    // Thresholds are kept this many noise levels apart
+
+#define CALIBRATION_REPEAT_COUNT                (3u)
+#define CALIBRATION_TEST_DISTANCE               ((int32_t) STEPPER_RESOLUTION * 4)
+#define CALIBRATION_SPEED_LIMIT                 (2000u)
+#define CALIBRATION_ACCELERATION_MIN            (100u)
+#define CALIBRATION_ACCELERATION_LIMIT          (5000u)
+#define CALIBRATION_SEARCH_FACTOR               (1.25f)
+#define CALIBRATION_SAFETY_FACTOR               (0.8f)
+#define CALIBRATION_OFFSET_FACTOR               (2.0f)                  // Open position is kept this many endstop release distances away
+
+#define GROUP_SYNC_PORT                         (4210u)
+#define GROUP_SYNC_ADDRESS                      IPAddress(239, 255, 42, 1)
+#define GROUP_SYNC_SIGNATURE                    ((uint16_t) 0x5A7C)
+#define GROUP_SYNC_INTERVAL                     (5000u)                 // Interval (ms) between clock offset requests
+#define GROUP_SYNC_TIMEOUT                      (30000u)                // Clock is considered unsynced without fresh samples
+#define GROUP_SYNC_FILTER_SIZE                  (8u)
+#define GROUP_SYNC_QUEUE_SIZE                   (8u)
+
+#define SIMULATOR_INERTIA                       (0.00002f)
+#define SIMULATOR_FRICTION                      (0.1f)
+#define SIMULATOR_GRAVITY                       (0.3f)
+#define SIMULATOR_MAX_SPEED                     (1500.f)
+#define SIMULATOR_FABRIC_LENGTH                 ((int32_t) STEPPER_RESOLUTION * 12)   // Longer than default open position
+#define SIMULATOR_START_POSITION                ((int32_t) STEPPER_RESOLUTION * 4)
+#define SIMULATOR_ENDSTOP_HYSTERESIS            (40)
+#define SIMULATOR_TOP_OVERTRAVEL                (400)
+#define SIMULATOR_REST_INTERVAL                 (100000u)               // Step interval (us) treated as standstill
+#define SIMULATOR_HALL_BASELINE                 (1650.f)                // mV, sensor output without field
+#define SIMULATOR_HALL_AMPLITUDE                (1500.f)                // mV, half of it is reached at the endstop position
+#define SIMULATOR_HALL_NOISE                    (15.f)                  // mV, standard deviation
+#define SIMULATOR_HALL_SPIKE_RATE               (1000u)                 // One full-scale spike per this many samples
+#define SIMULATOR_SEED                          (0x5eed5eedu)           // Sensor noise seed, axis index is added
@@ -0,0 +1,46 @@
+#pragma once
+
+// Host stand-in for the Arduino core, used by native unit tests. Time doesn't run by itself, tests advance it.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace host_clock {
+    inline uint64_t now_us = 0;
+
+    inline void set_us(uint64_t value) { now_us = value; }
+    inline void advance_us(uint64_t value) { now_us += value; }
+    inline void advance_ms(uint64_t value) { now_us += value * 1000; }
+}
+
+// Wrapped to 32 bits like on the device, so overflow handling is exercised too
+inline unsigned long micros() { return (uint32_t) host_clock::now_us; }
+inline unsigned long millis() { return (uint32_t) (host_clock::now_us / 1000); }
+
+class IPAddress {
+    uint8_t _octets[4]{};
+
+public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _octets{a, b, c, d} {}
+
+    bool operator==(const IPAddress &other) const { return memcmp(_octets, other._octets, sizeof(_octets)) == 0; }
+    uint8_t operator[](int index) const { return _octets[index]; }
+};
+
+// Each call returns another address, so instances created in one process get distinct ids
+struct EspClass {
+    uint64_t next_mac = 0x0000a0b1c2d3e4f0ull;
+
+    uint64_t getEfuseMac() { return next_mac++; }
+};
+
+inline EspClass ESP;
+
+inline long random(long max) { return max > 0 ? std::rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+inline void randomSeed(unsigned long seed) { std::srand((unsigned) seed); }
@@ -0,0 +1,87 @@
+#pragma once
+
+// Host stand-in for AsyncUDP: every instance in the process shares one loopback segment.
+// Datagrams are delivered to all listeners of the port, including the sender, once their latency has passed.
+
+#include <Arduino.h>
+
+#include <functional>
+#include <vector>
+
+class AsyncUDPPacket {
+    const uint8_t *_data;
+    size_t _length;
+
+public:
+    AsyncUDPPacket(const uint8_t *data, size_t length) : _data(data), _length(length) {}
+
+    [[nodiscard]] uint8_t *data() const { return (uint8_t *) _data; }
+    [[nodiscard]] size_t length() const { return _length; }
+};
+
+typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
+
+// Latency (us) of the datagram, lets tests model jitter and asymmetric paths; UINT32_MAX drops it
+typedef std::function<uint32_t(const uint8_t *data, size_t length)> LoopbackLatencyFn;
+
+class AsyncUDP {
+    struct Datagram {
+        uint64_t delivery_time;
+        uint16_t port;
+        std::vector<uint8_t> data;
+    };
+
+    static inline std::vector<AsyncUDP *> _instances{};
+    static inline std::vector<Datagram> _in_flight{};
+    static inline LoopbackLatencyFn _latency_fn = nullptr;
+
+    uint16_t _port = 0;
+    AuPacketHandlerFunction _handler = nullptr;
+
+public:
+    AsyncUDP() { _instances.push_back(this); }
+    AsyncUDP(const AsyncUDP &) = delete;
+    ~AsyncUDP() { std::erase(_instances, this); }
+
+    bool listenMulticast(const IPAddress &, uint16_t port, uint8_t = 1) {
+        _port = port;
+        return true;
+    }
+
+    void onPacket(AuPacketHandlerFunction handler) { _handler = std::move(handler); }
+
+    size_t writeTo(const uint8_t *data, size_t length, const IPAddress &, uint16_t port) {
+        const uint32_t latency = _latency_fn ? _latency_fn(data, length) : 0;
+        if (latency == UINT32_MAX) return length;
+
+        _in_flight.push_back({host_clock::now_us + latency, port, {data, data + length}});
+        return length;
+    }
+
+    static void set_latency(LoopbackLatencyFn fn) { _latency_fn = std::move(fn); }
+
+    static void reset() {
+        _in_flight.clear();
+        _latency_fn = nullptr;
+    }
+
+    // Delivers datagrams whose latency has passed, in the order they were sent
+    static void deliver() {
+        auto pending = std::move(_in_flight);
+        _in_flight.clear();
+
+        for (auto &datagram: pending) {
+            if (datagram.delivery_time > host_clock::now_us) {
+                _in_flight.push_back(std::move(datagram));
+                continue;
+            }
+
+            for (auto *instance: _instances) {
+                if (instance->_port != datagram.port || !instance->_handler) continue;
+
+                AsyncUDPPacket packet(datagram.data.data(), datagram.data.size());
+                instance->_handler(packet);
+            }
+        }
+    }
+};
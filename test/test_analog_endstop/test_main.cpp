@@ -0,0 +1,176 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "misc/analog_endstop.h"
+
+static EndstopConfig config;
+static EndstopInfo info;
+
+// Synthetic sensor frame: level with uniform noise, every spike_period-th sample is a full-scale spike
+static void feed(AnalogEndstop &endstop, float level, uint16_t noise = 0, uint32_t spike_period = 0) {
+    uint16_t frame[ENDSTOP_ADC_FRAME_SIZE];
+    for (size_t i = 0; i < ENDSTOP_ADC_FRAME_SIZE; ++i) {
+        if (spike_period && i % spike_period == 0) {
+            frame[i] = i % (2 * spike_period) == 0 ? ENDSTOP_ADC_MAX_VOLTAGE : 0;
+            continue;
+        }
+
+        const float value = level + (noise ? (float) (std::rand() % (2 * noise + 1)) - noise : 0.f);
+        frame[i] = (uint16_t) std::clamp(value, 0.f, (float) ENDSTOP_ADC_MAX_VOLTAGE);
+    }
+
+    endstop.add_frame(frame, ENDSTOP_ADC_FRAME_SIZE);
+}
+
+static void settle(AnalogEndstop &endstop, float level, uint16_t noise = 0) {
+    for (uint8_t i = 0; i < 40; ++i) feed(endstop, level, noise);
+}
+
+// Magnet approach and retreat as a linear ramp of frame levels, proximity is recorded after every frame
+static std::vector<EndstopProximity> ramp(AnalogEndstop &endstop, float from, float to, uint32_t frames) {
+    std::vector<EndstopProximity> result;
+    for (uint32_t i = 0; i <= frames; ++i) {
+        feed(endstop, from + (to - from) * (float) i / (float) frames);
+        result.push_back(endstop.proximity());
+    }
+
+    return result;
+}
+
+static size_t first_index(const std::vector<EndstopProximity> &trace, EndstopProximity value) {
+    return std::find(trace.begin(), trace.end(), value) - trace.begin();
+}
+
+void setUp() {
+    config = {.mode = EndstopMode::ANALOG, .slowdown_level = 1800, .trigger_level = 2400, .hysteresis = 50};
+    info = {};
+    std::srand(1);
+}
+
+void tearDown() {}
+
+void test_thresholds_switch_proximity() {
+    AnalogEndstop endstop(config, true, info);
+
+    settle(endstop, 1000);
+    TEST_ASSERT_EQUAL(EndstopProximity::FAR, endstop.proximity());
+    TEST_ASSERT_UINT16_WITHIN(1, 1000, endstop.level());
+
+    settle(endstop, 1850);
+    TEST_ASSERT_EQUAL(EndstopProximity::NEAR, endstop.proximity());
+
+    settle(endstop, 2450);
+    TEST_ASSERT_EQUAL(EndstopProximity::TRIGGERED, endstop.proximity());
+    TEST_ASSERT_EQUAL_UINT32(120, info.frames);
+}
+
+void test_hysteresis_holds_state_near_threshold() {
+    AnalogEndstop endstop(config, true, info);
+
+    settle(endstop, 2450);
+    TEST_ASSERT_EQUAL(EndstopProximity::TRIGGERED, endstop.proximity());
+
+    // Below the trigger level, but within hysteresis
+    settle(endstop, 2370);
+    TEST_ASSERT_EQUAL(EndstopProximity::TRIGGERED, endstop.proximity());
+
+    settle(endstop, 2340);
+    TEST_ASSERT_EQUAL(EndstopProximity::NEAR, endstop.proximity());
+
+    settle(endstop, 1770);
+    TEST_ASSERT_EQUAL(EndstopProximity::NEAR, endstop.proximity());
+
+    settle(endstop, 1740);
+    TEST_ASSERT_EQUAL(EndstopProximity::FAR, endstop.proximity());
+}
+
+void test_noise_at_threshold_does_not_toggle() {
+    AnalogEndstop endstop(config, true, info);
+    settle(endstop, 2400, 60);
+
+    // Frame medians vary much less than samples, filtered level stays within hysteresis
+    uint32_t changes = 0;
+    auto last = endstop.proximity();
+    for (uint32_t i = 0; i < 2000; ++i) {
+        feed(endstop, 2400, 60);
+        if (endstop.proximity() != last) ++changes;
+        last = endstop.proximity();
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1, changes);
+    TEST_ASSERT_LESS_THAN_UINT16(config.hysteresis, endstop.noise());
+}
+
+void test_slowdown_zone_precedes_trigger() {
+    AnalogEndstop endstop(config, true, info);
+    settle(endstop, 1000);
+
+    const auto approach = ramp(endstop, 1000, 3000, 200);
+    const auto near = first_index(approach, EndstopProximity::NEAR);
+    const auto triggered = first_index(approach, EndstopProximity::TRIGGERED);
+
+    // 10 mV per frame: slowdown zone spans (2400 - 1800) / 10 frames, shifted by the filter lag
+    TEST_ASSERT_LESS_THAN(triggered, near);
+    TEST_ASSERT_INT_WITHIN(5, 80, near);
+    TEST_ASSERT_INT_WITHIN(5, 140, triggered);
+    for (size_t i = near; i < triggered; ++i) TEST_ASSERT_EQUAL(EndstopProximity::NEAR, approach[i]);
+
+    // Retreat releases at thresholds lowered by hysteresis
+    const auto retreat = ramp(endstop, 3000, 1000, 200);
+    const auto released = first_index(retreat, EndstopProximity::NEAR);
+    const auto far = first_index(retreat, EndstopProximity::FAR);
+
+    TEST_ASSERT_LESS_THAN(far, released);
+    TEST_ASSERT_INT_WITHIN(5, 65, released);
+    TEST_ASSERT_INT_WITHIN(5, 125, far);
+}
+
+void test_spikes_are_dropped_by_median() {
+    AnalogEndstop endstop(config, true, info);
+
+    // Every fourth sample is a full-scale spike in either direction
+    for (uint32_t i = 0; i < 200; ++i) feed(endstop, 1000, 10, 4);
+
+    TEST_ASSERT_EQUAL(EndstopProximity::FAR, endstop.proximity());
+    TEST_ASSERT_UINT16_WITHIN(20, 1000, endstop.level());
+}
+
+void test_falling_sensor_is_inverted() {
+    AnalogEndstop endstop(config, false, info);
+
+    settle(endstop, ENDSTOP_ADC_MAX_VOLTAGE - 1000);
+    TEST_ASSERT_EQUAL(EndstopProximity::FAR, endstop.proximity());
+    TEST_ASSERT_UINT16_WITHIN(1, 1000, endstop.level());
+
+    settle(endstop, ENDSTOP_ADC_MAX_VOLTAGE - 2500);
+    TEST_ASSERT_EQUAL(EndstopProximity::TRIGGERED, endstop.proximity());
+}
+
+void test_new_instance_keeps_calibration() {
+    info.baseline = 900;
+    info.trigger_level = 2400;
+
+    AnalogEndstop endstop(config, true, info);
+    settle(endstop, 2450);
+
+    AnalogEndstop restarted(config, true, info);
+    TEST_ASSERT_EQUAL(EndstopProximity::FAR, info.proximity);
+    TEST_ASSERT_EQUAL_UINT32(0, info.frames);
+    TEST_ASSERT_EQUAL_UINT16(900, info.baseline);
+    TEST_ASSERT_EQUAL_UINT16(2400, info.trigger_level);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_thresholds_switch_proximity);
+    RUN_TEST(test_hysteresis_holds_state_near_threshold);
+    RUN_TEST(test_noise_at_threshold_does_not_toggle);
+    RUN_TEST(test_slowdown_zone_precedes_trigger);
+    RUN_TEST(test_spikes_are_dropped_by_median);
+    RUN_TEST(test_falling_sensor_is_inverted);
+    RUN_TEST(test_new_instance_keeps_calibration);
+    return UNITY_END();
+}
@@ -0,0 +1,203 @@
+#include <unity.h>
+
+#include <memory>
+#include <vector>
+
+#include "misc/group_sync.h"
+
+// Local clocks of group members, ms. Leader runs on the host clock
+template<int32_t Skew>
+static unsigned long skewed_clock() { return (uint32_t) (millis() + Skew); }
+
+static constexpr int32_t FIRST_SKEW = 123456;
+static constexpr int32_t SECOND_SKEW = -7777;
+
+struct Node {
+    GroupSyncConfig config;
+    TimerWheel timer;
+    GroupSync sync;
+
+    std::vector<uint64_t> moves{};  // Host time of performed moves, us
+    float position = -1;
+
+    Node(bool leader, GroupSyncClockFn clock) :
+        config{.enabled = true, .group = 1, .leader = leader},
+        sync(timer, config, [this](float value) {
+            moves.push_back(host_clock::now_us);
+            position = value;
+        }, clock) {
+        timer.begin();
+        sync.begin();
+    }
+};
+
+struct Group {
+    std::unique_ptr<Node> leader = std::make_unique<Node>(true, millis);
+    std::unique_ptr<Node> first = std::make_unique<Node>(false, skewed_clock<FIRST_SKEW>);
+    std::unique_ptr<Node> second = std::make_unique<Node>(false, skewed_clock<SECOND_SKEW>);
+
+    void run(uint32_t duration_ms) {
+        for (uint32_t i = 0; i < duration_ms; ++i) {
+            host_clock::advance_ms(1);
+            AsyncUDP::deliver();
+
+            for (auto *node: {leader.get(), first.get(), second.get()}) {
+                node->sync.handle();
+                node->timer.handle_timers();
+            }
+        }
+    }
+};
+
+void setUp() {
+    host_clock::set_us(1000000);
+    AsyncUDP::reset();
+}
+
+void tearDown() {}
+
+void test_members_estimate_clock_offset() {
+    AsyncUDP::set_latency([](auto, auto) { return 3000; });
+
+    Group group;
+    group.run(3 * GROUP_SYNC_INTERVAL);
+
+    const auto &first = group.first->sync.info();
+    const auto &second = group.second->sync.info();
+
+    TEST_ASSERT_TRUE(first.synced);
+    TEST_ASSERT_TRUE(second.synced);
+    TEST_ASSERT_INT32_WITHIN(1, -FIRST_SKEW, first.offset);
+    TEST_ASSERT_INT32_WITHIN(1, -SECOND_SKEW, second.offset);
+    TEST_ASSERT_UINT32_WITHIN(1, 6, first.rtt);
+
+    TEST_ASSERT_FALSE(group.leader->sync.info().synced);
+}
+
+void test_synced_members_start_together() {
+    AsyncUDP::set_latency([](auto, auto) { return 3000; });
+
+    Group group;
+    group.run(3 * GROUP_SYNC_INTERVAL);
+
+    const auto move_time = host_clock::now_us;
+    group.leader->sync.move(42);
+    group.run(2 * GROUP_SYNC_DEFAULT_START_DELAY);
+
+    // MOVE is sent twice, the repeated one is ignored
+    for (auto *node: {group.leader.get(), group.first.get(), group.second.get()}) {
+        TEST_ASSERT_EQUAL_UINT32(1, node->moves.size());
+        TEST_ASSERT_EQUAL_FLOAT(42, node->position);
+        TEST_ASSERT_UINT64_WITHIN(1000, move_time + GROUP_SYNC_DEFAULT_START_DELAY * 1000, node->moves[0]);
+    }
+
+    TEST_ASSERT_INT32_WITHIN(1, 0, group.first->sync.info().last_move_lateness);
+    TEST_ASSERT_INT32_WITHIN(1, 0, group.second->sync.info().last_move_lateness);
+}
+
+void test_jitter_is_filtered_by_round_trip() {
+    std::srand(42);
+    AsyncUDP::set_latency([](auto, auto) { return 1000 + std::rand() % 40000; });
+
+    Group group;
+    group.run(GROUP_SYNC_FILTER_SIZE * GROUP_SYNC_INTERVAL);
+
+    // Offset error can't exceed half of the round trip it was measured with
+    for (auto [node, skew]: {std::pair{group.first.get(), FIRST_SKEW}, {group.second.get(), SECOND_SKEW}}) {
+        const auto &info = node->sync.info();
+
+        TEST_ASSERT_TRUE(info.synced);
+        TEST_ASSERT_LESS_THAN_UINT32(40, info.rtt);
+        TEST_ASSERT_INT32_WITHIN(info.rtt / 2 + 1, -skew, info.offset);
+    }
+}
+
+static GroupSyncMessageType message_type(const uint8_t *data) {
+    return ((const GroupSyncMessage *) data)->type;
+}
+
+void test_asymmetric_path_biases_offset_by_half_difference() {
+    // Responses take 8 ms and requests 2 ms, so members see the leader clock 3 ms early
+    AsyncUDP::set_latency([](const uint8_t *data, auto) {
+        return message_type(data) == GroupSyncMessageType::SYNC_RESPONSE ? 8000 : 2000;
+    });
+
+    Group group;
+    group.run(3 * GROUP_SYNC_INTERVAL);
+
+    const auto &info = group.first->sync.info();
+    TEST_ASSERT_EQUAL_UINT32(10, info.rtt);
+    TEST_ASSERT_INT32_WITHIN(1, -FIRST_SKEW - 3, info.offset);
+
+    group.leader->sync.move(30);
+    group.run(2 * GROUP_SYNC_DEFAULT_START_DELAY);
+
+    TEST_ASSERT_EQUAL_UINT32(1, group.first->moves.size());
+    TEST_ASSERT_UINT64_WITHIN(4000, group.leader->moves[0], group.first->moves[0]);
+}
+
+void test_lost_move_is_covered_by_repeat() {
+    AsyncUDP::set_latency([dropped = false](const uint8_t *data, auto) mutable -> uint32_t {
+        if (message_type(data) == GroupSyncMessageType::MOVE && !dropped) {
+            dropped = true;
+            return UINT32_MAX;
+        }
+
+        return 3000;
+    });
+
+    Group group;
+    group.run(3 * GROUP_SYNC_INTERVAL);
+
+    group.leader->sync.move(55);
+    group.run(2 * GROUP_SYNC_DEFAULT_START_DELAY);
+
+    TEST_ASSERT_EQUAL_UINT32(1, group.first->moves.size());
+    TEST_ASSERT_EQUAL_UINT32(1, group.second->moves.size());
+    TEST_ASSERT_UINT64_WITHIN(1000, group.leader->moves[0], group.first->moves[0]);
+}
+
+void test_unsynced_member_moves_on_receive() {
+    // Leader responses are lost, so members never get the clock offset
+    AsyncUDP::set_latency([](const uint8_t *data, auto) -> uint32_t {
+        return message_type(data) == GroupSyncMessageType::SYNC_RESPONSE ? UINT32_MAX : 5000;
+    });
+
+    Group group;
+    group.leader->sync.move(10);
+    group.run(2 * GROUP_SYNC_DEFAULT_START_DELAY);
+
+    // Start time can't be translated without the offset, member moves as soon as MOVE arrives
+    TEST_ASSERT_FALSE(group.first->sync.info().synced);
+    TEST_ASSERT_EQUAL_UINT32(1, group.first->moves.size());
+    TEST_ASSERT_EQUAL_UINT32(1, group.leader->moves.size());
+    TEST_ASSERT_LESS_THAN(group.leader->moves[0], group.first->moves[0]);
+}
+
+void test_other_group_is_ignored() {
+    AsyncUDP::set_latency([](auto, auto) { return 3000; });
+
+    Group group;
+    group.second->config.group = 2;
+    group.run(3 * GROUP_SYNC_INTERVAL);
+
+    group.leader->sync.move(70);
+    group.run(2 * GROUP_SYNC_DEFAULT_START_DELAY);
+
+    TEST_ASSERT_TRUE(group.first->sync.info().synced);
+    TEST_ASSERT_FALSE(group.second->sync.info().synced);
+    TEST_ASSERT_EQUAL_UINT32(1, group.first->moves.size());
+    TEST_ASSERT_EQUAL_UINT32(0, group.second->moves.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_members_estimate_clock_offset);
+    RUN_TEST(test_synced_members_start_together);
+    RUN_TEST(test_jitter_is_filtered_by_round_trip);
+    RUN_TEST(test_asymmetric_path_biases_offset_by_half_difference);
+    RUN_TEST(test_lost_move_is_covered_by_repeat);
+    RUN_TEST(test_unsynced_member_moves_on_receive);
+    RUN_TEST(test_other_group_is_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+#include <unity.h>
+
+#include "misc/shade_simulator.h"
+
+// Motion parameters of StepperConfig used by homing and travel
+struct MotionConfig {
+    uint16_t open_speed = 300;
+    uint16_t close_speed = 500;
+    uint16_t acceleration = 300;
+
+    uint16_t homing_speed = 300;
+    int32_t homing_steps_max = STEPPER_RESOLUTION * 10;
+
+    int32_t open_position = STEPPER_RESOLUTION * 10;
+};
+
+struct MotionResult {
+    uint32_t homing_time = 0;   // us
+    uint32_t travel_time = 0;   // us, close and open back
+    int32_t position_error = 0; // Counted minus real position when the endstop is found again
+    uint32_t lost_steps = 0;
+};
+
+// Planner with the GStepper2 interface the simulator driver relies on: trapezoidal profile, step and power callbacks
+class PlannerStepper {
+    typedef void (*StepFn)(uint8_t);
+    typedef void (*PowerFn)(bool);
+
+    StepFn _step_fn = nullptr;
+    PowerFn _power_fn = nullptr;
+
+    int32_t _current = 0;
+    int32_t _target = 0;
+
+    float _max_speed = 1;
+    float _acceleration = 1;
+    float _speed = 0;
+
+    uint32_t _period = 0;
+
+public:
+    void attachStep(StepFn fn) { _step_fn = fn; }
+    void attachPower(PowerFn fn) { _power_fn = fn; }
+
+    void enable() { _power_fn(true); }
+    void disable() { _power_fn(false); }
+
+    void setMaxSpeed(float speed) { _max_speed = speed; }
+    void setAcceleration(float acceleration) { _acceleration = acceleration; }
+
+    void setTarget(int32_t target) {
+        _target = target;
+        if (_target == _current) brake();
+    }
+
+    void setCurrent(int32_t current) { _current = current; }
+    [[nodiscard]] int32_t getCurrent() const { return _current; }
+
+    void brake() {
+        _target = _current;
+        _speed = 0;
+        _period = 0;
+    }
+
+    [[nodiscard]] uint8_t getStatus() const { return _current != _target ? 1 : 0; }
+    [[nodiscard]] uint32_t getPeriod() const { return _period; }
+
+    // Plans the next step and makes it, returns the step period to wait
+    uint32_t tickManual() {
+        const auto remaining = (float) std::abs(_target - _current);
+        const bool braking = _speed * _speed / (2 * _acceleration) >= remaining;
+
+        const float next_speed = braking
+            ? std::sqrt(std::max(0.f, _speed * _speed - 2 * _acceleration))
+            : std::min(_max_speed, std::sqrt(_speed * _speed + 2 * _acceleration));
+
+        _speed = std::max(next_speed, 1.f);
+        _period = (uint32_t) (1e6f / _speed);
+
+        const bool close = _target > _current;
+        _step_fn(close ? 1 : 0);
+        _current += close ? 1 : -1;
+
+        if (_current == _target) _speed = 0;
+        return _period;
+    }
+};
+
+static PlannerStepper stepper;
+
+// Steps on the simulated clock until the target is reached or the endstop triggers, returns elapsed time
+static uint32_t run_until(ShadeSimulator &simulator, bool detect_endstop) {
+    const auto start = micros();
+    while (stepper.getStatus() && !(detect_endstop && simulator.endstop())) {
+        host_clock::advance_us(stepper.tickManual());
+    }
+
+    stepper.brake();
+    return micros() - start;
+}
+
+static MotionResult run_motion(const MotionConfig &cfg) {
+    ShadeSimulator simulator;
+    attach_axis_simulator(0, stepper, simulator);
+
+    MotionResult result{};
+    stepper.enable();
+    stepper.setAcceleration(cfg.acceleration);
+
+    // Simulator position is counted from the endstop, so after homing both counters share the reference
+    stepper.setCurrent(0);
+    stepper.setMaxSpeed(cfg.homing_speed);
+    stepper.setTarget(-cfg.homing_steps_max);
+    result.homing_time = run_until(simulator, true);
+
+    TEST_ASSERT_TRUE(simulator.endstop());
+    stepper.setCurrent(simulator.position());
+    simulator.reset_stats();
+
+    stepper.setMaxSpeed(cfg.close_speed);
+    stepper.setTarget(cfg.open_position);
+    result.travel_time = run_until(simulator, false);
+
+    stepper.setMaxSpeed(cfg.open_speed);
+    stepper.setTarget(0);
+    result.travel_time += run_until(simulator, false);
+
+    // Drift probe: the rest of the way up at homing speed, counted position is compared where the endstop is found
+    stepper.setMaxSpeed(cfg.homing_speed);
+    stepper.setTarget(-cfg.homing_steps_max);
+    run_until(simulator, true);
+
+    result.position_error = stepper.getCurrent() - simulator.position();
+    result.lost_steps = simulator.stats().lost_steps;
+
+    stepper.disable();
+
+    printf("Simulator: open %u, close %u, acceleration %u: homing %.2f s, travel %.2f s, error %d steps, lost %u steps\n",
+           cfg.open_speed, cfg.close_speed, cfg.acceleration, (float) result.homing_time / 1e6f,
+           (float) result.travel_time / 1e6f, result.position_error, result.lost_steps);
+
+    return result;
+}
+
+void setUp() {
+    host_clock::set_us(0);
+    stepper = {};
+}
+
+void tearDown() {}
+
+void test_default_config_keeps_position() {
+    const auto result = run_motion({});
+
+    TEST_ASSERT_EQUAL_UINT32(0, result.lost_steps);
+    TEST_ASSERT_EQUAL_INT32(0, result.position_error);
+
+    // Start position is reached at homing speed plus the acceleration ramp
+    TEST_ASSERT_FLOAT_WITHIN(1.f, (float) SIMULATOR_START_POSITION / 300, (float) result.homing_time / 1e6f);
+}
+
+void test_travel_time_follows_speed() {
+    const auto slow = run_motion({.open_speed = 300, .close_speed = 300, .acceleration = 600});
+    const auto fast = run_motion({.open_speed = 600, .close_speed = 600, .acceleration = 600});
+
+    TEST_ASSERT_EQUAL_UINT32(0, fast.lost_steps);
+    TEST_ASSERT_EQUAL_INT32(0, fast.position_error);
+
+    // Most of the travel is at full speed, so doubling it nearly halves the time
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.5f, (float) fast.travel_time / (float) slow.travel_time);
+}
+
+void test_overspeed_loses_steps() {
+    // Opening fully unrolled fabric needs more torque than is left at this speed
+    const auto result = run_motion({.open_speed = 1000, .close_speed = 500, .acceleration = 600});
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, result.lost_steps);
+
+    // Every lost step leaves the counter ahead of the real position, the endstop is found late
+    TEST_ASSERT_EQUAL_INT32(-(int32_t) result.lost_steps, result.position_error);
+}
+
+void test_acceleration_limit_loses_steps() {
+    // Ramp from rest needs more torque than the motor has, moves start with a stall
+    const auto result = run_motion({.open_speed = 500, .close_speed = 500, .acceleration = 10000});
+
+    TEST_ASSERT_GREATER_THAN_UINT32(0, result.lost_steps);
+    TEST_ASSERT_NOT_EQUAL(0, result.position_error);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_config_keeps_position);
+    RUN_TEST(test_travel_time_follows_speed);
+    RUN_TEST(test_overspeed_loses_steps);
+    RUN_TEST(test_acceleration_limit_loses_steps);
+    return UNITY_END();
+}
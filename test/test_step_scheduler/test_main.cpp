@@ -0,0 +1,174 @@
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "misc/step_scheduler.h"
+#include "sys_constants.h"
+
+static uint32_t clock_us = 0;
+
+static unsigned long test_clock() { return clock_us; }
+
+// Planner with a constant step period, records when it was actually stepped
+struct FakeStepper {
+    uint32_t period = 0;
+    uint32_t steps_left = 0;
+
+    std::vector<uint32_t> steps{};
+
+    bool tickManual() {
+        steps.push_back(clock_us);
+        if (steps_left > 0) --steps_left;
+        return steps_left > 0;
+    }
+
+    [[nodiscard]] uint8_t getStatus() const { return steps_left > 0 ? 1 : 0; }
+    [[nodiscard]] uint32_t getPeriod() const { return period; }
+};
+
+typedef StepScheduler<FakeStepper, 2, test_clock> Scheduler;
+
+static void run(Scheduler &scheduler, uint32_t granularity, uint32_t limit) {
+    for (uint32_t elapsed = 0; elapsed < limit; elapsed += granularity) {
+        scheduler.tick();
+        clock_us += granularity;
+    }
+}
+
+static void assert_intervals(const FakeStepper &stepper, uint32_t min, uint32_t max) {
+    for (size_t i = 1; i < stepper.steps.size(); ++i) {
+        const uint32_t interval = stepper.steps[i] - stepper.steps[i - 1];
+        TEST_ASSERT_UINT32_WITHIN((max - min) / 2, (max + min) / 2, interval);
+    }
+}
+
+void setUp() {
+    // Close to the wrap around, so every test crosses it
+    clock_us = UINT32_MAX - 50000;
+}
+
+void tearDown() {}
+
+void test_single_axis_achieves_requested_interval() {
+    Scheduler scheduler;
+    FakeStepper stepper{.period = 1000, .steps_left = 100};
+    scheduler.add(&stepper);
+
+    run(scheduler, 10, 200000);
+
+    TEST_ASSERT_EQUAL_UINT32(100, stepper.steps.size());
+    assert_intervals(stepper, 1000, 1010);
+
+    const auto &timing = scheduler.timing();
+    TEST_ASSERT_EQUAL_UINT32(99, timing.count);
+    TEST_ASSERT_EQUAL_UINT64(99 * 1000, timing.requested);
+    TEST_ASSERT_UINT64_WITHIN(99 * 10, timing.requested, timing.achieved);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10, timing.max_lateness);
+    TEST_ASSERT_FALSE(scheduler.active());
+}
+
+void test_axes_keep_own_periods() {
+    Scheduler scheduler;
+    FakeStepper first{.period = 700, .steps_left = 200};
+    FakeStepper second{.period = 1100, .steps_left = 120};
+    scheduler.add(&first);
+    scheduler.add(&second);
+
+    run(scheduler, 5, 300000);
+
+    TEST_ASSERT_EQUAL_UINT32(200, first.steps.size());
+    TEST_ASSERT_EQUAL_UINT32(120, second.steps.size());
+
+    // Deadline is advanced by the period, so loop granularity doesn't accumulate
+    assert_intervals(first, 695, 705);
+    assert_intervals(second, 1095, 1105);
+    TEST_ASSERT_UINT32_WITHIN(5, 199 * 700, first.steps.back() - first.steps.front());
+    TEST_ASSERT_UINT32_WITHIN(5, 119 * 1100, second.steps.back() - second.steps.front());
+}
+
+void test_idle_tick_does_not_step() {
+    Scheduler scheduler;
+    FakeStepper stepper{.period = 1000};
+    scheduler.add(&stepper);
+
+    run(scheduler, 10, 10000);
+
+    TEST_ASSERT_FALSE(scheduler.active());
+    TEST_ASSERT_EQUAL_UINT32(0, stepper.steps.size());
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.timing().count);
+}
+
+void test_late_axis_restarts_without_burst() {
+    Scheduler scheduler;
+    FakeStepper stepper{.period = 1000, .steps_left = 20};
+    scheduler.add(&stepper);
+
+    run(scheduler, 10, 5000);
+    const size_t before = stepper.steps.size();
+
+    // Loop is blocked for several periods
+    clock_us += 4500;
+    run(scheduler, 10, 50000);
+
+    TEST_ASSERT_EQUAL_UINT32(20, stepper.steps.size());
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(4500, scheduler.timing().max_lateness);
+
+    // Missed steps aren't caught up, the next ones keep the requested period
+    for (size_t i = before + 1; i < stepper.steps.size(); ++i) {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1000, stepper.steps[i] - stepper.steps[i - 1]);
+    }
+
+    const auto &timing = scheduler.timing();
+    TEST_ASSERT_GREATER_THAN_UINT64(timing.requested, timing.achieved);
+}
+
+static void benchmark_axes(uint8_t count) {
+    constexpr uint32_t PERIOD = 1000000 / CALIBRATION_SPEED_LIMIT;
+    constexpr uint32_t STEPS = 4000;
+    constexpr uint32_t GRANULARITY = 10;
+
+    StepScheduler<FakeStepper, AXIS_MAX_COUNT, test_clock> scheduler;
+    std::vector<FakeStepper> steppers(count, {.period = PERIOD, .steps_left = STEPS});
+    for (auto &stepper: steppers) scheduler.add(&stepper);
+
+    using clock = std::chrono::steady_clock;
+    clock::duration tick_time{};
+    uint32_t ticks = 0;
+
+    while (ticks == 0 || scheduler.active()) {
+        const auto start = clock::now();
+        scheduler.tick();
+        tick_time += clock::now() - start;
+
+        ++ticks;
+        clock_us += GRANULARITY;
+    }
+
+    const auto &timing = scheduler.timing();
+    printf("StepScheduler: %u axes at %u us: %.1f ns per tick, requested %llu us, achieved %llu us, max lateness %u us\n",
+           count, PERIOD, (double) std::chrono::duration_cast<std::chrono::nanoseconds>(tick_time).count() / ticks,
+           (unsigned long long) timing.requested, (unsigned long long) timing.achieved, timing.max_lateness);
+
+    for (auto &stepper: steppers) TEST_ASSERT_EQUAL_UINT32(STEPS, stepper.steps.size());
+
+    // Loop granularity is the only source of lateness, it doesn't accumulate with the axis count
+    TEST_ASSERT_EQUAL_UINT32(count * (STEPS - 1), timing.count);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t) timing.count * PERIOD, timing.requested);
+    TEST_ASSERT_LESS_THAN_UINT32(GRANULARITY, timing.max_lateness);
+    TEST_ASSERT_UINT64_WITHIN((uint64_t) count * GRANULARITY, timing.requested, timing.achieved);
+}
+
+void test_benchmark_axis_count() {
+    for (uint8_t count = 1; count <= AXIS_MAX_COUNT; ++count) benchmark_axes(count);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_axis_achieves_requested_interval);
+    RUN_TEST(test_axes_keep_own_periods);
+    RUN_TEST(test_idle_tick_does_not_step);
+    RUN_TEST(test_late_axis_restarts_without_burst);
+    RUN_TEST(test_benchmark_axis_count);
+    return UNITY_END();
+}
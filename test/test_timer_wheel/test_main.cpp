@@ -0,0 +1,312 @@
+#include <unity.h>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "misc/timer_wheel.h"
+
+// Linear timer with the semantics of the framework Timer the wheel replaced: every call scans all entries
+class ReferenceTimer {
+    struct Entry {
+        unsigned long id;
+        uint32_t interval;
+        uint32_t expires;
+        bool repeat;
+    };
+
+    std::vector<Entry> _entries{};
+    unsigned long _next_id = 0;
+
+public:
+    unsigned long add(unsigned long delay, bool repeat) {
+        _entries.push_back({_next_id, (uint32_t) delay, (uint32_t) (millis() + delay), repeat});
+        return _next_id++;
+    }
+
+    void clear(unsigned long id) {
+        std::erase_if(_entries, [id](auto &entry) { return entry.id == id; });
+    }
+
+    std::multiset<unsigned long> handle() {
+        const uint32_t now = millis();
+
+        std::multiset<unsigned long> fired;
+        for (auto it = _entries.begin(); it != _entries.end();) {
+            if ((int32_t) (now - it->expires) < 0) {
+                ++it;
+                continue;
+            }
+
+            fired.insert(it->id);
+            if (it->repeat) {
+                it->expires = now + it->interval;
+                ++it;
+            } else {
+                it = _entries.erase(it);
+            }
+        }
+
+        return fired;
+    }
+
+    [[nodiscard]] unsigned long next_deadline() const {
+        int32_t result = INT32_MAX;
+        for (auto &entry: _entries) result = std::min(result, (int32_t) (entry.expires - (uint32_t) millis()));
+
+        return _entries.empty() ? -1ul : std::max(result, 0);
+    }
+
+    [[nodiscard]] size_t size() const { return _entries.size(); }
+};
+
+// Couples both timers, fired ids are reported in the reference numbering
+struct Harness {
+    TimerWheel wheel;
+    ReferenceTimer reference;
+
+    std::map<unsigned long, unsigned long> wheel_ids{};
+    std::multiset<unsigned long> fired{};
+
+    Harness() { wheel.begin(); }
+
+    unsigned long add(unsigned long delay, bool repeat) {
+        const auto id = reference.add(delay, repeat);
+        auto fn = [this, id](auto) { fired.insert(id); };
+
+        wheel_ids[id] = repeat ? wheel.add_interval(fn, delay) : wheel.add_timeout(fn, delay);
+        return id;
+    }
+
+    void clear(unsigned long id) {
+        reference.clear(id);
+        wheel.clear_timeout(wheel_ids[id]);
+    }
+
+    void step(uint32_t ms) {
+        host_clock::advance_ms(ms);
+
+        fired.clear();
+        wheel.handle_timers();
+
+        TEST_ASSERT_TRUE(fired == reference.handle());
+        TEST_ASSERT_EQUAL_UINT32(reference.size(), wheel.size());
+    }
+};
+
+static std::vector<uint32_t> fire_times;
+
+static void record_fire(void *) {
+    fire_times.push_back(millis());
+}
+
+void setUp() {
+    host_clock::set_us(1000000);
+    fire_times.clear();
+    std::srand(7);
+}
+
+void tearDown() {}
+
+void test_timeout_fires_at_deadline() {
+    // Delays around level boundaries, far ones are cascaded through upper levels first
+    const uint32_t delays[] = {0, 1, 63, 64, 65, 4095, 4096, 4097, 262143, 262145, 300000};
+
+    TimerWheel wheel;
+    wheel.begin();
+
+    const uint32_t start = millis();
+    for (auto delay: delays) wheel.add_timeout(record_fire, delay);
+
+    wheel.handle_timers();
+    for (uint32_t i = 0; i < 300000; ++i) {
+        host_clock::advance_ms(1);
+        wheel.handle_timers();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(std::size(delays), fire_times.size());
+    for (size_t i = 0; i < fire_times.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(start + delays[i], fire_times[i]);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.size());
+}
+
+void test_skip_ahead_fires_overdue_once() {
+    TimerWheel wheel;
+    wheel.begin();
+
+    uint32_t interval_calls = 0;
+    wheel.add_timeout(record_fire, 10);
+    wheel.add_timeout(record_fire, 1000);
+    wheel.add_timeout(record_fire, 70000);
+    wheel.add_interval([&](auto) { ++interval_calls; }, 100);
+
+    // Loop was blocked past every deadline
+    host_clock::advance_ms(200000);
+    wheel.handle_timers();
+
+    TEST_ASSERT_EQUAL_UINT32(3, fire_times.size());
+    TEST_ASSERT_EQUAL_UINT32(1, interval_calls);
+
+    // Interval is rescheduled from the actual call, missed periods aren't caught up.
+    // It lands on level 1, so the deadline is reported at the cascade time
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(100, wheel.next_deadline());
+
+    host_clock::advance_ms(99);
+    wheel.handle_timers();
+    TEST_ASSERT_EQUAL_UINT32(1, interval_calls);
+
+    host_clock::advance_ms(1);
+    wheel.handle_timers();
+    TEST_ASSERT_EQUAL_UINT32(2, interval_calls);
+}
+
+void test_next_deadline_is_never_late() {
+    Harness harness;
+    for (uint32_t i = 0; i < 200; ++i) harness.add(1 + std::rand() % 100000, std::rand() % 4 == 0);
+
+    for (uint32_t i = 0; i < 2000; ++i) {
+        const auto deadline = harness.wheel.next_deadline();
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(harness.reference.next_deadline(), deadline);
+
+        // Nothing fires before the reported deadline
+        if (deadline > 1) {
+            harness.step(deadline - 1);
+            TEST_ASSERT_EQUAL_UINT32(0, harness.fired.size());
+        }
+
+        harness.step(1);
+    }
+}
+
+void test_clear_uses_generation() {
+    TimerWheel wheel;
+    wheel.begin();
+
+    const auto cleared = wheel.add_timeout(record_fire, 100);
+    wheel.clear_timeout(cleared);
+
+    // Slot is reused, stale id must not remove the new timer
+    const auto reused = wheel.add_timeout(record_fire, 200);
+    TEST_ASSERT_EQUAL_UINT32(cleared & 0xffff, reused & 0xffff);
+    wheel.clear_timeout(cleared);
+    wheel.clear_timeout(-1ul);
+
+    unsigned long self = -1ul;
+    uint32_t self_calls = 0;
+    self = wheel.add_interval([&](auto) {
+        if (++self_calls == 3) wheel.clear_interval(self);
+    }, 50);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        host_clock::advance_ms(1);
+        wheel.handle_timers();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1, fire_times.size());
+    TEST_ASSERT_EQUAL_UINT32(3, self_calls);
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.size());
+    TEST_ASSERT_EQUAL_UINT32(-1ul, wheel.next_deadline());
+}
+
+void test_zero_interval_fires_once_per_call() {
+    TimerWheel wheel;
+    wheel.begin();
+
+    uint32_t calls = 0;
+    wheel.add_interval([&](auto) { ++calls; }, 0);
+
+    wheel.handle_timers();
+    TEST_ASSERT_EQUAL_UINT32(1, calls);
+
+    host_clock::advance_ms(500);
+    wheel.handle_timers();
+    TEST_ASSERT_EQUAL_UINT32(2, calls);
+
+    host_clock::advance_ms(1);
+    wheel.handle_timers();
+    TEST_ASSERT_EQUAL_UINT32(3, calls);
+}
+
+void test_matches_reference_timer() {
+    // Start close to the millis() wrap around, so the run crosses it
+    host_clock::set_us((uint64_t) (UINT32_MAX - 30000u) * 1000);
+
+    Harness harness;
+    std::vector<unsigned long> active;
+
+    for (uint32_t i = 0; i < 20000; ++i) {
+        const int action = std::rand() % 10;
+        if (action < 3) {
+            // Mostly short delays with occasional far ones, which go through the cascade
+            // Zero intervals are left out: the wheel fires them at most once per ms, the linear timer on every call
+            const bool repeat = std::rand() % 5 == 0;
+            const unsigned long delay = std::rand() % 8 == 0 ? std::rand() % 600000 : std::rand() % 500;
+            active.push_back(harness.add(repeat ? std::max(delay, 1ul) : delay, repeat));
+        } else if (action == 3 && !active.empty()) {
+            const auto index = std::rand() % active.size();
+            harness.clear(active[index]);
+            active.erase(active.begin() + index);
+        }
+
+        // Loop is sometimes blocked for long, so whole levels are skipped.
+        // Time always advances: a tick consumes its ms, so timers added later in the same ms fire on the next one
+        harness.step(1 + (std::rand() % 50 == 0 ? std::rand() % 100000 : std::rand() % 20));
+    }
+
+    // Run is much shorter than the 32-bit range, so a smaller value means the wrap around was crossed
+    TEST_ASSERT_LESS_THAN_UINT32(UINT32_MAX - 30000u, millis());
+}
+
+void test_benchmark_against_reference() {
+    constexpr uint32_t TIMER_COUNT = 500;
+    constexpr uint32_t DURATION = 60000;
+
+    TimerWheel wheel;
+    ReferenceTimer reference;
+    wheel.begin();
+
+    uint32_t wheel_calls = 0;
+    for (uint32_t i = 0; i < TIMER_COUNT; ++i) {
+        const unsigned long interval = 50 + std::rand() % 5000;
+        wheel.add_interval([&](auto) { ++wheel_calls; }, interval);
+        reference.add(interval, true);
+    }
+
+    using clock = std::chrono::steady_clock;
+    clock::duration wheel_time{}, reference_time{};
+
+    uint32_t reference_calls = 0;
+    for (uint32_t i = 0; i < DURATION; ++i) {
+        host_clock::advance_ms(1);
+
+        auto start = clock::now();
+        wheel.handle_timers();
+        wheel_time += clock::now() - start;
+
+        start = clock::now();
+        reference_calls += reference.handle().size();
+        reference_time += clock::now() - start;
+    }
+
+    using std::chrono::duration_cast, std::chrono::microseconds;
+    printf("TimerWheel: %u timers, %u ms: wheel %lld us, linear %lld us\n", TIMER_COUNT, DURATION,
+           (long long) duration_cast<microseconds>(wheel_time).count(),
+           (long long) duration_cast<microseconds>(reference_time).count());
+
+    TEST_ASSERT_EQUAL_UINT32(reference_calls, wheel_calls);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_timeout_fires_at_deadline);
+    RUN_TEST(test_skip_ahead_fires_overdue_once);
+    RUN_TEST(test_next_deadline_is_never_late);
+    RUN_TEST(test_clear_uses_generation);
+    RUN_TEST(test_zero_interval_fires_once_per_call);
+    RUN_TEST(test_matches_reference_timer);
+    RUN_TEST(test_benchmark_against_reference);
+    return UNITY_END();
+}
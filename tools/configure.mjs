@@ -0,0 +1,219 @@
+#!/usr/bin/env node
+
+// Applies a set of parameters to one or more esp_shades devices as a single transaction.
+// Requires Node.js 22+ (built-in WebSocket), no dependencies.
+//
+// Usage:
+//   node tools/configure.mjs --hosts shade1.local,shade2.local --config profile.json
+//
+// Config maps packet type names to typed values, strings are zero-padded to the given size:
+//   {
+//     "STEPPER_CONFIG_OPEN_SPEED": {"uint16": 1200},
+//     "STEPPER_CONFIG_ACCELERATION": {"uint16": 800},
+//     "STEPPER_CONFIG_FAST_HOMING": {"bool": true},
+//     "SCENE_1_NAME": {"string": "Morning", "size": 16}
+//   }
+
+import fs from "node:fs";
+
+import {PacketType} from "../www/src/cmd.js";
+import {REQUEST_SIGNATURE} from "../www/src/constants.js";
+
+const HEADER_SIZE = 7;              // signature (2), request id (2), type (1), payload size (2)
+const REQUEST_TIMEOUT = 5000;
+const BATCH_SIZE = 240;             // TX_BATCH_SIZE
+
+// Must follow TransactionState and TransactionError order
+const STATES = ["IDLE", "OPEN", "COMMITTED", "FAILED"];
+const ERRORS = ["NONE", "NOT_STARTED", "TOO_LARGE", "MALFORMED", "UNKNOWN_PARAMETER", "NOT_ALLOWED", "SIZE_MISMATCH", "REJECTED"];
+
+const ENCODERS = {
+    bool: (view, v) => view.setUint8(0, v ? 1 : 0),
+    uint8: (view, v) => view.setUint8(0, v),
+    uint16: (view, v) => view.setUint16(0, v, true),
+    uint32: (view, v) => view.setUint32(0, v, true),
+    int32: (view, v) => view.setInt32(0, v, true),
+    float: (view, v) => view.setFloat32(0, v, true),
+};
+
+const SIZES = {bool: 1, uint8: 1, uint16: 2, uint32: 4, int32: 4, float: 4};
+
+function parseArgs(argv) {
+    const args = {};
+    for (let i = 0; i < argv.length; i++) {
+        if (!argv[i].startsWith("--")) continue;
+        args[argv[i].substring(2)] = argv[i + 1] && !argv[i + 1].startsWith("--") ? argv[++i] : true;
+    }
+
+    return args;
+}
+
+function encodeEntry(name, spec) {
+    const type = PacketType[name];
+    if (type === undefined) throw new Error(`Unknown packet type: ${name}`);
+
+    let value;
+    if ("string" in spec) {
+        value = new Uint8Array(spec.size);
+        value.set(new TextEncoder().encode(spec.string).subarray(0, spec.size));
+    } else {
+        const [kind, v] = Object.entries(spec)[0];
+        if (!ENCODERS[kind]) throw new Error(`Unknown value type for ${name}: ${kind}`);
+
+        value = new Uint8Array(SIZES[kind]);
+        ENCODERS[kind](new DataView(value.buffer), v);
+    }
+
+    const entry = new Uint8Array(2 + value.length);
+    entry[0] = type;
+    entry[1] = value.length;
+    entry.set(value, 2);
+
+    return entry;
+}
+
+function buildBatches(entries) {
+    const batches = [];
+    let current = [];
+    let length = 0;
+
+    for (const entry of entries) {
+        if (length + entry.length > BATCH_SIZE) {
+            batches.push(current);
+            current = [];
+            length = 0;
+        }
+
+        current.push(entry);
+        length += entry.length;
+    }
+
+    if (current.length) batches.push(current);
+
+    // Batch packet has fixed size: length (1), data (BATCH_SIZE)
+    return batches.map((list) => {
+        const packet = new Uint8Array(1 + BATCH_SIZE);
+        let offset = 1;
+        for (const entry of list) {
+            packet.set(entry, offset);
+            offset += entry.length;
+        }
+
+        packet[0] = offset - 1;
+        return packet;
+    });
+}
+
+class Client {
+    #ws;
+    #requestId = 0;
+    #pending = new Map();
+
+    static async connect(host) {
+        const client = new Client();
+        await new Promise((resolve, reject) => {
+            client.#ws = new WebSocket(`ws://${host}/ws`);
+            client.#ws.binaryType = "arraybuffer";
+
+            client.#ws.onopen = () => resolve();
+            client.#ws.onerror = (e) => reject(new Error(`Unable to connect: ${e.message ?? host}`));
+            client.#ws.onmessage = (e) => client.#receive(new DataView(e.data));
+        });
+
+        return client;
+    }
+
+    close() {
+        this.#ws.close();
+    }
+
+    request(type, payload = new Uint8Array(0)) {
+        const id = this.#requestId = (this.#requestId + 1) & 0xffff;
+
+        const packet = new Uint8Array(HEADER_SIZE + payload.length);
+        const view = new DataView(packet.buffer);
+        packet.set(REQUEST_SIGNATURE, 0);
+        view.setUint16(2, id, true);
+        view.setUint8(4, type);
+        view.setUint16(5, payload.length, true);
+        packet.set(payload, HEADER_SIZE);
+
+        this.#ws.send(packet);
+
+        return new Promise((resolve, reject) => {
+            const timer = setTimeout(() => {
+                this.#pending.delete(id);
+                reject(new Error(`Request 0x${type.toString(16)} timed out`));
+            }, REQUEST_TIMEOUT);
+
+            this.#pending.set(id, {resolve, timer});
+        });
+    }
+
+    #receive(view) {
+        if (view.byteLength < HEADER_SIZE) return;
+
+        const id = view.getUint16(2, true);
+        const size = view.getUint16(5, true);
+
+        const pending = this.#pending.get(id);
+        if (!pending) return;
+
+        clearTimeout(pending.timer);
+        this.#pending.delete(id);
+        pending.resolve(new DataView(view.buffer, HEADER_SIZE, size));
+    }
+}
+
+function parseStatus(view) {
+    // id (2), state (1), error (1), failed type (1), count (2), staged (2), revision (4)
+    return {
+        id: view.getUint16(0, true),
+        state: STATES[view.getUint8(2)],
+        error: ERRORS[view.getUint8(3)],
+        failedType: Object.keys(PacketType).find((k) => PacketType[k] === view.getUint8(4)),
+        count: view.getUint16(5, true),
+        revision: view.getUint32(9, true),
+    };
+}
+
+async function configure(host, batches) {
+    const client = await Client.connect(host);
+
+    try {
+        await client.request(PacketType.TX_BEGIN);
+        for (const batch of batches) await client.request(PacketType.TX_SET, batch);
+        await client.request(PacketType.TX_COMMIT);
+
+        return parseStatus(await client.request(PacketType.GET_TX_STATUS));
+    } finally {
+        client.close();
+    }
+}
+
+const args = parseArgs(process.argv.slice(2));
+if (!args.hosts || !args.config) {
+    console.log("Usage: configure.mjs --hosts <device>[,<device>...] --config <file.json>");
+    process.exit(1);
+}
+
+const config = JSON.parse(fs.readFileSync(args.config, "utf-8"));
+const batches = buildBatches(Object.entries(config).map(([name, spec]) => encodeEntry(name, spec)));
+
+const results = await Promise.allSettled(args.hosts.split(",").map((host) => configure(host, batches)));
+
+let failed = 0;
+args.hosts.split(",").forEach((host, i) => {
+    const result = results[i];
+    if (result.status === "rejected") {
+        failed++;
+        console.log(`${host}: ${result.reason.message}`);
+    } else if (result.value.state !== "COMMITTED") {
+        failed++;
+        console.log(`${host}: ${result.value.error} at ${result.value.failedType}`);
+    } else {
+        console.log(`${host}: ${result.value.count} parameters committed, revision ${result.value.revision}`);
+    }
+});
+
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,419 @@
+#!/usr/bin/env node
+
+// Load generator and trace replay tool for esp_shades.
+// Requires Node.js 22+ (built-in WebSocket and fetch), no dependencies.
+//
+// Usage:
+//   node tools/loadgen.mjs record  --host esp_shades.local --duration 60 --out trace.bin
+//   node tools/loadgen.mjs replay  --host esp_shades.local --trace trace.bin [--speed 2]
+//   node tools/loadgen.mjs slider  --host esp_shades.local [--clients 4] [--rate 60] [--duration 10]
+//   node tools/loadgen.mjs storm   --host esp_shades.local [--clients 8] [--count 50]
+//
+// Slider drags can be sent over MQTT instead of WebSocket with --mqtt broker[:port] [--topic /position].
+
+import fs from "node:fs";
+import net from "node:net";
+
+import {PacketType} from "../www/src/cmd.js";
+import {REQUEST_SIGNATURE} from "../www/src/constants.js";
+
+const HEADER_SIZE = 7;              // signature (2), request id (2), type (1), payload size (2)
+const TRACE_HEADER_SIZE = 8;        // time (4), source (1), type (1), payload size (1), truncated (1)
+const REQUEST_TIMEOUT = 2000;
+const TRACE_SOURCES = ["Other", "WebSocket", "MQTT"];
+
+function parseArgs(argv) {
+    const [command, ...rest] = argv;
+    const args = {command};
+
+    for (let i = 0; i < rest.length; i++) {
+        if (!rest[i].startsWith("--")) continue;
+        args[rest[i].substring(2)] = rest[i + 1] && !rest[i + 1].startsWith("--") ? rest[++i] : true;
+    }
+
+    return args;
+}
+
+const sleep = (ms) => new Promise(resolve => setTimeout(resolve, ms));
+
+class Stats {
+    samples = [];
+
+    add(value) { this.samples.push(value); }
+
+    percentile(p) {
+        if (!this.samples.length) return NaN;
+
+        const sorted = [...this.samples].sort((a, b) => a - b);
+        return sorted[Math.min(sorted.length - 1, Math.floor(p / 100 * sorted.length))];
+    }
+
+    format(unit = "ms") {
+        if (!this.samples.length) return "no samples";
+
+        return [50, 90, 99].map(p => `p${p} ${this.percentile(p).toFixed(1)} ${unit}`).join(", ")
+            + `, max ${Math.max(...this.samples).toFixed(1)} ${unit} (${this.samples.length} samples)`;
+    }
+}
+
+class Client {
+    #ws;
+    #requestId = 0;
+    #pending = new Map();
+
+    sent = 0;
+    dropped = 0;
+    onNotification = null;
+
+    static async connect(host) {
+        const client = new Client();
+        await client.#open(host);
+
+        return client;
+    }
+
+    #open(host) {
+        return new Promise((resolve, reject) => {
+            this.#ws = new WebSocket(`ws://${host}/ws`);
+            this.#ws.binaryType = "arraybuffer";
+
+            this.#ws.onopen = () => resolve();
+            this.#ws.onerror = (e) => reject(new Error(`Unable to connect: ${e.message ?? host}`));
+            this.#ws.onmessage = (e) => this.#receive(new DataView(e.data));
+        });
+    }
+
+    close() {
+        this.#ws.close();
+    }
+
+    request(type, payload = new Uint8Array(0)) {
+        const id = this.#requestId = (this.#requestId + 1) & 0xffff;
+
+        const packet = new Uint8Array(HEADER_SIZE + payload.length);
+        const view = new DataView(packet.buffer);
+        packet.set(REQUEST_SIGNATURE, 0);
+        view.setUint16(2, id, true);
+        view.setUint8(4, type);
+        view.setUint16(5, payload.length, true);
+        packet.set(payload, HEADER_SIZE);
+
+        this.sent++;
+        this.#ws.send(packet);
+
+        return new Promise((resolve) => {
+            const timer = setTimeout(() => {
+                this.#pending.delete(id);
+                this.dropped++;
+                resolve(null);
+            }, REQUEST_TIMEOUT);
+
+            this.#pending.set(id, {resolve, timer});
+        });
+    }
+
+    #receive(view) {
+        if (view.byteLength < HEADER_SIZE) return;
+
+        const id = view.getUint16(2, true);
+        const type = view.getUint8(4);
+        const size = view.getUint16(5, true);
+        const payload = new DataView(view.buffer, HEADER_SIZE, size);
+
+        const pending = this.#pending.get(id);
+        if (pending) {
+            clearTimeout(pending.timer);
+            this.#pending.delete(id);
+            pending.resolve(payload);
+        } else if (this.onNotification) {
+            this.onNotification(type, payload, performance.now());
+        }
+    }
+}
+
+// Minimal MQTT 3.1.1 publisher, QoS 0 only
+class MqttPublisher {
+    #socket;
+
+    static async connect(address) {
+        const [host, port = 1883] = address.split(":");
+
+        const publisher = new MqttPublisher();
+        await new Promise((resolve, reject) => {
+            publisher.#socket = net.connect(Number(port), host, resolve);
+            publisher.#socket.once("error", reject);
+        });
+
+        const clientId = `loadgen-${process.pid}`;
+        const body = Buffer.concat([
+            MqttPublisher.#string("MQTT"), Buffer.from([4, 0x02, 0, 60]), MqttPublisher.#string(clientId)
+        ]);
+
+        publisher.#socket.write(MqttPublisher.#packet(0x10, body));
+        return publisher;
+    }
+
+    publish(topic, message) {
+        const body = Buffer.concat([MqttPublisher.#string(topic), Buffer.from(message)]);
+        this.#socket.write(MqttPublisher.#packet(0x30, body));
+    }
+
+    close() {
+        this.#socket.end(Buffer.from([0xe0, 0]));
+    }
+
+    static #string(value) {
+        const data = Buffer.from(value);
+        return Buffer.concat([Buffer.from([data.length >> 8, data.length & 0xff]), data]);
+    }
+
+    static #packet(header, body) {
+        const length = [];
+        let size = body.length;
+        do {
+            let byte = size % 128;
+            size = Math.floor(size / 128);
+            if (size > 0) byte |= 0x80;
+            length.push(byte);
+        } while (size > 0);
+
+        return Buffer.concat([Buffer.from([header, ...length]), body]);
+    }
+}
+
+async function readHeap(host) {
+    try {
+        const response = await fetch(`http://${host}/metrics`);
+        const text = await response.text();
+
+        const value = (name) => Number(text.match(new RegExp(`^${name} (\\d+)`, "m"))?.[1]);
+        return {free: value("shades_heap_free_bytes"), minFree: value("shades_heap_min_free_bytes")};
+    } catch {
+        return null;
+    }
+}
+
+/**
+ * Tracks command-to-motion latency: time between a move command and MOVING notification,
+ * and notification delivery latency: time between a parameter change and its notification on other clients.
+ */
+class LatencyMonitor {
+    motion = new Stats();
+    notification = new Stats();
+
+    #moveSent = null;
+    #lastChange = new Map();
+
+    attach(client) {
+        client.onNotification = (type, payload, time) => {
+            if (type === PacketType.MOVING && payload.byteLength && payload.getUint8(0) && this.#moveSent !== null) {
+                this.motion.add(time - this.#moveSent);
+                this.#moveSent = null;
+            }
+
+            const change = this.#lastChange.get(type);
+            if (change && change.client !== client) this.notification.add(time - change.time);
+        };
+    }
+
+    commandSent(client, type) {
+        const time = performance.now();
+        if (this.#moveSent === null && [PacketType.POSITION_TARGET, PacketType.OPEN, PacketType.CLOSE].includes(type)) {
+            this.#moveSent = time;
+        }
+
+        this.#lastChange.set(type, {client, time});
+    }
+}
+
+async function report(host, clients, monitor, heapBefore) {
+    const heapAfter = await readHeap(host);
+
+    const sent = clients.reduce((sum, c) => sum + c.sent, 0);
+    const dropped = clients.reduce((sum, c) => sum + c.dropped, 0);
+
+    console.log(`Requests: ${sent}, dropped: ${dropped} (${(dropped / Math.max(1, sent) * 100).toFixed(2)}%)`);
+    console.log(`Command-to-motion latency: ${monitor.motion.format()}`);
+    console.log(`Notification latency: ${monitor.notification.format()}`);
+
+    if (heapBefore && heapAfter) {
+        console.log(`Heap: free ${heapBefore.free} -> ${heapAfter.free} bytes, min ever ${heapAfter.minFree} bytes`);
+    }
+}
+
+function floatPayload(value) {
+    const payload = new Uint8Array(4);
+    new DataView(payload.buffer).setFloat32(0, value, true);
+
+    return payload;
+}
+
+async function record(args) {
+    const client = await Client.connect(args.host);
+    const duration = Number(args.duration ?? 60);
+
+    await client.request(PacketType.TRACE_START);
+    console.log(`Recording for ${duration} s...`);
+    await sleep(duration * 1000);
+    await client.request(PacketType.TRACE_STOP);
+
+    const data = await client.request(PacketType.GET_TRACE);
+    client.close();
+
+    if (!data) throw new Error("Unable to read trace");
+
+    const overflow = data.getUint8(1);
+    const length = data.getUint16(2, true);
+    const trace = new Uint8Array(data.buffer, data.byteOffset + 4, length);
+
+    fs.writeFileSync(args.out ?? "trace.bin", trace);
+    console.log(`Saved ${length} bytes${overflow ? ", buffer overflowed" : ""}`);
+}
+
+function parseTrace(buffer) {
+    const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.byteLength);
+    const records = [];
+
+    for (let offset = 0; offset + TRACE_HEADER_SIZE <= view.byteLength;) {
+        const size = view.getUint8(offset + 6);
+        records.push({
+            time: view.getUint32(offset, true),
+            source: view.getUint8(offset + 4),
+            type: view.getUint8(offset + 5),
+            payload: buffer.subarray(offset + TRACE_HEADER_SIZE, offset + TRACE_HEADER_SIZE + size),
+            truncated: view.getUint8(offset + 7) !== 0,
+        });
+
+        offset += TRACE_HEADER_SIZE + size;
+    }
+
+    return records;
+}
+
+async function replay(args) {
+    const parsed = parseTrace(fs.readFileSync(args.trace));
+    const speed = Number(args.speed ?? 1);
+
+    const heapBefore = await readHeap(args.host);
+    const monitor = new LatencyMonitor();
+    const client = await Client.connect(args.host);
+    const observer = await Client.connect(args.host);
+    monitor.attach(client);
+    monitor.attach(observer);
+
+    // Truncated payloads would be sent as different, possibly invalid, commands
+    const records = parsed.filter(r => !r.truncated);
+    const skipped = parsed.length - records.length;
+
+    console.log(`Replaying ${records.length} records at ${speed}x${skipped ? `, ${skipped} truncated records skipped` : ""}`);
+
+    // MQTT records carry binary parameter values, so everything is replayed over WebSocket
+    const start = performance.now();
+    const requests = [];
+    for (const record of records) {
+        const delay = record.time / speed - (performance.now() - start);
+        if (delay > 0) await sleep(delay);
+
+        if (args.verbose) console.log(`${record.time} ms: ${TRACE_SOURCES[record.source]} 0x${record.type.toString(16)}`);
+
+        monitor.commandSent(client, record.type);
+        requests.push(client.request(record.type, record.payload));
+    }
+
+    await Promise.all(requests);
+    await sleep(REQUEST_TIMEOUT);
+
+    await report(args.host, [client, observer], monitor, heapBefore);
+
+    client.close();
+    observer.close();
+}
+
+async function slider(args) {
+    const count = Number(args.clients ?? 1);
+    const rate = Number(args.rate ?? 60);
+    const duration = Number(args.duration ?? 10);
+
+    const heapBefore = await readHeap(args.host);
+    const monitor = new LatencyMonitor();
+
+    const clients = [];
+    for (let i = 0; i < count; i++) {
+        const client = await Client.connect(args.host);
+        monitor.attach(client);
+        clients.push(client);
+    }
+
+    const mqtt = args.mqtt ? await MqttPublisher.connect(args.mqtt) : null;
+    const topic = args.topic ?? "/position";
+
+    console.log(`Slider drag: ${count} clients, ${rate} updates/s, ${duration} s${mqtt ? " over MQTT" : ""}`);
+
+    const requests = [];
+    const end = performance.now() + duration * 1000;
+    for (let i = 0; performance.now() < end; i++) {
+        // Triangle wave 0..100 with one full sweep per 4 seconds
+        const phase = (i / rate) % 4;
+        const position = (phase < 2 ? phase : 4 - phase) * 50;
+
+        const client = clients[i % count];
+        monitor.commandSent(client, PacketType.POSITION_TARGET);
+
+        if (mqtt) mqtt.publish(topic, position.toFixed(1));
+        else requests.push(client.request(PacketType.POSITION_TARGET, floatPayload(position)));
+
+        await sleep(1000 / rate);
+    }
+
+    await Promise.all(requests);
+    await sleep(REQUEST_TIMEOUT);
+
+    await report(args.host, clients, monitor, heapBefore);
+
+    mqtt?.close();
+    for (const client of clients) client.close();
+}
+
+async function storm(args) {
+    const count = Number(args.clients ?? 8);
+    const iterations = Number(args.count ?? 50);
+
+    const heapBefore = await readHeap(args.host);
+    const monitor = new LatencyMonitor();
+    const connect = new Stats();
+
+    console.log(`Reconnect storm: ${count} clients, ${iterations} iterations`);
+
+    const clients = [];
+    for (let i = 0; i < iterations; i++) {
+        const batch = await Promise.all(Array.from({length: count}, async () => {
+            const start = performance.now();
+            const client = await Client.connect(args.host);
+            connect.add(performance.now() - start);
+
+            monitor.attach(client);
+            await client.request(PacketType.GET_STATE);
+
+            return client;
+        }));
+
+        for (const client of batch) client.close();
+        clients.push(...batch);
+    }
+
+    console.log(`Connection time: ${connect.format()}`);
+    await report(args.host, clients, monitor, heapBefore);
+}
+
+const COMMANDS = {record, replay, slider, storm};
+
+const args = parseArgs(process.argv.slice(2));
+if (!COMMANDS[args.command] || !args.host) {
+    console.log("Usage: loadgen.mjs <record|replay|slider|storm> --host <address> [options]");
+    process.exit(1);
+}
+
+COMMANDS[args.command](args).catch((e) => {
+    console.error(e.message);
+    process.exit(1);
+});
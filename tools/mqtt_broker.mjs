@@ -0,0 +1,283 @@
+#!/usr/bin/env node
+
+// Minimal MQTT 3.1.1 broker standing in for Mosquitto when testing the device MQTT client.
+// Supports QoS 0/1, retained messages, wildcards and last will. Requires Node.js 18+, no dependencies.
+//
+// Usage:
+//   node tools/mqtt_broker.mjs [--port 1883] [--outage 60] [--outage-duration 10] [--settle 1000]
+//
+// --outage N drops every connection each N seconds and refuses new ones for --outage-duration seconds.
+// After every connection the broker reports how long it took until the client stopped publishing
+// (no publish for --settle ms), i.e. reconnect-to-consistent-state time seen by subscribers.
+// Retained state is printed on exit (Ctrl+C).
+
+import net from "node:net";
+
+function parseArgs(argv) {
+    const args = {};
+    for (let i = 0; i < argv.length; i++) {
+        if (!argv[i].startsWith("--")) continue;
+        args[argv[i].substring(2)] = argv[i + 1] && !argv[i + 1].startsWith("--") ? argv[++i] : true;
+    }
+
+    return args;
+}
+
+const PacketKind = {
+    CONNECT: 1, CONNACK: 2, PUBLISH: 3, PUBACK: 4, SUBSCRIBE: 8, SUBACK: 9,
+    UNSUBSCRIBE: 10, UNSUBACK: 11, PINGREQ: 12, PINGRESP: 13, DISCONNECT: 14,
+};
+
+const retained = new Map();
+const sessions = new Set();
+
+let available = true;
+
+function encodeLength(length) {
+    const bytes = [];
+    do {
+        let byte = length % 128;
+        length = Math.floor(length / 128);
+        if (length > 0) byte |= 0x80;
+        bytes.push(byte);
+    } while (length > 0);
+
+    return Buffer.from(bytes);
+}
+
+function packet(header, body = Buffer.alloc(0)) {
+    return Buffer.concat([Buffer.from([header]), encodeLength(body.length), body]);
+}
+
+function string(value) {
+    const data = Buffer.from(value);
+    const length = Buffer.alloc(2);
+    length.writeUInt16BE(data.length);
+
+    return Buffer.concat([length, data]);
+}
+
+function matches(filter, topic) {
+    const f = filter.split("/");
+    const t = topic.split("/");
+
+    for (let i = 0; i < f.length; i++) {
+        if (f[i] === "#") return true;
+        if (i >= t.length || (f[i] !== "+" && f[i] !== t[i])) return false;
+    }
+
+    return f.length === t.length;
+}
+
+class Session {
+    #socket;
+    #buffer = Buffer.alloc(0);
+    #subscriptions = [];
+    #will = null;
+
+    clientId = "";
+    connectedAt = 0;
+    publishes = 0;
+    lastPublish = 0;
+    #settleTimer = null;
+
+    constructor(socket, settle) {
+        this.#socket = socket;
+        this.settle = settle;
+
+        socket.on("data", (data) => this.#receive(data));
+        socket.on("close", () => this.#closed());
+        socket.on("error", () => {});
+    }
+
+    drop() {
+        this.#socket.destroy();
+    }
+
+    deliver(topic, payload, retain) {
+        if (!this.#subscriptions.some((filter) => matches(filter, topic))) return;
+
+        const flags = retain ? 0x01 : 0x00;
+        this.#socket.write(packet((PacketKind.PUBLISH << 4) | flags, Buffer.concat([string(topic), payload])));
+    }
+
+    #receive(data) {
+        this.#buffer = Buffer.concat([this.#buffer, data]);
+
+        while (this.#buffer.length >= 2) {
+            let length = 0, multiplier = 1, offset = 1, byte;
+            do {
+                if (offset >= this.#buffer.length) return;
+                byte = this.#buffer[offset++];
+                length += (byte & 0x7f) * multiplier;
+                multiplier *= 128;
+            } while (byte & 0x80);
+
+            if (this.#buffer.length < offset + length) return;
+
+            const header = this.#buffer[0];
+            const body = this.#buffer.subarray(offset, offset + length);
+            this.#buffer = this.#buffer.subarray(offset + length);
+
+            this.#handle(header >> 4, header & 0x0f, body);
+        }
+    }
+
+    #handle(kind, flags, body) {
+        switch (kind) {
+            case PacketKind.CONNECT:
+                return this.#connect(body);
+
+            case PacketKind.PUBLISH:
+                return this.#publish(flags, body);
+
+            case PacketKind.SUBSCRIBE:
+                return this.#subscribe(body);
+
+            case PacketKind.UNSUBSCRIBE:
+                this.#socket.write(packet(PacketKind.UNSUBACK << 4, body.subarray(0, 2)));
+                return;
+
+            case PacketKind.PINGREQ:
+                this.#socket.write(packet(PacketKind.PINGRESP << 4));
+                return;
+
+            case PacketKind.DISCONNECT:
+                this.#will = null;
+                this.#socket.end();
+                return;
+        }
+    }
+
+    #connect(body) {
+        let offset = 2 + body.readUInt16BE(0) + 1;  // protocol name, level
+        const connectFlags = body[offset];
+        offset += 3;                                // flags, keep alive
+
+        const readString = () => {
+            const length = body.readUInt16BE(offset);
+            const value = body.subarray(offset + 2, offset + 2 + length);
+            offset += 2 + length;
+            return value;
+        };
+
+        this.clientId = readString().toString();
+        if (connectFlags & 0x04) {
+            const topic = readString().toString();
+            this.#will = {topic, payload: readString(), retain: !!(connectFlags & 0x20)};
+        }
+
+        this.connectedAt = performance.now();
+        this.#socket.write(packet(PacketKind.CONNACK << 4, Buffer.from([0, 0])));
+
+        console.log(`${this.clientId}: connected`);
+    }
+
+    #publish(flags, body) {
+        const qos = (flags >> 1) & 0x03;
+        const retain = !!(flags & 0x01);
+
+        const topicLength = body.readUInt16BE(0);
+        const topic = body.subarray(2, 2 + topicLength).toString();
+        let offset = 2 + topicLength;
+
+        if (qos > 0) {
+            this.#socket.write(packet(PacketKind.PUBACK << 4, body.subarray(offset, offset + 2)));
+            offset += 2;
+        }
+
+        route(topic, Buffer.from(body.subarray(offset)), retain);
+
+        this.publishes++;
+        this.lastPublish = performance.now();
+
+        // Only the burst right after connection is measured
+        if (this.#settleTimer === undefined) return;
+
+        clearTimeout(this.#settleTimer);
+        this.#settleTimer = setTimeout(() => this.#settled(), this.settle);
+    }
+
+    #subscribe(body) {
+        const id = body.subarray(0, 2);
+        const granted = [];
+        const filters = [];
+
+        let offset = 2;
+        while (offset < body.length) {
+            const length = body.readUInt16BE(offset);
+            const filter = body.subarray(offset + 2, offset + 2 + length).toString();
+            granted.push(Math.min(body[offset + 2 + length], 1));
+            offset += 3 + length;
+
+            filters.push(filter);
+        }
+
+        this.#subscriptions.push(...filters);
+        this.#socket.write(packet(PacketKind.SUBACK << 4, Buffer.concat([id, Buffer.from(granted)])));
+
+        for (const [topic, payload] of retained) {
+            if (filters.some((filter) => matches(filter, topic))) this.deliver(topic, payload, true);
+        }
+    }
+
+    #settled() {
+        const time = this.lastPublish - this.connectedAt;
+        console.log(`${this.clientId}: ${this.publishes} publishes, state settled ${time.toFixed(0)} ms after connection`);
+        this.#settleTimer = undefined;
+    }
+
+    #closed() {
+        clearTimeout(this.#settleTimer);
+        sessions.delete(this);
+
+        if (this.#will) route(this.#will.topic, this.#will.payload, this.#will.retain);
+        if (this.clientId) console.log(`${this.clientId}: disconnected`);
+    }
+}
+
+function route(topic, payload, retain) {
+    if (retain) {
+        if (payload.length) retained.set(topic, payload);
+        else retained.delete(topic);
+    }
+
+    for (const session of sessions) session.deliver(topic, payload, false);
+}
+
+const args = parseArgs(process.argv.slice(2));
+const port = Number(args.port ?? 1883);
+const settle = Number(args.settle ?? 1000);
+
+const server = net.createServer((socket) => {
+    if (!available) {
+        socket.destroy();
+        return;
+    }
+
+    sessions.add(new Session(socket, settle));
+});
+
+server.listen(port, () => console.log(`Listening on ${port}`));
+
+if (args.outage) {
+    const duration = Number(args["outage-duration"] ?? 10) * 1000;
+
+    setInterval(() => {
+        console.log(`Outage for ${duration / 1000} s`);
+
+        available = false;
+        for (const session of sessions) session.drop();
+
+        setTimeout(() => available = true, duration);
+    }, Number(args.outage) * 1000);
+}
+
+process.on("SIGINT", () => {
+    console.log("\nRetained:");
+    for (const [topic, payload] of retained) {
+        console.log(`  ${topic} = ${payload.length > 80 ? payload.subarray(0, 80) + "..." : payload}`);
+    }
+
+    process.exit(0);
+});
@@ -0,0 +1,121 @@
+#!/usr/bin/env node
+
+// Decoder for binary event trace of esp_shades (see src/misc/event_trace.h).
+// Requires Node.js 22+, no dependencies.
+//
+// Usage:
+//   node tools/trace_decode.mjs --host esp_shades.local [--out events.bin]
+//   node tools/trace_decode.mjs --file events.bin
+
+import fs from "node:fs";
+
+const SIGNATURE = 0x43525445;
+const VERSION = 1;
+const HEADER_SIZE = 16;             // signature (4), version (1), record size (1), count (2), time (4), dropped (4)
+const RECORD_SIZE = 16;             // time (4), event (1), level (1), axis (1), arg (1), value (4), extra (4)
+
+const LEVELS = ["", "ERROR", "EVENT", "DETAIL"];
+
+const APP_STATES = ["UNINITIALIZED", "INITIALIZATION", "STAND_BY", "HOMING", "MOVING", "PROBING", "CALIBRATION", "SUNRISE"];
+const MOVE_REJECT_REASONS = ["NOT_HOMED", "IN_POSITION"];
+const HOMING_STAGES = [
+    "PREPARING", "FIRST_STEP", "REWIND", "SECOND_STEP", "APPLY_OFFSET", "SUCCESS",
+    "FAST_APPROACH", "EARLY_ENDSTOP", "SLOW_APPROACH", "FALLBACK", "ANALOG_APPROACH"
+];
+const HOMING_FAILURES = ["LIMIT_EXCEEDED", "ENDSTOP_NOT_RESET", "SECOND_LIMIT_EXCEEDED"];
+const DRIFT_PROBE_STAGES = ["APPROACH", "REHOME", "CORRECT"];
+const TRACE_OPERATIONS = ["HOMING", "DRIFT_PROBE", "CALIBRATION", "SUNRISE", "ENDSTOP_CALIBRATION"];
+
+const name = (list, value) => list[value] ?? `#${value}`;
+
+// Must follow TraceEvent order
+const EVENTS = [
+    ["STATE_CHANGED", (r) => name(APP_STATES, r.arg)],
+    ["MOVE_STARTED", (r) => `target ${r.value}, current ${r.extra}`],
+    ["MOVE_REJECTED", (r) => `${name(MOVE_REJECT_REASONS, r.arg)}, target ${r.value}`],
+    ["SCENE_APPLIED", (r) => `scene ${r.arg}, position ${r.value}%, speed ${r.extra}`],
+    ["ENDSTOP_TRIGGERED", (r) => `state ${name(APP_STATES, r.arg)}, step ${r.value}`],
+    ["ENDSTOP_RELEASED", (r) => `step ${r.value}`],
+    ["HOMING_STAGE", (r) => `${name(HOMING_STAGES, r.arg)}, step ${r.value}` + (r.extra ? `, expected distance ${r.extra}` : "")],
+    ["HOMING_FAILED", (r) => `${name(HOMING_FAILURES, r.arg)}, step ${r.value}`],
+    ["DRIFT_PROBE", (r) => `${name(DRIFT_PROBE_STAGES, r.arg)}, step ${r.value}, expected ${r.extra}`],
+    ["FORBIDDEN", (r) => `${name(TRACE_OPERATIONS, r.arg)} in state ${name(APP_STATES, r.extra)}`],
+    ["SUNRISE_BURST", (r) => `burst ${r.arg}, target ${r.value}, current ${r.extra}`],
+    ["ENDSTOP_NEAR", (r) => `state ${name(APP_STATES, r.arg)}, step ${r.value}, level ${r.extra} mV`],
+    ["SPEED_PROFILE", (r) => `${r.arg ? "lowered on step loss" : "raised"}, drift ${r.value}`],
+];
+
+function parseArgs(argv) {
+    const args = {};
+    for (let i = 0; i < argv.length; i++) {
+        if (!argv[i].startsWith("--")) continue;
+        args[argv[i].substring(2)] = argv[i + 1] && !argv[i + 1].startsWith("--") ? argv[++i] : true;
+    }
+
+    return args;
+}
+
+function decode(buffer) {
+    const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.byteLength);
+    if (buffer.byteLength < HEADER_SIZE || view.getUint32(0, true) !== SIGNATURE) {
+        throw new Error("Not an event trace dump");
+    }
+
+    const header = {
+        version: view.getUint8(4),
+        recordSize: view.getUint8(5),
+        count: view.getUint16(6, true),
+        time: view.getUint32(8, true),
+        dropped: view.getUint32(12, true),
+    };
+
+    if (header.version !== VERSION || header.recordSize !== RECORD_SIZE) {
+        throw new Error(`Unsupported trace version ${header.version}, record size ${header.recordSize}`);
+    }
+
+    const records = [];
+    for (let i = 0; i < header.count; i++) {
+        const offset = HEADER_SIZE + i * RECORD_SIZE;
+        records.push({
+            time: view.getUint32(offset, true),
+            event: view.getUint8(offset + 4),
+            level: view.getUint8(offset + 5),
+            axis: view.getUint8(offset + 6),
+            arg: view.getUint8(offset + 7),
+            value: view.getInt32(offset + 8, true),
+            extra: view.getInt32(offset + 12, true),
+        });
+    }
+
+    return {header, records};
+}
+
+function print({header, records}) {
+    console.log(`${records.length} records, ${header.dropped} older records overwritten`);
+
+    for (const r of records) {
+        // Timestamps are 32-bit microseconds, relative time stays correct across wrap
+        const ago = ((header.time - r.time) >>> 0) / 1e6;
+        const [event, format] = EVENTS[r.event] ?? [`EVENT#${r.event}`, (r) => `arg ${r.arg}, value ${r.value}, extra ${r.extra}`];
+
+        console.log(`-${ago.toFixed(6).padStart(12)} s  ${LEVELS[r.level]?.padEnd(6) ?? ""}  axis ${r.axis + 1}  ${event.padEnd(18)} ${format(r)}`);
+    }
+}
+
+const args = parseArgs(process.argv.slice(2));
+
+let data;
+if (args.file) {
+    data = fs.readFileSync(args.file);
+} else if (args.host) {
+    const response = await fetch(`http://${args.host}/events`);
+    if (!response.ok) throw new Error(`Request failed: ${response.status}`);
+
+    data = Buffer.from(await response.arrayBuffer());
+    if (args.out) fs.writeFileSync(args.out, data);
+} else {
+    console.log("Usage: trace_decode.mjs --host <device> [--out file] | --file <file>");
+    process.exit(1);
+}
+
+print(decode(data));
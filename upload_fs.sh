@@ -12,9 +12,6 @@ npm install || (echo "Unable to install npm packages" && exit 2)
 npm run build || (echo "Failed" && exit 3)
 cd ..
 
-echo "Compress..."
-gzip -9 -r ./data/*
-
 echo "Uploading..."
 echo "*** Platform: ${PLATFORM} ***"
 
@@ -0,0 +1,121 @@
+// Builds the web interface into ../data:
+// - bundles and minifies JS / CSS
+// - fingerprints static assets by content hash and moves them to /assets (served as /static/... by firmware)
+// - precompresses everything with gzip, assets are also compressed with brotli
+
+import crypto from "node:crypto";
+import fs from "node:fs";
+import path from "node:path";
+import zlib from "node:zlib";
+
+import * as esbuild from "esbuild";
+
+const SRC_DIR = "./src";
+const FAVICONS_DIR = "./favicons";
+const OUT_DIR = "../data";
+const ASSETS_DIR = path.join(OUT_DIR, "assets");
+const ASSETS_URL = "./static/";
+
+// Fixed names: requested by browsers directly or must keep the same scope
+const STABLE_FILES = ["favicon.ico"];
+
+function contentHash(data) {
+    return crypto.createHash("sha256").update(data).digest("hex").substring(0, 10);
+}
+
+function compress(file, {brotli}) {
+    const data = fs.readFileSync(file);
+
+    fs.writeFileSync(`${file}.gz`, zlib.gzipSync(data, {level: 9}));
+    if (brotli) {
+        fs.writeFileSync(`${file}.br`, zlib.brotliCompressSync(data, {
+            params: {[zlib.constants.BROTLI_PARAM_QUALITY]: zlib.constants.BROTLI_MAX_QUALITY}
+        }));
+    }
+
+    fs.rmSync(file);
+}
+
+/**
+ * @param {string} name
+ * @param {Buffer|string} data
+ * @return {string} URL of the fingerprinted asset
+ */
+function emitAsset(name, data) {
+    const ext = path.extname(name);
+    const hashed = `${path.basename(name, ext)}-${contentHash(data)}${ext}`;
+
+    const file = path.join(ASSETS_DIR, hashed);
+    fs.writeFileSync(file, data);
+    compress(file, {brotli: true});
+
+    return ASSETS_URL + hashed;
+}
+
+async function bundle(entry, options = {}) {
+    const result = await esbuild.build({
+        entryPoints: [entry],
+        bundle: true,
+        format: "esm",
+        minify: true,
+        write: false,
+        ...options,
+    });
+
+    return result.outputFiles[0].contents;
+}
+
+fs.rmSync(OUT_DIR, {recursive: true, force: true});
+fs.mkdirSync(ASSETS_DIR, {recursive: true});
+
+const assets = {
+    "./index.js": emitAsset("index.js", await bundle(path.join(SRC_DIR, "index.js"))),
+    "./lib/style.css": emitAsset("style.css", await bundle(path.join(SRC_DIR, "lib/style.css"), {loader: {".css": "css"}})),
+};
+
+// Manifest references icons, so icons are emitted first
+const manifestPath = path.join(FAVICONS_DIR, "site.webmanifest");
+const manifest = JSON.parse(fs.readFileSync(manifestPath, "utf-8"));
+
+for (const file of fs.readdirSync(FAVICONS_DIR)) {
+    if (file === "site.webmanifest") continue;
+
+    const data = fs.readFileSync(path.join(FAVICONS_DIR, file));
+    if (STABLE_FILES.includes(file)) {
+        fs.writeFileSync(path.join(OUT_DIR, file), data);
+        continue;
+    }
+
+    assets[`./${file}`] = emitAsset(file, data);
+}
+
+// Manifest URLs are resolved relative to the manifest itself, which is also an asset
+for (const icon of manifest.icons) {
+    icon.src = assets[`.${icon.src}`]?.substring(1) ?? icon.src;
+}
+
+assets["./site.webmanifest"] = emitAsset("site.webmanifest", JSON.stringify(manifest));
+
+let html = fs.readFileSync(path.join(SRC_DIR, "index.html"), "utf-8");
+for (const [source, url] of Object.entries(assets)) {
+    html = html.replaceAll(`"${source}"`, `"${url}"`);
+}
+
+html = html.replace(/>\s+</g, "><").trim();
+for (const name of ["index.html", "hotspot-detect.html"]) {
+    const content = name === "index.html" ? html : fs.readFileSync(path.join(SRC_DIR, name), "utf-8");
+    fs.writeFileSync(path.join(OUT_DIR, name), content);
+}
+
+// Service worker keeps stable name, it precaches fingerprinted assets
+const serviceWorker = await bundle(path.join(SRC_DIR, "service_worker.js"), {
+    define: {ASSET_URLS: JSON.stringify(Object.values(assets))}
+});
+fs.writeFileSync(path.join(OUT_DIR, "service_worker.js"), serviceWorker);
+
+for (const file of fs.readdirSync(OUT_DIR)) {
+    const filePath = path.join(OUT_DIR, file);
+    if (fs.statSync(filePath).isFile()) compress(filePath, {brotli: false});
+}
+
+console.log(`Built ${Object.keys(assets).length} fingerprinted assets`);
@@ -8,15 +8,36 @@ import {
     CONNECTION_TIMEOUT_MAX_DELAY,
     REQUEST_SIGNATURE,
     REQUEST_TIMEOUT,
-    THROTTLE_INTERVAL
+    THROTTLE_INTERVAL,
+    TX_BATCH_SIZE
 } from "./constants.js";
 
 import {PacketType} from "./cmd.js";
 
+// Each of them replaces the position target, so only the last one issued before connection is sent
+const DEFERRED_COMMANDS = new Set([PacketType.OPEN, PacketType.CLOSE, PacketType.POSITION_TARGET]);
+
+// Must follow TransactionError order
+const TX_ERRORS = ["None", "Not Started", "Too Large", "Malformed", "Unknown Parameter", "Not Allowed", "Size Mismatch", "Rejected"];
+
+const TX_ENCODERS = {
+    Boolean: [1, (view, v) => view.setUint8(0, v ? 1 : 0)],
+    Uint8: [1, (view, v) => view.setUint8(0, v)],
+    Uint16: [2, (view, v) => view.setUint16(0, v, true)],
+    Int16: [2, (view, v) => view.setInt16(0, v, true)],
+    Uint32: [4, (view, v) => view.setUint32(0, v, true)],
+    Int32: [4, (view, v) => view.setInt32(0, v, true)],
+    Float32: [4, (view, v) => view.setFloat32(0, v, true)],
+};
+
 export class Application extends ApplicationBase {
     #config;
     #reHost = /([?&]host=)(.*)(?:$|&)/;
 
+    #request;
+    #loaded = false;
+    #deferred = null;
+
     get propertyConfig() {return PropertyConfig;}
 
     /**
@@ -36,46 +57,142 @@ export class Application extends ApplicationBase {
             }
         });
 
-        this.#config = new Config();
+        this.#config = new Config(wsUrl);
+        this.#config.onLoad = () => this.#flushDeferred();
+
+        // Hydrated interface is usable before connection, position commands wait until the state is loaded
+        this.#request = this.ws.request.bind(this.ws);
+        this.ws.request = (type, data) => this.#loaded || !DEFERRED_COMMANDS.has(type)
+            ? this.#request(type, data) : this.#defer(type, data);
+
+        this.subscribe(this, this.Event.Disconnected, () => this.#loaded = false);
+    }
+
+    #defer(type, data) {
+        return new Promise((resolve, reject) => {
+            // Superseded command settles together with the one that replaced it
+            const previous = this.#deferred;
+            this.#deferred = {type, data, resolve, reject};
+
+            if (previous) {
+                this.#deferred.resolve = (value) => { previous.resolve(value); resolve(value); };
+                this.#deferred.reject = (err) => { previous.reject(err); reject(err); };
+            }
+        });
+    }
+
+    #flushDeferred() {
+        this.#loaded = true;
+        if (!this.#deferred) return;
+
+        const {type, data, resolve, reject} = this.#deferred;
+        this.#deferred = null;
+
+        this.#request(type, data).then(resolve, reject);
     }
 
 
     async begin(root) {
+        // Cached state is shown immediately, then refreshed once connected
+        await this.#config.hydrate();
+
         await super.begin(root);
 
-        this.propertyMeta["apply_stepper_config"].control.setOnClick(this.applySysConfig.bind(this));
+        this.propertyMeta["apply_stepper_config"].control.setOnClick(this.applyStepperConfig.bind(this));
         this.propertyMeta["apply_sys_config"].control.setOnClick(this.applySysConfig.bind(this));
     }
 
-    async applySysConfig(sender) {
+    async applyStepperConfig(sender) {
         if (sender.getAttribute("data-saving") === "true") return;
 
         sender.setAttribute("data-saving", true);
 
         try {
-            await this.ws.request(PacketType.RESTART);
-
-            const newHostname = this.config.sysConfig.mdnsName + ".local";
-            const hostQueryMatch = location.search.match(this.#reHost);
-            if (hostQueryMatch && hostQueryMatch[2] !== newHostname) {
-                const new_url = location.search.replace(this.#reHost, `$1${newHostname}`)
-                setTimeout(() => window.location = new_url, 3000);
-            } else if (!hostQueryMatch && location.hostname !== "localhost" && location.hostname !== newHostname) {
-                const url_parts = [
-                    location.protocol + "//",
-                    newHostname,
-                    location.port ? ":" + location.port : "",
-                    "/?" + (location.href.split("?")[1] ?? "")
-                ]
-
-                const new_url = url_parts.join("");
-                setTimeout(() => window.location = new_url, 3000);
-            } else {
-                setTimeout(() => window.location.reload(), 3000);
+            const section = PropertyConfig.find(s => s.key === "stepper");
+            const entries = section.props.filter(p => p.txCmd !== undefined).map(p => this.#encodeEntry(p));
+
+            await this.ws.request(PacketType.TX_BEGIN);
+            for (const batch of this.#buildBatches(entries)) await this.ws.request(PacketType.TX_SET, batch);
+            await this.ws.request(PacketType.TX_COMMIT);
+
+            // id (2), state (1), error (1), ...
+            const status = (await this.ws.request(PacketType.GET_TX_STATUS)).parser();
+            status.readUint16();
+            status.readUint8();
+            const error = status.readUint8();
+            if (error !== 0) throw new Error(`Config rejected: ${TX_ERRORS[error] ?? error}`);
+
+            // Driver and motion settings are applied on start
+            await this.#restart();
+        } catch (err) {
+            console.log("Unable to apply stepper config", err);
+            sender.setAttribute("data-saving", false);
+        }
+    }
+
+    #encodeEntry(prop) {
+        const [size, encode] = TX_ENCODERS[prop.kind];
+        const entry = new Uint8Array(2 + size);
+        entry[0] = prop.txCmd;
+        entry[1] = size;
+
+        encode(new DataView(entry.buffer, 2), prop.key.split(".").reduce((obj, key) => obj[key], this.config));
+        return entry;
+    }
+
+    #buildBatches(entries) {
+        // Batch packet has fixed size: length (1), data (TX_BATCH_SIZE)
+        const batches = [];
+        let batch = null, offset = 0;
+
+        for (const entry of entries) {
+            if (!batch || offset + entry.length > TX_BATCH_SIZE) {
+                batch = new Uint8Array(1 + TX_BATCH_SIZE);
+                batches.push(batch);
+                offset = 0;
             }
+
+            batch.set(entry, 1 + offset);
+            offset += entry.length;
+            batch[0] = offset;
+        }
+
+        return batches;
+    }
+
+    async applySysConfig(sender) {
+        if (sender.getAttribute("data-saving") === "true") return;
+
+        sender.setAttribute("data-saving", true);
+
+        try {
+            await this.#restart();
         } catch (err) {
             console.log("Unable to send restart signal", err);
             sender.setAttribute("data-saving", false);
         }
     }
-}
\ No newline at end of file
+
+    async #restart() {
+        await this.ws.request(PacketType.RESTART);
+
+        const newHostname = this.config.sysConfig.mdnsName + ".local";
+        const hostQueryMatch = location.search.match(this.#reHost);
+        if (hostQueryMatch && hostQueryMatch[2] !== newHostname) {
+            const new_url = location.search.replace(this.#reHost, `$1${newHostname}`)
+            setTimeout(() => window.location = new_url, 3000);
+        } else if (!hostQueryMatch && location.hostname !== "localhost" && location.hostname !== newHostname) {
+            const url_parts = [
+                location.protocol + "//",
+                newHostname,
+                location.port ? ":" + location.port : "",
+                "/?" + (location.href.split("?")[1] ?? "")
+            ]
+
+            const new_url = url_parts.join("");
+            setTimeout(() => window.location = new_url, 3000);
+        } else {
+            setTimeout(() => window.location.reload(), 3000);
+        }
+    }
+}
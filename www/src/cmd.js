@@ -9,10 +9,19 @@ export const PacketType = {
     POSITION_TARGET: 0x12,
     MOVING: 0x13,
     SPEED: 0x14,
+    CALIBRATION_STAGE: 0x15,
+    APPLY_SCENE: 0x16,
+    RUN_SEQUENCE: 0x17,
+    SEQUENCE_STEP: 0x18,
+    SEQUENCE_1_ERROR: 0x19,
+    SEQUENCE_2_ERROR: 0x1A,
 
     NIGHT_MODE_ENABLED: 0x20,
     NIGHT_MODE_START: 0x21,
     NIGHT_MODE_END: 0x22,
+    NIGHT_MODE_START_SCENE: 0x23,
+    NIGHT_MODE_END_SCENE: 0x24,
+    NIGHT_MODE_SUNRISE_DURATION: 0x25,
 
 
     STEPPER_CALIBRATION_OFFSET: 0x30,
@@ -33,6 +42,32 @@ export const PacketType = {
     STEPPER_CONFIG_HOMING_STEPS: 0x47,
     STEPPER_CONFIG_HOMING_STEPS_MAX: 0x48,
 
+    STEPPER_CONFIG_FAST_HOMING: 0x49,
+    STEPPER_CONFIG_FAST_HOMING_MARGIN: 0x4A,
+
+    STEPPER_CONFIG_DRIFT_CHECK: 0x4B,
+    STEPPER_CONFIG_DRIFT_CORRECTION_THRESHOLD: 0x4C,
+    STEPPER_CONFIG_DRIFT_REHOME_THRESHOLD: 0x4D,
+
+    STEPPER_CONFIG_DRIVE_MODE: 0x4E,
+
+
+    COIL_POWER_HOLD_STRATEGY: 0x50,
+    COIL_POWER_HOLD_TIME: 0x51,
+    COIL_POWER_HOLD_DUTY: 0x52,
+    COIL_POWER_BRAKE_TIME: 0x53,
+    COIL_POWER_COIL_CURRENT: 0x54,
+    COIL_POWER_SUPPLY_VOLTAGE: 0x55,
+
+    GROUP_SYNC_ENABLED: 0x58,
+    GROUP_SYNC_GROUP: 0x59,
+    GROUP_SYNC_LEADER: 0x5A,
+    GROUP_SYNC_START_DELAY: 0x5B,
+
+    SPEED_PROFILE_ENABLED: 0x5C,
+    SPEED_PROFILE_MIN_FACTOR: 0x5D,
+    SPEED_PROFILE_MAX_FACTOR: 0x5E,
+
 
     SYS_CONFIG_MDNS_NAME: 0x60,
 
@@ -60,13 +95,57 @@ export const PacketType = {
     SYS_CONFIG_ENDSTOP_PIN: 0x81,
     SYS_CONFIG_ENDSTOP_HIGH_STATE: 0x82,
 
+    ENDSTOP_MODE: 0x83,
+    ENDSTOP_SLOWDOWN_LEVEL: 0x84,
+    ENDSTOP_TRIGGER_LEVEL: 0x85,
+    ENDSTOP_HYSTERESIS: 0x86,
+
+    SEQUENCE_1_SCRIPT: 0x88,
+    SEQUENCE_2_SCRIPT: 0x89,
+
+    SCENE_1_NAME: 0x90,
+    SCENE_1_POSITION: 0x91,
+    SCENE_1_SPEED: 0x92,
+
+    SCENE_2_NAME: 0x94,
+    SCENE_2_POSITION: 0x95,
+    SCENE_2_SPEED: 0x96,
+
+    SCENE_3_NAME: 0x98,
+    SCENE_3_POSITION: 0x99,
+    SCENE_3_SPEED: 0x9A,
+
+    SCENE_4_NAME: 0x9C,
+    SCENE_4_POSITION: 0x9D,
+    SCENE_4_SPEED: 0x9E,
+
     GET_CONFIG: 0xa0,
     GET_STATE: 0xa1,
+    GET_DRIFT: 0xa2,
+    GET_CALIBRATION: 0xa3,
+    GET_GROUP_SYNC: 0xa4,
+    GET_PROFILE: 0xa5,
+    GET_TRACE: 0xa6,
+    GET_REVISION: 0xa7,
+    GET_TX_STATUS: 0xa8,
+    GET_ENDSTOP: 0xa9,
+    GET_SPEED_PROFILE: 0xaa,
     RESTART: 0xb0,
+    TX_SET: 0xb8,
 
     HOMING: 0xc0,
     OPEN: 0xc1,
     CLOSE: 0xc2,
     STOP: 0xc3,
     APPLY_OFFSET: 0xc4,
+    CALIBRATION_START: 0xc5,
+    CALIBRATION_CONFIRM: 0xc6,
+    CALIBRATION_APPLY: 0xc7,
+    PROFILE_RESET: 0xc8,
+    TRACE_START: 0xc9,
+    TRACE_STOP: 0xca,
+    TX_BEGIN: 0xcb,
+    TX_COMMIT: 0xcc,
+    ENDSTOP_CALIBRATE: 0xcd,
+    SPEED_PROFILE_RESET: 0xce,
 };
\ No newline at end of file
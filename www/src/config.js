@@ -2,6 +2,10 @@ import {AppConfigBase} from "./lib/index.js";
 
 import {PropertyConfig} from "./props.js";
 import {PacketType} from "./cmd.js";
+import {loadSnapshot, saveSnapshot} from "./snapshot.js";
+import {
+    AXIS_COUNT, PROFILE_HISTOGRAM_SIZE, PROFILE_SECTIONS, SCENE_COUNT, SEQUENCE_COUNT, SEQUENCE_MAX_STEPS, SPEED_PROFILE_BANDS
+} from "./constants.js";
 
 
 export class Config extends AppConfigBase {
@@ -9,52 +13,167 @@ export class Config extends AppConfigBase {
     nightMode;
     stepperCalibration;
     stepperConfig;
+    coilPower;
+    endstop;
+    speedProfile;
     sysConfig;
+    groupSync;
+    scenes;
+    sequences;
 
     status;
+    calibration;
+    groupSyncStatus;
+    profile;
+    speedProfileState;
 
-    constructor() {
+    #gateway;
+    #revision = null;
+
+    /** Called once device state is loaded after every connection */
+    onLoad = null;
+
+    constructor(gateway) {
         super(PropertyConfig);
 
+        this.#gateway = gateway;
+
         this.lists["wifiMode"] = [
             {code: 0, name: "AP"},
             {code: 1, name: "STA"},
         ];
+
+        this.lists["driveMode"] = [
+            {code: 0, name: "Wave"},
+            {code: 1, name: "Full Step"},
+            {code: 2, name: "Half Step"},
+        ];
+
+        this.lists["speed"] = [
+            {code: 0, name: "Slow"},
+            {code: 1, name: "Medium"},
+            {code: 2, name: "Fast"},
+        ];
+
+        this.lists["scene"] = [
+            {code: 0, name: "None"},
+            {code: 1, name: "Scene 1"},
+            {code: 2, name: "Scene 2"},
+            {code: 3, name: "Scene 3"},
+            {code: 4, name: "Scene 4"},
+        ];
+
+        this.lists["sequence"] = [
+            {code: 0, name: "None"},
+            {code: 1, name: "Sequence 1"},
+            {code: 2, name: "Sequence 2"},
+        ];
+
+        this.lists["holdStrategy"] = [
+            {code: 0, name: "Release"},
+            {code: 1, name: "Hold"},
+            {code: 2, name: "Timed Hold"},
+            {code: 3, name: "PWM Hold"},
+        ];
+
+        this.lists["endstopMode"] = [
+            {code: 0, name: "Digital"},
+            {code: 1, name: "Analog"},
+        ];
     }
 
     get cmd() {return PacketType.GET_CONFIG;}
 
+    /**
+     * Restores last known state, so the interface can be shown before connection.
+     * @return {Promise<boolean>}
+     */
+    async hydrate() {
+        const snapshot = await loadSnapshot(this.#gateway);
+        if (!snapshot) return false;
+
+        Object.assign(this, snapshot.config, snapshot.state);
+        this.#revision = snapshot.revision;
+        this.#updateLists();
+
+        return true;
+    }
+
     async load(ws) {
-        const statePacket = await ws.request(PacketType.GET_STATE)
+        // Small packets are requested together, so connection latency is paid once
+        const [revisionPacket, statePacket, calibrationPacket, groupSyncPacket, profilePacket, speedProfilePacket] = await Promise.all([
+            ws.request(PacketType.GET_REVISION),
+            ws.request(PacketType.GET_STATE),
+            ws.request(PacketType.GET_CALIBRATION),
+            ws.request(PacketType.GET_GROUP_SYNC),
+            ws.request(PacketType.GET_PROFILE),
+            ws.request(PacketType.GET_SPEED_PROFILE),
+        ]);
+
         this.status = this.#parseState(statePacket.parser());
+        this.calibration = this.#parseCalibration(calibrationPacket.parser());
+        this.groupSyncStatus = this.#parseGroupSync(groupSyncPacket.parser());
+        this.profile = this.#parseProfile(profilePacket.parser());
+        this.speedProfileState = this.#parseSpeedProfileState(speedProfilePacket.parser());
 
-        await super.load(ws);
+        // Config is the largest packet, skip it when cached copy has the same revision
+        const revision = this.#parseRevision(revisionPacket.parser());
+        if (!this.#revision || this.#revision.bootId !== revision.bootId || this.#revision.revision !== revision.revision) {
+            await super.load(ws);
+        }
+
+        this.#revision = revision;
+        await this.#saveSnapshot();
+
+        this.onLoad?.();
+    }
+
+    async #saveSnapshot() {
+        await saveSnapshot(this.#gateway, {
+            revision: this.#revision,
+            config: {
+                speed: this.speed,
+                nightMode: this.nightMode,
+                stepperCalibration: this.stepperCalibration,
+                stepperConfig: this.stepperConfig,
+                coilPower: this.coilPower,
+                endstop: this.endstop,
+                speedProfile: this.speedProfile,
+                sysConfig: this.sysConfig,
+                groupSync: this.groupSync,
+                scenes: this.scenes,
+                sequences: this.sequences,
+            },
+            state: {
+                status: this.status,
+                calibration: this.calibration,
+                groupSyncStatus: this.groupSyncStatus,
+                profile: this.profile,
+                speedProfileState: this.speedProfileState,
+            }
+        });
     }
 
     parse(parser) {
-        this.speed = parser.readUint8();
+        // Web interface controls the first axis, rest of them are skipped
+        const axes = [];
+        for (let i = 0; i < AXIS_COUNT; i++) axes.push(this.#parseAxis(parser));
 
-        this.stepperCalibration = {
-            offset: parser.readUint16(),
-            openPosition: parser.readInt32()
-        };
+        const axis = axes[0];
+        this.speed = axis.speed;
+        this.stepperCalibration = axis.stepperCalibration;
+        this.stepperConfig = axis.stepperConfig;
+        this.coilPower = axis.coilPower;
+        this.endstop = axis.endstop;
+        this.speedProfile = axis.speedProfile;
 
         this.nightMode = {
             enabled: parser.readBoolean(),
             startTime: parser.readUint32(),
-            endTime: parser.readUint32()
-        };
-
-        this.stepperConfig = {
-            reverse: parser.readBoolean(),
-            resolution: parser.readUint16(),
-            openSpeed: parser.readUint16(),
-            closeSpeed: parser.readUint16(),
-            acceleration: parser.readUint16(),
-            homingSpeed: parser.readUint16(),
-            homingSpeedSecond: parser.readUint16(),
-            homingSteps: parser.readInt32(),
-            homingStepsMax: parser.readInt32()
+            endTime: parser.readUint32(),
+            startScene: parser.readUint8(),
+            endScene: parser.readUint8(),
+            sunriseDuration: parser.readUint16()
         };
 
         this.sysConfig = {
@@ -67,14 +186,7 @@ export class Config extends AppConfigBase {
             wifiConnectionCheckInterval: parser.readUint32(),
             wifiMaxConnectionAttemptInterval: parser.readUint32(),
 
-            stepperPin1: parser.readUint8(),
-            stepperPin2: parser.readUint8(),
-            stepperPin3: parser.readUint8(),
-            stepperPin4: parser.readUint8(),
-            stepperPinEn: parser.readUint8(),
-
-            endstopPin: parser.readUint8(),
-            endstopHighState: parser.readBoolean(),
+            ...this.#parseAxisPinsList(parser)[0],
 
             timeZone: parser.readFloat32(),
 
@@ -84,6 +196,154 @@ export class Config extends AppConfigBase {
             mqttUser: parser.readFixedString(32),
             mqttPassword: parser.readFixedString(32)
         };
+
+        this.groupSync = {
+            enabled: parser.readBoolean(),
+            group: parser.readUint8(),
+            leader: parser.readBoolean(),
+            startDelay: parser.readUint16()
+        };
+
+        this.scenes = [];
+        for (let i = 0; i < SCENE_COUNT; i++) {
+            this.scenes.push({
+                name: parser.readFixedString(16),
+                position: parser.readUint8(),
+                speed: parser.readUint8()
+            });
+        }
+
+        this.sequences = [];
+        for (let i = 0; i < SEQUENCE_COUNT; i++) {
+            this.sequences.push({script: this.#parseSequence(parser)});
+        }
+
+        this.#updateLists();
+    }
+
+    #updateLists() {
+        for (let i = 0; i < SCENE_COUNT; i++) {
+            this.lists["scene"][i + 1].name = this.scenes[i].name || `Scene ${i + 1}`;
+        }
+    }
+
+    #parseSequence(parser) {
+        const steps = [];
+        for (let i = 0; i < SEQUENCE_MAX_STEPS; i++) {
+            steps.push({op: parser.readUint8(), arg: parser.readUint32()});
+        }
+
+        // Firmware stores compiled steps only, so script is restored from them
+        const commands = [];
+        for (const {op, arg} of steps) {
+            if (op === 0) break;
+
+            switch (op) {
+                case 1:
+                    commands.push(`move ${arg}`);
+                    break;
+
+                case 2:
+                    commands.push(`wait ${arg}`);
+                    break;
+
+                case 3:
+                    commands.push(`speed ${["slow", "medium", "fast"][arg] ?? arg}`);
+                    break;
+
+                case 4: {
+                    const hours = Math.floor(arg / 3600);
+                    const minutes = Math.floor(arg % 3600 / 60);
+                    commands.push(`at ${hours}:${minutes.toString().padStart(2, "0")}`);
+                    break;
+                }
+
+                case 5:
+                    commands.push("home");
+                    break;
+            }
+        }
+
+        return commands.join(";");
+    }
+
+    #parseAxis(parser) {
+        return {
+            speed: parser.readUint8(),
+
+            stepperCalibration: {
+                offset: parser.readUint16(),
+                openPosition: parser.readInt32()
+            },
+
+            stepperConfig: {
+                reverse: parser.readBoolean(),
+                resolution: parser.readUint16(),
+                openSpeed: parser.readUint16(),
+                closeSpeed: parser.readUint16(),
+                acceleration: parser.readUint16(),
+                homingSpeed: parser.readUint16(),
+                homingSpeedSecond: parser.readUint16(),
+                homingSteps: parser.readInt32(),
+                homingStepsMax: parser.readInt32(),
+                fastHoming: parser.readBoolean(),
+                fastHomingMargin: parser.readInt32(),
+                driftCheck: parser.readBoolean(),
+                driftCorrectionThreshold: parser.readUint16(),
+                driftRehomeThreshold: parser.readUint16(),
+                driveMode: parser.readUint8()
+            },
+
+            coilPower: {
+                holdStrategy: parser.readUint8(),
+                holdTime: parser.readUint16(),
+                holdDuty: parser.readUint8(),
+                brakeTime: parser.readUint16(),
+                coilCurrent: parser.readUint16(),
+                supplyVoltage: parser.readUint16()
+            },
+
+            endstop: {
+                mode: parser.readUint8(),
+                slowdownLevel: parser.readUint16(),
+                triggerLevel: parser.readUint16(),
+                hysteresis: parser.readUint16()
+            },
+
+            speedProfile: {
+                enabled: parser.readBoolean(),
+                minFactor: parser.readUint8(),
+                maxFactor: parser.readUint8()
+            },
+
+            stepperState: {
+                positionValid: parser.readBoolean(),
+                position: parser.readInt32()
+            },
+
+            // Up-to-date copy is requested with GET_SPEED_PROFILE, learning doesn't change config revision
+            speedProfileState: this.#parseSpeedProfileState(parser)
+        };
+    }
+
+    #parseAxisPins(parser) {
+        return {
+            stepperPin1: parser.readUint8(),
+            stepperPin2: parser.readUint8(),
+            stepperPin3: parser.readUint8(),
+            stepperPin4: parser.readUint8(),
+            stepperPinEn: parser.readUint8(),
+
+            endstopPin: parser.readUint8(),
+            endstopHighState: parser.readBoolean()
+        };
+    }
+
+    #parseAxisPinsList(parser) {
+        const pins = [];
+        for (let i = 0; i < AXIS_COUNT; i++) pins.push(this.#parseAxisPins(parser));
+
+        return pins;
     }
 
     #parseState(parser) {
@@ -94,7 +354,92 @@ export class Config extends AppConfigBase {
             position_target: parser.readFloat32(),
             offset: parser.readInt16(),
             speed: parser.readFloat32(),
-            speed_steps: parser.readInt32()
+            speed_steps: parser.readInt32(),
+            coil_move_on_time: parser.readUint32(),
+            coil_move_energy: parser.readFloat32(),
+            coil_total_on_time: parser.readFloat32(),
+            coil_total_energy: parser.readFloat32(),
+            scene: parser.readUint8(),
+            sequence: parser.readUint8(),
+            sequence_step: parser.readUint8()
+        }
+    }
+
+    #parseCalibration(parser) {
+        return {
+            stage: parser.readUint8(),
+            bottom: parser.readInt32(),
+            travel: parser.readFloat32(),
+            travelDeviation: parser.readFloat32(),
+            releaseDistance: parser.readInt32(),
+            suggestedOpenSpeed: parser.readUint16(),
+            suggestedCloseSpeed: parser.readUint16(),
+            suggestedAcceleration: parser.readUint16(),
+            suggestedOffset: parser.readInt16(),
+            suggestedOpenPosition: parser.readInt32(),
+        }
+    }
+
+    #parseSpeedProfileState(parser) {
+        const readBands = () => {
+            const bands = [];
+            for (let i = 0; i < SPEED_PROFILE_BANDS; i++) bands.push(parser.readUint8());
+            return bands;
+        };
+
+        const [openSpeed, closeSpeed, openAcceleration, closeAcceleration] = [readBands(), readBands(), readBands(), readBands()];
+        return {openSpeed, closeSpeed, openAcceleration, closeAcceleration};
+    }
+
+    #parseGroupSync(parser) {
+        return {
+            synced: parser.readBoolean(),
+            leader: parser.readUint32(),
+            offset: parser.readInt32(),
+            rtt: parser.readUint32(),
+            syncCount: parser.readUint32(),
+            moveCount: parser.readUint32(),
+            lastMoveLateness: parser.readInt32(),
         }
     }
+
+    #parseRevision(parser) {
+        return {
+            bootId: parser.readUint32(),
+            revision: parser.readUint32(),
+        }
+    }
+
+    #parseProfile(parser) {
+        const window = parser.readUint32();
+
+        const sections = [];
+        for (let i = 0; i < PROFILE_SECTIONS.length; i++) {
+            const section = {
+                count: parser.readUint32(),
+                total: parser.readUint32(),
+                max: parser.readUint32(),
+                histogram: []
+            };
+
+            for (let j = 0; j < PROFILE_HISTOGRAM_SIZE; j++) section.histogram.push(parser.readUint32());
+            sections.push(section);
+        }
+
+        const result = {
+            window,
+            sections,
+            stallSection: parser.readUint8(),
+            stall: parser.readUint32(),
+            stepCount: parser.readUint32(),
+            stepRequested: parser.readFloat32(),
+            stepAchieved: parser.readFloat32(),
+            stepMaxLateness: parser.readUint32(),
+            asleep: parser.readUint32(),
+            wakeups: parser.readUint32(),
+        };
+
+        result.asleepShare = window ? result.asleep / window * 100 : 0;
+        return result;
+    }
 }
\ No newline at end of file
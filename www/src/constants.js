@@ -6,4 +6,14 @@ export const CONNECTION_CLOSE_TIMEOUT = 500;
 export const REQUEST_SIGNATURE = [0xca, 0xac];
 export const DEFAULT_ADDRESS = "esp_shades.local";
 
-export const THROTTLE_INTERVAL = 1000 / 60;
\ No newline at end of file
+export const THROTTLE_INTERVAL = 1000 / 60;
+
+export const AXIS_COUNT = 1; // Must match AXIS_COUNT in firmware constants.h
+export const SCENE_COUNT = 4;
+export const SEQUENCE_COUNT = 2;
+export const SEQUENCE_MAX_STEPS = 8;
+export const SPEED_PROFILE_BANDS = 8;
+export const TX_BATCH_SIZE = 240;
+
+export const PROFILE_SECTIONS = ["Loop", "Step Tick", "Bootstrap", "Service Loop", "Bootstrap Service", "Move Notification", "Periodic Status"];
+export const PROFILE_HISTOGRAM_SIZE = 12;
@@ -2,7 +2,9 @@ import {DEFAULT_ADDRESS} from "./constants.js";
 import {Application} from "./application.js";
 import * as ManifestUtils from "./utils/manifest.js";
 
-await ManifestUtils.makeManifest("./site.webmanifest");
+// Manifest name is fingerprinted by the build, so take it from the page
+const manifestUrl = document.querySelector("link[rel=manifest]")?.getAttribute("href") ?? "./site.webmanifest";
+await ManifestUtils.makeManifest(manifestUrl);
 
 const params = new Proxy(new URLSearchParams(window.location.search), {
     get: (searchParams, prop) => searchParams.get(prop),
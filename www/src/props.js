@@ -1,4 +1,5 @@
 import {PacketType} from "./cmd.js";
+import {PROFILE_SECTIONS, SEQUENCE_MAX_STEPS} from "./constants.js";
 
 /**@type {PropertiesConfig} */
 export const PropertyConfig = [{
@@ -38,6 +39,10 @@ export const PropertyConfig = [{
             visibleIf: "status.homed",
             displayConverter: (value) => ["Slow", "Medium", "Fast"][value]
         },
+        {
+            key: "status.scene", title: "Scene", type: "select", kind: "Uint8", cmd: PacketType.APPLY_SCENE, list: "scene",
+            visibleIf: "status.homed"
+        },
         {type: "title", label: "Actions", extra: {m_top: true}},
         {key: "do_homing", type: "button", label: "Homing", visibleIf: "status.homed", visibilityInvert: true, cmd: PacketType.HOMING},
         {key: "do_open", type: "button", label: "Open", visibleIf: "status.homed", cmd: PacketType.OPEN},
@@ -53,32 +58,181 @@ export const PropertyConfig = [{
         {type: "title", label: "Actions", extra: {m_top: true}},
         {key: "do_apply_offset", type: "button", label: "Apply Offset", visibleIf: "status.homed", cmd: PacketType.APPLY_OFFSET},
         {key: "do_homing_2", type: "button", label: "Homing", cmd: PacketType.HOMING},
+
+        {type: "title", label: "Auto Calibration", extra: {m_top: true}},
+        {
+            key: "calibration.stage", type: "label", kind: "Uint8", cmd: PacketType.CALIBRATION_STAGE,
+            displayConverter: (value) => [
+                "Stage",
+                ["Idle", "Homing", "Move to bottom and confirm", "Measuring travel", "Speed test", "Done", "Failed"][value]
+            ]
+        },
+        {key: "do_calibration_start", type: "button", label: "Start", cmd: PacketType.CALIBRATION_START},
+        {key: "do_calibration_confirm", type: "button", label: "Confirm Bottom", cmd: PacketType.CALIBRATION_CONFIRM},
+        {key: "do_calibration_apply", type: "button", label: "Apply Calibration", cmd: PacketType.CALIBRATION_APPLY},
     ]
 }, {
     key: "night_mode", section: "Night Mode", collapse: true, props: [
         {key: "nightMode.enabled", title: "Enabled", type: "trigger", kind: "Boolean", cmd: PacketType.NIGHT_MODE_ENABLED},
         {key: "nightMode.startTime", title: "Start Time", type: "time", kind: "Uint32", cmd: PacketType.NIGHT_MODE_START},
         {key: "nightMode.endTime", title: "End Time", type: "time", kind: "Uint32", cmd: PacketType.NIGHT_MODE_END},
+        {key: "nightMode.startScene", title: "Start Scene", type: "select", kind: "Uint8", cmd: PacketType.NIGHT_MODE_START_SCENE, list: "scene"},
+        {key: "nightMode.endScene", title: "End Scene", type: "select", kind: "Uint8", cmd: PacketType.NIGHT_MODE_END_SCENE, list: "scene"},
+        {key: "nightMode.sunriseDuration", title: "Sunrise Duration (min)", type: "int", kind: "Uint16", cmd: PacketType.NIGHT_MODE_SUNRISE_DURATION},
     ]
 }, {
+    // Fields are sent together by Apply as one config transaction (txCmd), so the device never runs half-updated settings
     key: "stepper", section: "Stepper", collapse: true, props: [
-        {key: "stepperConfig.reverse", title: "Reverse Direction", type: "trigger", kind: "Boolean", cmd: PacketType.STEPPER_CONFIG_REVERSE},
-        {key: "stepperConfig.resolution", title: "Resolution", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_RESOLUTION},
+        {key: "stepperConfig.reverse", title: "Reverse Direction", type: "trigger", kind: "Boolean", txCmd: PacketType.STEPPER_CONFIG_REVERSE},
+        {key: "stepperConfig.resolution", title: "Resolution", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_RESOLUTION},
+        {key: "stepperConfig.driveMode", title: "Drive Mode", type: "select", kind: "Uint8", txCmd: PacketType.STEPPER_CONFIG_DRIVE_MODE, list: "driveMode"},
 
         {type: "title", label: "Speed Settings"},
-        {key: "stepperConfig.openSpeed", title: "Open Speed", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_OPEN_SPEED},
-        {key: "stepperConfig.closeSpeed", title: "Close Speed", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_CLOSE_SPEED},
-        {key: "stepperConfig.acceleration", title: "Acceleration", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_ACCELERATION},
+        {key: "stepperConfig.openSpeed", title: "Open Speed", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_OPEN_SPEED},
+        {key: "stepperConfig.closeSpeed", title: "Close Speed", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_CLOSE_SPEED},
+        {key: "stepperConfig.acceleration", title: "Acceleration", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_ACCELERATION},
 
         {type: "title", label: "Homing Settings"},
-        {key: "stepperConfig.homingSpeed", title: "Homing Speed", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_HOMING_SPEED},
-        {key: "stepperConfig.homingSpeedSecond", title: "Secondary Homing Speed", type: "int", kind: "Uint16", cmd: PacketType.STEPPER_CONFIG_HOMING_SPEED_SECOND},
-        {key: "stepperConfig.homingSteps", title: "Homing Steps", type: "int", kind: "Int32", cmd: PacketType.STEPPER_CONFIG_HOMING_STEPS},
-        {key: "stepperConfig.homingStepsMax", title: "Max Homing Steps", type: "int", kind: "Int32", cmd: PacketType.STEPPER_CONFIG_HOMING_STEPS_MAX},
+        {key: "stepperConfig.homingSpeed", title: "Homing Speed", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_HOMING_SPEED},
+        {key: "stepperConfig.homingSpeedSecond", title: "Secondary Homing Speed", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_HOMING_SPEED_SECOND},
+        {key: "stepperConfig.homingSteps", title: "Homing Steps", type: "int", kind: "Int32", txCmd: PacketType.STEPPER_CONFIG_HOMING_STEPS},
+        {key: "stepperConfig.homingStepsMax", title: "Max Homing Steps", type: "int", kind: "Int32", txCmd: PacketType.STEPPER_CONFIG_HOMING_STEPS_MAX},
+        {key: "stepperConfig.fastHoming", title: "Fast Homing", type: "trigger", kind: "Boolean", txCmd: PacketType.STEPPER_CONFIG_FAST_HOMING},
+        {key: "stepperConfig.fastHomingMargin", title: "Fast Homing Margin", type: "int", kind: "Int32", txCmd: PacketType.STEPPER_CONFIG_FAST_HOMING_MARGIN},
+
+        {type: "title", label: "Drift Detection"},
+        {key: "stepperConfig.driftCheck", title: "Check On Full Open", type: "trigger", kind: "Boolean", txCmd: PacketType.STEPPER_CONFIG_DRIFT_CHECK},
+        {key: "stepperConfig.driftCorrectionThreshold", title: "Correction Threshold", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_DRIFT_CORRECTION_THRESHOLD},
+        {key: "stepperConfig.driftRehomeThreshold", title: "Re-Homing Threshold", type: "int", kind: "Uint16", txCmd: PacketType.STEPPER_CONFIG_DRIFT_REHOME_THRESHOLD},
 
         {type: "title", label: "Actions", extra: {m_top: true}},
         {key: "apply_stepper_config", type: "button", label: "Apply"},
     ]
+}, {
+    key: "coil_power", section: "Coil Power", collapse: true, props: [
+        {key: "coilPower.holdStrategy", title: "Hold Strategy", type: "select", kind: "Uint8", cmd: PacketType.COIL_POWER_HOLD_STRATEGY, list: "holdStrategy"},
+        {key: "coilPower.holdTime", title: "Hold Time (ms)", type: "int", kind: "Uint16", cmd: PacketType.COIL_POWER_HOLD_TIME},
+        {key: "coilPower.holdDuty", title: "PWM Hold Duty (%)", type: "int", kind: "Uint8", cmd: PacketType.COIL_POWER_HOLD_DUTY},
+        {key: "coilPower.brakeTime", title: "Brake Time (ms)", type: "int", kind: "Uint16", cmd: PacketType.COIL_POWER_BRAKE_TIME},
+
+        {type: "title", label: "Energy Estimation"},
+        {key: "coilPower.coilCurrent", title: "Coil Current (mA)", type: "int", kind: "Uint16", cmd: PacketType.COIL_POWER_COIL_CURRENT},
+        {key: "coilPower.supplyVoltage", title: "Supply Voltage (mV)", type: "int", kind: "Uint16", cmd: PacketType.COIL_POWER_SUPPLY_VOLTAGE},
+        {
+            key: "status.coil_move_energy", type: "label", kind: "Float32",
+            displayConverter: (value) => ["Last Move", `${value.toFixed(2)} J`]
+        },
+        {
+            key: "status.coil_total_energy", type: "label", kind: "Float32",
+            displayConverter: (value) => ["Total", `${value.toFixed(1)} J`]
+        },
+    ]
+}, {
+    key: "endstop", section: "Endstop", collapse: true, props: [
+        {key: "endstop.mode", title: "Mode", type: "select", kind: "Uint8", cmd: PacketType.ENDSTOP_MODE, list: "endstopMode"},
+
+        {type: "title", label: "Analog Levels (mV)"},
+        {key: "endstop.slowdownLevel", title: "Slowdown Level", type: "int", kind: "Uint16", cmd: PacketType.ENDSTOP_SLOWDOWN_LEVEL},
+        {key: "endstop.triggerLevel", title: "Trigger Level", type: "int", kind: "Uint16", cmd: PacketType.ENDSTOP_TRIGGER_LEVEL},
+        {key: "endstop.hysteresis", title: "Hysteresis", type: "int", kind: "Uint16", cmd: PacketType.ENDSTOP_HYSTERESIS},
+
+        {type: "title", label: "Actions", extra: {m_top: true}},
+        {key: "do_endstop_calibrate", type: "button", label: "Calibrate At Home", cmd: PacketType.ENDSTOP_CALIBRATE},
+    ]
+}, {
+    key: "speed_profile", section: "Speed Profile", collapse: true, props: [
+        {key: "speedProfile.enabled", title: "Adaptive Speed", type: "trigger", kind: "Boolean", cmd: PacketType.SPEED_PROFILE_ENABLED},
+        {key: "speedProfile.minFactor", title: "Min Factor (%)", type: "int", kind: "Uint8", cmd: PacketType.SPEED_PROFILE_MIN_FACTOR},
+        {key: "speedProfile.maxFactor", title: "Max Factor (%)", type: "int", kind: "Uint8", cmd: PacketType.SPEED_PROFILE_MAX_FACTOR},
+
+        {type: "title", label: "Learned Factors (%), top to bottom"},
+        {
+            key: "speedProfileState.openSpeed", type: "label",
+            displayConverter: (value) => ["Open Speed", (value ?? []).map((v) => v || "-").join(" ")]
+        },
+        {
+            key: "speedProfileState.closeSpeed", type: "label",
+            displayConverter: (value) => ["Close Speed", (value ?? []).map((v) => v || "-").join(" ")]
+        },
+        {
+            key: "speedProfileState.openAcceleration", type: "label",
+            displayConverter: (value) => ["Open Acceleration", (value ?? []).map((v) => v || "-").join(" ")]
+        },
+        {
+            key: "speedProfileState.closeAcceleration", type: "label",
+            displayConverter: (value) => ["Close Acceleration", (value ?? []).map((v) => v || "-").join(" ")]
+        },
+
+        {type: "title", label: "Actions", extra: {m_top: true}},
+        {key: "do_speed_profile_reset", type: "button", label: "Reset Learned Factors", cmd: PacketType.SPEED_PROFILE_RESET},
+    ]
+}, {
+    key: "scenes", section: "Scenes", collapse: true, props: [
+        {type: "title", label: "Scene 1"},
+        {key: "scenes.0.name", title: "Name", type: "text", kind: "FixedString", maxLength: 16, cmd: PacketType.SCENE_1_NAME},
+        {key: "scenes.0.position", title: "Position (%)", type: "int", kind: "Uint8", cmd: PacketType.SCENE_1_POSITION},
+        {key: "scenes.0.speed", title: "Speed", type: "select", kind: "Uint8", cmd: PacketType.SCENE_1_SPEED, list: "speed"},
+
+        {type: "title", label: "Scene 2", extra: {m_top: true}},
+        {key: "scenes.1.name", title: "Name", type: "text", kind: "FixedString", maxLength: 16, cmd: PacketType.SCENE_2_NAME},
+        {key: "scenes.1.position", title: "Position (%)", type: "int", kind: "Uint8", cmd: PacketType.SCENE_2_POSITION},
+        {key: "scenes.1.speed", title: "Speed", type: "select", kind: "Uint8", cmd: PacketType.SCENE_2_SPEED, list: "speed"},
+
+        {type: "title", label: "Scene 3", extra: {m_top: true}},
+        {key: "scenes.2.name", title: "Name", type: "text", kind: "FixedString", maxLength: 16, cmd: PacketType.SCENE_3_NAME},
+        {key: "scenes.2.position", title: "Position (%)", type: "int", kind: "Uint8", cmd: PacketType.SCENE_3_POSITION},
+        {key: "scenes.2.speed", title: "Speed", type: "select", kind: "Uint8", cmd: PacketType.SCENE_3_SPEED, list: "speed"},
+
+        {type: "title", label: "Scene 4", extra: {m_top: true}},
+        {key: "scenes.3.name", title: "Name", type: "text", kind: "FixedString", maxLength: 16, cmd: PacketType.SCENE_4_NAME},
+        {key: "scenes.3.position", title: "Position (%)", type: "int", kind: "Uint8", cmd: PacketType.SCENE_4_POSITION},
+        {key: "scenes.3.speed", title: "Speed", type: "select", kind: "Uint8", cmd: PacketType.SCENE_4_SPEED, list: "speed"},
+    ]
+}, {
+    key: "sequences", section: "Sequences", collapse: true, props: [
+        {
+            key: "status.sequence", title: "Run", type: "select", kind: "Uint8", cmd: PacketType.RUN_SEQUENCE, list: "sequence",
+            visibleIf: "status.homed"
+        },
+        {
+            key: "status.sequence_step", type: "label", kind: "Uint8", cmd: PacketType.SEQUENCE_STEP,
+            visibleIf: "status.sequence",
+            displayConverter: (value) => ["Step", value]
+        },
+
+        {type: "title", label: "Scripts", extra: {m_top: true}},
+        {key: "sequences.0.script", title: "Sequence 1", type: "text", kind: "FixedString", maxLength: 64, cmd: PacketType.SEQUENCE_1_SCRIPT},
+        {
+            key: "sequences.0.error", type: "label", kind: "Uint8", cmd: PacketType.SEQUENCE_1_ERROR,
+            visibleIf: "sequences.0.error",
+            displayConverter: (value) => ["Syntax Error", value > SEQUENCE_MAX_STEPS ? "Too many steps" : `Step ${value}`]
+        },
+        {key: "sequences.1.script", title: "Sequence 2", type: "text", kind: "FixedString", maxLength: 64, cmd: PacketType.SEQUENCE_2_SCRIPT},
+        {
+            key: "sequences.1.error", type: "label", kind: "Uint8", cmd: PacketType.SEQUENCE_2_ERROR,
+            visibleIf: "sequences.1.error",
+            displayConverter: (value) => ["Syntax Error", value > SEQUENCE_MAX_STEPS ? "Too many steps" : `Step ${value}`]
+        },
+    ]
+}, {
+    key: "group_sync", section: "Group Sync", collapse: true, props: [
+        {key: "groupSync.enabled", title: "Enabled", type: "trigger", kind: "Boolean", cmd: PacketType.GROUP_SYNC_ENABLED},
+        {key: "groupSync.group", title: "Group", type: "int", kind: "Uint8", cmd: PacketType.GROUP_SYNC_GROUP},
+        {key: "groupSync.leader", title: "Leader", type: "trigger", kind: "Boolean", cmd: PacketType.GROUP_SYNC_LEADER},
+        {key: "groupSync.startDelay", title: "Start Delay (ms)", type: "int", kind: "Uint16", cmd: PacketType.GROUP_SYNC_START_DELAY},
+        {
+            key: "groupSyncStatus.offset", type: "label", kind: "Int32",
+            displayConverter: (value) => ["Clock Offset", `${value} ms`]
+        },
+        {
+            key: "groupSyncStatus.rtt", type: "label", kind: "Uint32",
+            displayConverter: (value) => ["Round Trip", `${value} ms`]
+        },
+        {
+            key: "groupSyncStatus.lastMoveLateness", type: "label", kind: "Int32",
+            displayConverter: (value) => ["Last Move Lateness", `${value} ms`]
+        },
+    ]
 }, {
     key: "system", section: "System Settings", collapse: true, props: [
         {key: "sysConfig.mdnsName", title: "mDNS Name", type: "text", kind: "FixedString", maxLength: 32, cmd: PacketType.SYS_CONFIG_MDNS_NAME},
@@ -116,4 +270,52 @@ export const PropertyConfig = [{
         {type: "title", label: "Actions", extra: {m_top: true}},
         {key: "apply_sys_config", type: "button", label: "Apply"},
     ]
+}, {
+    key: "debug", section: "Debug", collapse: true, props: [
+        {
+            key: "profile.window", type: "label", kind: "Uint32",
+            displayConverter: (value) => ["Window", `${(value / 1000).toFixed(0)} s`]
+        },
+        {
+            key: "profile.stall", type: "label", kind: "Uint32",
+            displayConverter: (value) => ["Max Stall", `${value} us`]
+        },
+        {
+            key: "profile.stallSection", type: "label", kind: "Uint8",
+            displayConverter: (value) => ["Stall Source", PROFILE_SECTIONS[value]]
+        },
+
+        {type: "title", label: "Step Timing"},
+        {
+            key: "profile.stepRequested", type: "label", kind: "Float32",
+            displayConverter: (value) => ["Requested Interval", `${value.toFixed(1)} us`]
+        },
+        {
+            key: "profile.stepAchieved", type: "label", kind: "Float32",
+            displayConverter: (value) => ["Achieved Interval", `${value.toFixed(1)} us`]
+        },
+        {
+            key: "profile.stepMaxLateness", type: "label", kind: "Uint32",
+            displayConverter: (value) => ["Max Lateness", `${value} us`]
+        },
+
+        {type: "title", label: "Idle"},
+        {
+            key: "profile.asleepShare", type: "label",
+            displayConverter: (value) => ["Asleep", `${value.toFixed(1)} %`]
+        },
+        {
+            key: "profile.wakeups", type: "label", kind: "Uint32",
+            displayConverter: (value) => ["Wake-ups", value]
+        },
+
+        {type: "title", label: "Sections (avg / max, histogram from 8 us)"},
+        ...PROFILE_SECTIONS.map((name, i) => ({
+            key: `profile.sections.${i}`, type: "label",
+            displayConverter: (value) => [name, `${(value.count ? value.total / value.count : 0).toFixed(1)} / ${value.max} us [${value.histogram.join(" ")}]`]
+        })),
+
+        {type: "title", label: "Actions", extra: {m_top: true}},
+        {key: "do_profile_reset", type: "button", label: "Reset Profile", cmd: PacketType.PROFILE_RESET},
+    ]
 }];
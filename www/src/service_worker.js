@@ -1,11 +1,13 @@
 const CACHE_KEY = "cache";
 
+// ASSET_URLS is defined by the build with fingerprinted names
 const URL_TO_CACHE = [
     "./",
-    "./index.js",
-    "./lib/style.css",
+    ...(typeof ASSET_URLS !== "undefined" ? ASSET_URLS : ["./index.js", "./lib/style.css"]),
 ];
 
+const IMMUTABLE_PATH = "/static/";
+
 self.addEventListener("install", (event) => {
     event.waitUntil(_install());
 });
@@ -24,6 +26,12 @@ async function _install() {
 async function _fetch(event) {
     const cache = await caches.open(CACHE_KEY);
 
+    // Fingerprinted assets never change, so network is not needed once they are cached
+    if (new URL(event.request.url).pathname.startsWith(IMMUTABLE_PATH)) {
+        const cachedResponse = await cache.match(event.request);
+        if (cachedResponse?.ok) return cachedResponse;
+    }
+
     const networkResponse = await _cacheFetch(cache, event.request);
     if (networkResponse?.ok) return networkResponse;
 
@@ -0,0 +1,45 @@
+// Last known device state is kept in Cache Storage next to the app shell,
+// so the interface can be rendered before WebSocket connection is established.
+
+const SNAPSHOT_CACHE_KEY = "snapshot";
+const SNAPSHOT_URL = "./__snapshot.json";
+
+/**
+ * @param {string} gateway
+ * @return {Promise<Object|null>}
+ */
+export async function loadSnapshot(gateway) {
+    if (!("caches" in window)) return null;
+
+    try {
+        const cache = await caches.open(SNAPSHOT_CACHE_KEY);
+        const response = await cache.match(_url(gateway));
+
+        return response ? await response.json() : null;
+    } catch (e) {
+        console.error("Unable to load snapshot", e);
+        return null;
+    }
+}
+
+/**
+ * @param {string} gateway
+ * @param {Object} snapshot
+ */
+export async function saveSnapshot(gateway, snapshot) {
+    if (!("caches" in window)) return;
+
+    try {
+        const cache = await caches.open(SNAPSHOT_CACHE_KEY);
+        await cache.put(_url(gateway), new Response(JSON.stringify(snapshot), {
+            headers: {"Content-Type": "application/json"}
+        }));
+    } catch (e) {
+        console.error("Unable to save snapshot", e);
+    }
+}
+
+function _url(gateway) {
+    // Each device has own snapshot when the same app is used for several hosts
+    return `${SNAPSHOT_URL}?gateway=${encodeURIComponent(gateway)}`;
+}